@@ -0,0 +1,173 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench.c
+ * @brief Entry point and timing helpers of the host benchmarks
+ *
+ * Runs every benchmark, or only the ones named on the command
+ * line (e.g. ./c1m4_bench.out memcopy). Settings such as the
+ * repetition counts of the stream suite come from BENCH_* environment
+ * variables, see bench_env.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 10 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+
+typedef struct
+{
+  const char * name;
+  void (*run)(void);
+} bench_entry_t;
+
+static const bench_entry_t benches[] =
+{
+  { "memcopy", bench_memcopy },
+  { "memmove", bench_memmove },
+  { "memset", bench_memset },
+  { "reverse", bench_reverse },
+  { "pool", bench_pool },
+  { "dispatch", bench_dispatch },
+  { "parallel", bench_parallel },
+  { "dma", bench_dma },
+  { "search", bench_search },
+  { "crc32", bench_crc32 },
+  { "checksum", bench_checksum },
+  { "ringbuf", bench_ringbuf },
+  { "mpmc", bench_mpmc },
+  { "gather", bench_gather },
+  { "stream", bench_stream },
+  { "aligned", bench_aligned },
+  { "stack", bench_stack },
+  { "tcache", bench_tcache },
+  { "remap", bench_remap },
+  { "swap", bench_swap },
+  { "rotate", bench_rotate },
+  { "interleave", bench_interleave },
+  { "copy2d", bench_copy2d },
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+uint64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+size_t bench_reps(size_t length)
+{
+  size_t reps = BENCH_BYTES_PER_RUN / (length ? length : 1);
+
+  return reps ? reps : 1;
+}
+
+uint8_t * bench_buffer(size_t length)
+{
+  void * ptr;
+
+  if(posix_memalign(&ptr, 4096, length ? length : 1))
+  {
+    fprintf(stderr, "bench: cannot allocate %zu bytes\n", length);
+    exit(EXIT_FAILURE);
+  }
+  memset(ptr, 0x5A, length);
+
+  return ptr;
+}
+
+size_t bench_env(const char * name, size_t fallback)
+{
+  const char * text = getenv(name);
+  unsigned long long value;
+  char * end;
+
+  if(!text || !*text)
+  {
+    return fallback;
+  }
+
+  value = strtoull(text, &end, 10);
+  switch(*end)
+  {
+    case 'G': case 'g': value <<= 10; /* fall through */
+    case 'M': case 'm': value <<= 10; /* fall through */
+    case 'K': case 'k': value <<= 10; end++; break;
+    default: break;
+  }
+
+  return (*end || (end == text)) ? fallback : (size_t)value;
+}
+
+double bench_gbps(double bytes, uint64_t ns)
+{
+  return ns ? bytes / (double)ns : 0.0;
+}
+
+int main(int argc, char * argv[])
+{
+  size_t i;
+  int j;
+
+  /* A mistyped name would otherwise run nothing and still succeed */
+  for(j = 1; j < argc; j++)
+  {
+    for(i = 0; i < BENCH_COUNT; i++)
+    {
+      if(strcmp(argv[j], benches[i].name) == 0)
+      {
+        break;
+      }
+    }
+    if(i == BENCH_COUNT)
+    {
+      fprintf(stderr, "unknown benchmark '%s', valid names:", argv[j]);
+      for(i = 0; i < BENCH_COUNT; i++)
+      {
+        fprintf(stderr, " %s", benches[i].name);
+      }
+      fprintf(stderr, "\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  for(i = 0; i < BENCH_COUNT; i++)
+  {
+    if(argc > 1)
+    {
+      for(j = 1; j < argc; j++)
+      {
+        if(strcmp(argv[j], benches[i].name) == 0)
+        {
+          break;
+        }
+      }
+      if(j == argc)
+      {
+        continue;
+      }
+    }
+
+    printf("== %s ==\n", benches[i].name);
+    benches[i].run();
+    printf("\n");
+  }
+
+  return 0;
+}
@@ -0,0 +1,245 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench.h
+ * @brief Host benchmarks for the memory module
+ *
+ * This header file provides the timing helpers shared by the
+ * benchmarks and the entry point of every benchmark. The benchmarks
+ * are only built for the HOST platform (make bench).
+ *
+ * @author Mahmoud Hamdy
+ * @date October 10 2020
+ *
+ */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Bytes moved per measurement, the repetition count is derived from it */
+#define BENCH_BYTES_PER_RUN (64u * 1024u * 1024u)
+
+/**
+ * @brief Reads a monotonic clock
+ * 
+ * @return Current time in nanoseconds
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * @brief Number of repetitions for a given buffer size
+ * 
+ * Repetitions are chosen so that every measurement moves about
+ * BENCH_BYTES_PER_RUN bytes, with at least one repetition.
+ * 
+ * @param length Size of the buffer in bytes
+ * 
+ * @return Number of repetitions
+ */
+size_t bench_reps(size_t length);
+
+/**
+ * @brief Allocates a page aligned, pre-faulted benchmark buffer
+ * 
+ * Exits the benchmark if the allocation fails.
+ * 
+ * @param length Size of the buffer in bytes
+ * 
+ * @return Pointer to the buffer, release it with free()
+ */
+uint8_t * bench_buffer(size_t length);
+
+/**
+ * @brief Reads a numeric benchmark setting from the environment
+ * 
+ * Accepts decimal values with an optional K, M or G suffix (powers
+ * of 1024), e.g. BENCH_MAX_SIZE=64M.
+ * 
+ * @param name Name of the environment variable
+ * @param fallback Value used when the variable is unset or invalid
+ * 
+ * @return Value of the setting
+ */
+size_t bench_env(const char * name, size_t fallback);
+
+/**
+ * @brief Converts bytes and elapsed time to GB/s
+ * 
+ * @param bytes Bytes processed
+ * @param ns Elapsed nanoseconds
+ * 
+ * @return Throughput in GB/s (10^9 bytes per second)
+ */
+double bench_gbps(double bytes, uint64_t ns);
+
+/**
+ * @brief Size sweep of my_memcopy against libc memcpy
+ * 
+ * @return void
+ */
+void bench_memcopy(void);
+
+/**
+ * @brief Overlap check and large-size sweep of my_memmove
+ * 
+ * @return void
+ */
+void bench_memmove(void);
+
+/**
+ * @brief Fill sweep of my_memset with and without streaming stores
+ * 
+ * @return void
+ */
+void bench_memset(void);
+
+/**
+ * @brief Block my_reverse against the pairwise byte swap
+ * 
+ * @return void
+ */
+void bench_reverse(void);
+
+/**
+ * @brief Pool backed reserve_words/free_words against malloc/free
+ * 
+ * @return void
+ */
+void bench_pool(void);
+
+/**
+ * @brief Checks and measures every supported kernel variant
+ * 
+ * @return void
+ */
+void bench_dispatch(void);
+
+/**
+ * @brief Thread scaling of the parallel copy and fill
+ * 
+ * @return void
+ */
+void bench_parallel(void);
+
+/**
+ * @brief Asynchronous chained copies overlapped with computation
+ * 
+ * @return void
+ */
+void bench_dma(void);
+
+/**
+ * @brief my_memcmp, my_memchr and my_memrchr against libc
+ * 
+ * @return void
+ */
+void bench_search(void);
+
+/**
+ * @brief CRC-32 throughput against a bitwise reference
+ * 
+ * @return void
+ */
+void bench_crc32(void);
+
+/**
+ * @brief Fused copy-and-checksum against copy then checksum
+ * 
+ * @return void
+ */
+void bench_checksum(void);
+
+/**
+ * @brief Producer/consumer throughput of the SPSC ring buffer
+ * 
+ * @return void
+ */
+void bench_ringbuf(void);
+
+/**
+ * @brief Throughput and tail latency of the MPMC queue
+ * 
+ * @return void
+ */
+void bench_mpmc(void);
+
+/**
+ * @brief Scatter-gather copies and in-place frame reading
+ * 
+ * @return void
+ */
+void bench_gather(void);
+
+/**
+ * @brief STREAM-style bandwidth suite of the memory module against libc
+ * 
+ * @return void
+ */
+void bench_stream(void);
+
+/**
+ * @brief Alignment and page size effects of reserve_aligned buffers
+ * 
+ * @return void
+ */
+void bench_aligned(void);
+
+/**
+ * @brief Stack painting speed and peak stack use of library calls
+ * 
+ * @return void
+ */
+void bench_stack(void);
+
+/**
+ * @brief Multi-threaded reserve_words/free_words against malloc/free
+ * 
+ * @return void
+ */
+void bench_tcache(void);
+
+/**
+ * @brief my_memzero storing zeros against dropping pages
+ * 
+ * @return void
+ */
+void bench_remap(void);
+
+/**
+ * @brief swap16/32/64_array against an element by element loop
+ * 
+ * @return void
+ */
+void bench_swap(void);
+
+/**
+ * @brief my_rotate against rotating through a reserve_words temporary
+ * 
+ * @return void
+ */
+void bench_rotate(void);
+
+/**
+ * @brief my_deinterleave and my_interleave against nested loops
+ * 
+ * @return void
+ */
+void bench_interleave(void);
+
+/**
+ * @brief my_memcopy2d and the strided copies against row loops
+ * 
+ * @return void
+ */
+void bench_copy2d(void);
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_aligned.c
+ * @brief Alignment and page size effects of reserve_aligned buffers
+ *
+ * First my_memcopy is timed on a 64 MiB buffer straight from malloc,
+ * the same buffer nudged off a cache line, and a reserve_aligned one
+ * on a 64 byte boundary. Then a chain of dependent random 8 byte reads
+ * walks a large buffer (BENCH_TLB_SIZE, default 512 MiB) on normal
+ * pages, transparent huge pages and hugetlbfs pages, which shows how
+ * much of each access goes to TLB misses.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 25 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define ALIGNED_COPY_SIZE ((size_t)64 * 1024 * 1024)
+#define ALIGNED_TLB_SIZE  ((size_t)512 * 1024 * 1024)
+#define ALIGNED_ACCESSES  ((size_t)8 * 1024 * 1024)
+
+static const struct
+{
+  const char * name;
+  uint32_t flags;
+} aligned_pages[] =
+{
+  { "4K pages", MEM_ALIGNED_DEFAULT },
+  { "THP", MEM_ALIGNED_THP },
+  { "hugetlb", MEM_ALIGNED_HUGETLB },
+};
+
+#define ALIGNED_PAGE_COUNT (sizeof(aligned_pages) / sizeof(aligned_pages[0]))
+
+static double aligned_copy(uint8_t * src, uint8_t * dst, size_t length)
+{
+  size_t reps = bench_reps(length), i;
+  uint64_t start;
+
+  my_memcopy(src, dst, length);
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    my_memcopy(src, dst, length);
+  }
+
+  return bench_gbps((double)length * reps, bench_now_ns() - start);
+}
+
+/* Nanoseconds per read; each index depends on the value just loaded */
+static double aligned_walk(const uint64_t * words, size_t count)
+{
+  uint64_t index = 1, sink = 0, start, elapsed;
+  size_t mask = count - 1, i;
+
+  start = bench_now_ns();
+  for(i = 0; i < ALIGNED_ACCESSES; i++)
+  {
+    sink += words[index & mask];
+    index = index * 6364136223846793005ull + 1442695040888963407ull +
+            (sink & 1);
+    index ^= index >> 29;
+  }
+  elapsed = bench_now_ns() - start;
+  if(sink == 1)
+  {
+    printf(" ");
+  }
+
+  return (double)elapsed / ALIGNED_ACCESSES;
+}
+
+static void aligned_thp_mode(void)
+{
+  char line[128] = "unavailable";
+  FILE * f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+
+  if(f)
+  {
+    if(!fgets(line, sizeof(line), f))
+    {
+      strcpy(line, "unreadable");
+    }
+    fclose(f);
+    line[strcspn(line, "\n")] = '\0';
+  }
+  printf("transparent_hugepage/enabled: %s\n", line);
+}
+
+void bench_aligned(void)
+{
+  size_t size = bench_env("BENCH_TLB_SIZE", ALIGNED_TLB_SIZE);
+  uint8_t * heap_src, * heap_dst, * src, * dst, * buf;
+  size_t page, count;
+
+  heap_src = malloc(ALIGNED_COPY_SIZE + 64);
+  heap_dst = malloc(ALIGNED_COPY_SIZE + 64);
+  src = reserve_aligned(ALIGNED_COPY_SIZE, 64, MEM_ALIGNED_DEFAULT);
+  dst = reserve_aligned(ALIGNED_COPY_SIZE, 64, MEM_ALIGNED_DEFAULT);
+  if(!heap_src || !heap_dst || !src || !dst ||
+     ((uintptr_t)src & 63) || ((uintptr_t)dst & 63))
+  {
+    printf("aligned: reservation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  memset(heap_src, 0x5A, ALIGNED_COPY_SIZE + 64);
+  memset(heap_dst, 0, ALIGNED_COPY_SIZE + 64);
+  memset(src, 0x5A, ALIGNED_COPY_SIZE);
+  memset(dst, 0, ALIGNED_COPY_SIZE);
+
+  printf("my_memcopy of %zu bytes (GB/s)\n", ALIGNED_COPY_SIZE);
+  printf("  %-24s %8.2f\n", "malloc",
+         aligned_copy(heap_src, heap_dst, ALIGNED_COPY_SIZE));
+  printf("  %-24s %8.2f\n", "malloc + 8 bytes",
+         aligned_copy(heap_src + 8, heap_dst + 8, ALIGNED_COPY_SIZE));
+  printf("  %-24s %8.2f\n", "reserve_aligned(64)",
+         aligned_copy(src, dst, ALIGNED_COPY_SIZE));
+  free(heap_src);
+  free(heap_dst);
+  free_aligned(src);
+  free_aligned(dst);
+
+  /* Round down to a power of two so the walk can mask its index */
+  for(count = 1; count * 2 <= size / sizeof(uint64_t); count <<= 1)
+  {
+  }
+
+  aligned_thp_mode();
+  printf("random 8 byte reads over %zu bytes\n", count * sizeof(uint64_t));
+  for(page = 0; page < ALIGNED_PAGE_COUNT; page++)
+  {
+    buf = reserve_aligned(count * sizeof(uint64_t), MEM_HUGE_PAGE_SIZE,
+                          aligned_pages[page].flags);
+    if(!buf)
+    {
+      printf("  %-24s %8s\n", aligned_pages[page].name, "failed");
+      continue;
+    }
+    memset(buf, 0, count * sizeof(uint64_t));
+    printf("  %-24s %8.1f ns/read\n", aligned_pages[page].name,
+           aligned_walk((const uint64_t *)buf, count));
+    free_aligned(buf);
+  }
+}
@@ -0,0 +1,160 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_checksum.c
+ * @brief Fused copy-and-checksum against copy then checksum
+ *
+ * Checks my_memcopy_crc32 and my_memcopy_adler32 against the separate
+ * copy and checksum for every short length and offset, then times
+ * both ways for buffers from 4 KiB (cache resident) to 64 MiB
+ * (memory bound, where reading the data once pays off).
+ *
+ * @author Mahmoud Hamdy
+ * @date October 20 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define CHECKSUM_MAX_SIZE   ((size_t)64 * 1024 * 1024)
+#define CHECKSUM_CHECK_SIZE (300)
+
+/* Bytewise Adler-32, straight from RFC 1950 */
+static uint32_t bytewise_adler32(const uint8_t * src, size_t length)
+{
+  uint32_t a = 1, b = 0;
+
+  while(length--)
+  {
+    a = (a + *src++) % 65521u;
+    b = (b + a) % 65521u;
+  }
+
+  return (b << 16) | a;
+}
+
+static void check_fused(uint8_t * src, uint8_t * dst)
+{
+  size_t length, offset;
+  adler32_t adler;
+  crc32_t crc;
+
+  for(offset = 0; offset < 8; offset++)
+  {
+    for(length = 0; length < CHECKSUM_CHECK_SIZE; length++)
+    {
+      memset(dst, 0, CHECKSUM_CHECK_SIZE + 16);
+      crc32_init(&crc);
+      my_memcopy_crc32(src + offset, dst + 1, length, &crc);
+      if((crc32_final(&crc) != crc32(src + offset, length)) ||
+         (memcmp(dst + 1, src + offset, length) != 0) || dst[length + 1])
+      {
+        printf("%zu/%zu my_memcopy_crc32 MISMATCH\n", offset, length);
+        exit(EXIT_FAILURE);
+      }
+
+      memset(dst, 0, CHECKSUM_CHECK_SIZE + 16);
+      adler32_init(&adler);
+      my_memcopy_adler32(src + offset, dst + 3, length, &adler);
+      if((adler32_final(&adler) != bytewise_adler32(src + offset, length)) ||
+         (memcmp(dst + 3, src + offset, length) != 0) || dst[length + 3])
+      {
+        printf("%zu/%zu my_memcopy_adler32 MISMATCH\n", offset, length);
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+}
+
+void bench_checksum(void)
+{
+  uint8_t * src = bench_buffer(CHECKSUM_MAX_SIZE);
+  uint8_t * dst = bench_buffer(CHECKSUM_MAX_SIZE);
+  volatile uint32_t sink = 0;
+  uint64_t start, fused, split;
+  size_t size, reps, i;
+  adler32_t adler;
+  crc32_t crc;
+  int op;
+
+  for(i = 0; i < CHECKSUM_MAX_SIZE; i++)
+  {
+    src[i] = (uint8_t)(i * 31 + (i >> 9));
+  }
+  check_fused(src, dst);
+
+  /* Adler-32 over all-0xFF data, the worst case for the reductions */
+  memset(src + CHECKSUM_MAX_SIZE / 2, 0xFF, 1024 * 1024);
+  adler32_init(&adler);
+  adler32_update(&adler, src + CHECKSUM_MAX_SIZE / 2, 1024 * 1024);
+  if(adler32_final(&adler) !=
+     bytewise_adler32(src + CHECKSUM_MAX_SIZE / 2, 1024 * 1024))
+  {
+    printf("adler32 overflow MISMATCH\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("checksum check: fused copies OK\n");
+
+  printf("%10s %8s %12s %12s %8s\n", "bytes", "sum", "fused GB/s",
+         "2-pass GB/s", "speedup");
+  for(op = 0; op < 2; op++)
+  {
+    for(size = 4096; size <= CHECKSUM_MAX_SIZE; size <<= 2)
+    {
+      reps = bench_reps(size) / 4 + 1;
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        if(op == 0)
+        {
+          crc32_init(&crc);
+          my_memcopy_crc32(src, dst, size, &crc);
+          sink += crc32_final(&crc);
+        }
+        else
+        {
+          adler32_init(&adler);
+          my_memcopy_adler32(src, dst, size, &adler);
+          sink += adler32_final(&adler);
+        }
+      }
+      fused = bench_now_ns() - start;
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        my_memcopy(src, dst, size);
+        if(op == 0)
+        {
+          sink += crc32(dst, size);
+        }
+        else
+        {
+          sink += adler32(dst, size);
+        }
+      }
+      split = bench_now_ns() - start;
+
+      printf("%10zu %8s %12.2f %12.2f %8.2f\n", size,
+             op ? "adler32" : "crc32",
+             bench_gbps((double)size * reps, fused),
+             bench_gbps((double)size * reps, split),
+             fused ? (double)split / (double)fused : 0.0);
+    }
+  }
+
+  (void)sink;
+  free(src);
+  free(dst);
+}
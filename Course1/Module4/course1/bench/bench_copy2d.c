@@ -0,0 +1,241 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_copy2d.c
+ * @brief my_memcopy2d and the strided copies against row loops
+ *
+ * Every supported kernel variant is checked against memcpy per row for
+ * short rows and heights at odd offsets, as are the strided copies and
+ * dma_copy2d_submit. Then full height column tiles of a 64 MiB frame
+ * with a 16 KiB pitch are copied out with my_memcopy2d and with a loop
+ * calling my_memcopy per row, and a 4 byte field is gathered from
+ * 64 byte records, next to a plain loop.
+ *
+ * @author Mahmoud Hamdy
+ * @date November 1 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+#include "dma.h"
+
+#define COPY2D_PITCH       ((size_t)16 * 1024)
+#define COPY2D_ROWS        ((size_t)4096)
+#define COPY2D_FRAME       (COPY2D_PITCH * COPY2D_ROWS)
+#define COPY2D_RECORD      ((size_t)64)
+#define COPY2D_CHECK_W     (72)
+#define COPY2D_CHECK_H     (6)
+#define COPY2D_CHECK_PITCH (COPY2D_CHECK_W + 13)
+
+static const size_t copy2d_widths[] = { 16, 64, 256, 1024, 4096 };
+
+#define COPY2D_WIDTH_COUNT (sizeof(copy2d_widths) / sizeof(copy2d_widths[0]))
+
+static void rows_loop(uint8_t * src, size_t src_pitch, uint8_t * dst,
+                      size_t dst_pitch, size_t width, size_t height)
+{
+  size_t row;
+
+  for(row = 0; row < height; row++)
+  {
+    memcpy(dst + row * dst_pitch, src + row * src_pitch, width);
+  }
+}
+
+static int check_variant(void)
+{
+  static uint8_t src[COPY2D_CHECK_PITCH * COPY2D_CHECK_H + 16];
+  static uint8_t dst[COPY2D_CHECK_PITCH * COPY2D_CHECK_H + 16];
+  static uint8_t ref[COPY2D_CHECK_PITCH * COPY2D_CHECK_H + 16];
+  size_t width, height, i;
+
+  for(i = 0; i < sizeof(src); i++)
+  {
+    src[i] = (uint8_t)(i * 7 + 1);
+  }
+  for(width = 0; width <= COPY2D_CHECK_W; width++)
+  {
+    for(height = 0; height <= COPY2D_CHECK_H; height++)
+    {
+      memset(dst, 0xEE, sizeof(dst));
+      memset(ref, 0xEE, sizeof(ref));
+      my_memcopy2d(src + 1, COPY2D_CHECK_PITCH, dst + 3, width + 5, width,
+                   height);
+      rows_loop(src + 1, COPY2D_CHECK_PITCH, ref + 3, width + 5, width,
+                height);
+      if(memcmp(dst, ref, sizeof(dst)) != 0)
+      {
+        printf("  memcopy2d %zu x %zu MISMATCH\n", width, height);
+        return 0;
+      }
+
+      memset(dst, 0xEE, sizeof(dst));
+      memset(ref, 0xEE, sizeof(ref));
+      my_memcopy2d(src + 2, width, dst + 1, width, width, height);
+      rows_loop(src + 2, width, ref + 1, width, width, height);
+      if(memcmp(dst, ref, sizeof(dst)) != 0)
+      {
+        printf("  memcopy2d packed %zu x %zu MISMATCH\n", width, height);
+        return 0;
+      }
+
+      if(width > 9)
+      {
+        continue;
+      }
+      memset(dst, 0xEE, sizeof(dst));
+      memset(ref, 0xEE, sizeof(ref));
+      my_gather_strided(src + 1, COPY2D_CHECK_W, dst + 1, width, height);
+      rows_loop(src + 1, COPY2D_CHECK_W, ref + 1, width, width, height);
+      my_scatter_strided(src + 3, dst + 100, width + 3, width, height);
+      rows_loop(src + 3, width, ref + 100, width + 3, width, height);
+      if(memcmp(dst, ref, sizeof(dst)) != 0)
+      {
+        printf("  strided %zu x %zu MISMATCH\n", width, height);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+static int check_dma(void)
+{
+  static uint8_t src[COPY2D_CHECK_PITCH * COPY2D_CHECK_H];
+  static uint8_t dst[COPY2D_CHECK_PITCH * COPY2D_CHECK_H];
+  static uint8_t ref[COPY2D_CHECK_PITCH * COPY2D_CHECK_H];
+  dma_desc_t desc[COPY2D_CHECK_H];
+  size_t i;
+
+  for(i = 0; i < sizeof(src); i++)
+  {
+    src[i] = (uint8_t)(i * 5 + 3);
+  }
+  memset(dst, 0xEE, sizeof(dst));
+  memset(ref, 0xEE, sizeof(ref));
+  rows_loop(src + 1, COPY2D_CHECK_PITCH, ref + 2, COPY2D_CHECK_W,
+            COPY2D_CHECK_W - 3, COPY2D_CHECK_H);
+
+  return (dma_copy_wait(dma_copy2d_submit(desc, src + 1, COPY2D_CHECK_PITCH,
+                                          dst + 2, COPY2D_CHECK_W,
+                                          COPY2D_CHECK_W - 3,
+                                          COPY2D_CHECK_H)) ==
+          DMA_COPY_DONE) && (memcmp(dst, ref, sizeof(dst)) == 0);
+}
+
+/* Full height tiles across the frame, one after another */
+static void bench_tiles(uint8_t * frame, uint8_t * tile, size_t width)
+{
+  size_t tiles = COPY2D_PITCH / width, bytes = width * COPY2D_ROWS;
+  size_t reps = bench_reps(COPY2D_FRAME), i, t, row;
+  uint64_t start, mine, loop;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    for(t = 0; t < tiles; t++)
+    {
+      my_memcopy2d(frame + t * width, COPY2D_PITCH, tile, width, width,
+                   COPY2D_ROWS);
+    }
+  }
+  mine = bench_now_ns() - start;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    for(t = 0; t < tiles; t++)
+    {
+      for(row = 0; row < COPY2D_ROWS; row++)
+      {
+        my_memcopy(frame + t * width + row * COPY2D_PITCH,
+                   tile + row * width, width);
+      }
+    }
+  }
+  loop = bench_now_ns() - start;
+
+  printf("%-10s %8zu %10zu %10.2f %10.2f\n", "tile", width, bytes,
+         bench_gbps((double)COPY2D_FRAME * reps, mine),
+         bench_gbps((double)COPY2D_FRAME * reps, loop));
+}
+
+static void bench_field(uint8_t * frame, uint8_t * packed)
+{
+  size_t count = COPY2D_FRAME / COPY2D_RECORD;
+  size_t reps = bench_reps(count * sizeof(uint32_t)), i, e;
+  uint64_t start, mine, loop;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    my_gather_strided(frame + 8, COPY2D_RECORD, packed, sizeof(uint32_t),
+                      count);
+  }
+  mine = bench_now_ns() - start;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    for(e = 0; e < count; e++)
+    {
+      memcpy(packed + e * sizeof(uint32_t),
+             frame + 8 + e * COPY2D_RECORD, sizeof(uint32_t));
+    }
+  }
+  loop = bench_now_ns() - start;
+
+  printf("%-10s %8zu %10zu %10.2f %10.2f\n", "field", sizeof(uint32_t),
+         count * sizeof(uint32_t),
+         bench_gbps((double)count * sizeof(uint32_t) * reps, mine),
+         bench_gbps((double)count * sizeof(uint32_t) * reps, loop));
+}
+
+void bench_copy2d(void)
+{
+  uint8_t * frame = bench_buffer(COPY2D_FRAME);
+  uint8_t * tile = bench_buffer(COPY2D_FRAME / 4);
+  mem_variant_t startup = memory_get_variant();
+  mem_variant_t v;
+  size_t w;
+
+  for(v = MEM_VARIANT_WORD; v < MEM_VARIANT_COUNT; v++)
+  {
+    if(memory_select_variant(v) && !check_variant())
+    {
+      printf("copy2d check failed for %s\n", memory_variant_name(v));
+      exit(EXIT_FAILURE);
+    }
+  }
+  memory_select_variant(startup);
+  if(!check_dma())
+  {
+    printf("copy2d check failed for dma_copy2d_submit\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("copy2d check: rows up to %d bytes, dma OK\n", COPY2D_CHECK_W);
+
+  printf("%-10s %8s %10s %10s %10s  (GB/s)\n", "copy", "width", "bytes",
+         "copy2d", "loop");
+  for(w = 0; w < COPY2D_WIDTH_COUNT; w++)
+  {
+    bench_tiles(frame, tile, copy2d_widths[w]);
+  }
+  bench_field(frame, tile);
+
+  free(frame);
+  free(tile);
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_crc32.c
+ * @brief CRC-32 throughput against a bitwise reference
+ *
+ * Checks the check value, every short length and split updates at
+ * every offset against the bit-at-a-time algorithm, then sweeps
+ * buffer sizes from 16 bytes to 16 MiB.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 19 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "crc32.h"
+
+#define CRC_MAX_SIZE   ((size_t)16 * 1024 * 1024)
+#define CRC_CHECK_SIZE (300)
+
+/* The textbook bit-at-a-time CRC-32 */
+__attribute__((noinline))
+static uint32_t bitwise_crc32(const uint8_t * src, size_t length)
+{
+  uint32_t c = 0xFFFFFFFFu;
+  int k;
+
+  while(length--)
+  {
+    c ^= *src++;
+    for(k = 0; k < 8; k++)
+    {
+      c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+    }
+  }
+
+  return ~c;
+}
+
+void bench_crc32(void)
+{
+  uint8_t * buffer = bench_buffer(CRC_MAX_SIZE);
+  volatile uint32_t sink = 0;
+  size_t size, reps, i, split;
+  uint64_t start, fast, slow;
+  uint32_t expect;
+  crc32_t crc;
+
+  if(crc32((const uint8_t *)"123456789", 9) != CRC32_CHECK)
+  {
+    printf("crc32 check value MISMATCH\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for(i = 0; i < CRC_CHECK_SIZE + 8; i++)
+  {
+    buffer[i] = (uint8_t)(i * 29 + 3);
+  }
+  for(size = 0; size < CRC_CHECK_SIZE; size++)
+  {
+    expect = bitwise_crc32(buffer + 1, size);
+    for(split = 0; split <= size; split++)
+    {
+      crc32_init(&crc);
+      crc32_update(&crc, buffer + 1, split);
+      crc32_update(&crc, buffer + 1 + split, size - split);
+      if(crc32_final(&crc) != expect)
+      {
+        printf("%zu/%zu crc32 MISMATCH\n", size, split);
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  printf("crc32 check: all lengths and splits < %d OK\n", CRC_CHECK_SIZE);
+
+  printf("%10s %12s %12s %8s\n", "bytes", "crc32 GB/s", "bitwise GB/s",
+         "speedup");
+  for(size = 16; size <= CRC_MAX_SIZE; size <<= 2)
+  {
+    reps = bench_reps(size) / 16 + 1;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      sink += crc32(buffer, size);
+    }
+    fast = bench_now_ns() - start;
+
+    /* The bitwise loop is slow, time it on fewer repetitions */
+    start = bench_now_ns();
+    for(i = 0; i < reps / 16 + 1; i++)
+    {
+      sink += bitwise_crc32(buffer, size);
+    }
+    slow = (bench_now_ns() - start) * reps / (reps / 16 + 1);
+
+    printf("%10zu %12.2f %12.2f %8.2f\n", size,
+           bench_gbps((double)size * reps, fast),
+           bench_gbps((double)size * reps, slow),
+           fast ? (double)slow / (double)fast : 0.0);
+  }
+
+  (void)sink;
+  free(buffer);
+}
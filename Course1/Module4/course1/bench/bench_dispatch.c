@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_dispatch.c
+ * @brief Every kernel variant the CPU supports, side by side
+ *
+ * Forces each variant in turn with memory_select_variant, checks it
+ * against libc on every length below a few blocks and then measures
+ * copy, move, set and reverse at an L1, L2 and DRAM sized buffer.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 14 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define DISPATCH_CHECK_SIZE (600)
+
+static int check_variant(void)
+{
+  uint8_t a[DISPATCH_CHECK_SIZE + 8], b[DISPATCH_CHECK_SIZE + 8];
+  size_t length, i;
+
+  for(length = 0; length < DISPATCH_CHECK_SIZE; length++)
+  {
+    for(i = 0; i < sizeof(a); i++)
+    {
+      a[i] = b[i] = (uint8_t)(i * 5 + length);
+    }
+    my_memmove(a + 1, a + 7, length);
+    memmove(b + 7, b + 1, length);
+    my_memmove(a + 6, a + 3, length);
+    memmove(b + 3, b + 6, length);
+    my_memset(a + 2, length, (uint8_t)length);
+    memset(b + 2, (int)(uint8_t)length, length);
+    my_reverse(a + 5, length);
+    for(i = 0; i < length / 2; i++)
+    {
+      uint8_t t = b[5 + i];
+      b[5 + i] = b[5 + length - 1 - i];
+      b[5 + length - 1 - i] = t;
+    }
+    if(memcmp(a, b, sizeof(a)) != 0)
+    {
+      printf("  length %zu MISMATCH\n", length);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static double time_op(int op, uint8_t * src, uint8_t * dst, size_t size)
+{
+  size_t reps = bench_reps(size), i;
+  uint64_t start = bench_now_ns();
+
+  for(i = 0; i < reps; i++)
+  {
+    switch(op)
+    {
+      case 0:  my_memcopy(src, dst, size); break;
+      case 1:  my_memmove(src, src + 64, size); break;
+      case 2:  my_memset(dst, size, (uint8_t)i); break;
+      default: my_reverse(dst, size); break;
+    }
+  }
+
+  return bench_gbps((double)size * reps, bench_now_ns() - start);
+}
+
+void bench_dispatch(void)
+{
+  static const size_t sizes[] = { 16 * 1024, 256 * 1024, 32 * 1024 * 1024 };
+  mem_variant_t startup = memory_get_variant();
+  uint8_t * src = bench_buffer(sizes[2] + 64);
+  uint8_t * dst = bench_buffer(sizes[2]);
+  mem_variant_t v;
+  size_t s;
+
+  printf("selected at startup: %s\n", memory_variant_name(startup));
+  printf("%8s %10s %10s %10s %10s %10s\n", "variant", "bytes",
+         "copy GB/s", "move GB/s", "set GB/s", "rev GB/s");
+  for(v = MEM_VARIANT_WORD; v < MEM_VARIANT_COUNT; v++)
+  {
+    if(!memory_select_variant(v))
+    {
+      printf("%8s not supported by this CPU\n", memory_variant_name(v));
+      continue;
+    }
+    if(!check_variant())
+    {
+      exit(EXIT_FAILURE);
+    }
+    for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+      printf("%8s %10zu %10.2f %10.2f %10.2f %10.2f\n",
+             memory_variant_name(v), sizes[s],
+             time_op(0, src, dst, sizes[s]), time_op(1, src, dst, sizes[s]),
+             time_op(2, src, dst, sizes[s]), time_op(3, src, dst, sizes[s]));
+    }
+  }
+
+  memory_select_variant(startup);
+  free(src);
+  free(dst);
+}
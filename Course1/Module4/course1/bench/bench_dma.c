@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_dma.c
+ * @brief Overlapping computation with asynchronous chained copies
+ *
+ * Submits a chain of four copies, sums a separate array while they
+ * run and waits for them, against doing the same copies with
+ * my_memcopy followed by the sum. Every copy is checked afterwards.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 18 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+#include "dma.h"
+
+#define DMA_BENCH_PART   ((size_t)16 * 1024 * 1024)
+#define DMA_BENCH_PARTS  (4)
+#define DMA_BENCH_WORK   ((size_t)32 * 1024 * 1024)
+#define DMA_BENCH_ROUNDS (4)
+
+static uint64_t compute(const uint8_t * work)
+{
+  uint64_t sum = 0;
+  size_t i;
+
+  for(i = 0; i < DMA_BENCH_WORK; i++)
+  {
+    sum += (uint64_t)work[i] * (i | 1);
+  }
+
+  return sum;
+}
+
+void bench_dma(void)
+{
+  uint8_t * src = bench_buffer(DMA_BENCH_PART * DMA_BENCH_PARTS);
+  uint8_t * dst = bench_buffer(DMA_BENCH_PART * DMA_BENCH_PARTS);
+  uint8_t * work = bench_buffer(DMA_BENCH_WORK);
+  dma_desc_t desc[DMA_BENCH_PARTS];
+  volatile uint64_t sink = 0;
+  uint64_t start, serial, async, submit_ns = 0;
+  dma_handle_t handle;
+  size_t i, r;
+
+  for(i = 0; i < DMA_BENCH_PART * DMA_BENCH_PARTS; i++)
+  {
+    src[i] = (uint8_t)(i * 11);
+  }
+
+  /* Parts in reverse order, each one shorter by its index */
+  for(i = 0; i < DMA_BENCH_PARTS; i++)
+  {
+    desc[i].src = src + i * DMA_BENCH_PART;
+    desc[i].dst = dst + (DMA_BENCH_PARTS - 1 - i) * DMA_BENCH_PART + i;
+    desc[i].length = DMA_BENCH_PART - 2 * i;
+    desc[i].next = (i + 1 < DMA_BENCH_PARTS) ? &desc[i + 1] : NULL;
+  }
+
+  start = bench_now_ns();
+  for(r = 0; r < DMA_BENCH_ROUNDS; r++)
+  {
+    for(i = 0; i < DMA_BENCH_PARTS; i++)
+    {
+      my_memcopy((uint8_t *)desc[i].src, desc[i].dst, desc[i].length);
+    }
+    sink = compute(work);
+  }
+  serial = bench_now_ns() - start;
+
+  memset(dst, 0, DMA_BENCH_PART * DMA_BENCH_PARTS);
+  dma_init();
+  start = bench_now_ns();
+  for(r = 0; r < DMA_BENCH_ROUNDS; r++)
+  {
+    uint64_t t = bench_now_ns();
+    handle = dma_copy_submit(desc);
+    submit_ns += bench_now_ns() - t;
+    sink = compute(work);
+    if(dma_copy_wait(handle) != DMA_COPY_DONE)
+    {
+      printf("wait failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  async = bench_now_ns() - start;
+  (void)sink;
+
+  for(i = 0; i < DMA_BENCH_PARTS; i++)
+  {
+    if(memcmp(desc[i].src, desc[i].dst, desc[i].length) != 0)
+    {
+      printf("part %zu MISMATCH\n", i);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if(dma_copy_poll(handle + 1) != DMA_COPY_INVALID)
+  {
+    printf("poll of an unsubmitted handle did not fail\n");
+    exit(EXIT_FAILURE);
+  }
+
+  printf("%zu rounds of %d x %zu MiB copies + %zu MiB of compute\n",
+         (size_t)DMA_BENCH_ROUNDS, DMA_BENCH_PARTS, DMA_BENCH_PART >> 20,
+         DMA_BENCH_WORK >> 20);
+  printf("  blocking copy then compute: %8.2f ms\n", serial / 1e6);
+  printf("  async copy during compute:  %8.2f ms\n", async / 1e6);
+  printf("  submit latency:             %8.2f us\n",
+         submit_ns / 1e3 / DMA_BENCH_ROUNDS);
+
+  dma_shutdown();
+  free(src);
+  free(dst);
+  free(work);
+}
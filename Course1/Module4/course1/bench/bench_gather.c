@@ -0,0 +1,193 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_gather.c
+ * @brief Scatter-gather copies and in-place frame reading
+ *
+ * Checks my_gather, my_scatter, my_memcopy_v and the segment cursor
+ * against flat copies for many ways of splitting a buffer. Then, for
+ * a header/payload/trailer frame, times assembly with my_gather
+ * against separate my_memcopy calls, and checksumming the frame in
+ * place through a cursor against flattening it first.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 23 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define GATHER_CHECK_SIZE (1000)
+#define GATHER_MAX_SEGS   (16)
+#define GATHER_HEADER     (14)
+#define GATHER_TRAILER    (4)
+#define GATHER_MAX_SIZE   ((size_t)64 * 1024)
+
+/* Cuts length bytes at base into up to GATHER_MAX_SEGS random pieces */
+static size_t split(uint8_t * base, size_t length, mem_seg_t * segs)
+{
+  size_t count = 0, piece;
+
+  while(length && (count < GATHER_MAX_SEGS - 1))
+  {
+    piece = (size_t)rand() % (length + 1);
+    segs[count].ptr = base;
+    segs[count++].length = piece;
+    base += piece;
+    length -= piece;
+  }
+  segs[count].ptr = base;
+  segs[count++].length = length;
+
+  return count;
+}
+
+static void check_segments(void)
+{
+  uint8_t src[GATHER_CHECK_SIZE], dst[GATHER_CHECK_SIZE + 1];
+  mem_seg_t a[GATHER_MAX_SEGS], b[GATHER_MAX_SEGS];
+  size_t length, na, nb, i, n;
+  mem_cursor_t cursor;
+  int round;
+
+  for(i = 0; i < GATHER_CHECK_SIZE; i++)
+  {
+    src[i] = (uint8_t)(i * 11 + 5);
+  }
+
+  srand(1);
+  for(round = 0; round < 20000; round++)
+  {
+    length = (size_t)rand() % GATHER_CHECK_SIZE;
+    na = split(src, length, a);
+    nb = split(dst, length, b);
+    memset(dst, 0, sizeof(dst));
+
+    if((mem_seg_total(a, na) != length) ||
+       (my_memcopy_v(a, na, b, nb) != length) ||
+       (memcmp(src, dst, length) != 0) || dst[length])
+    {
+      printf("%zu my_memcopy_v MISMATCH\n", length);
+      exit(EXIT_FAILURE);
+    }
+
+    memset(dst, 0, sizeof(dst));
+    if((my_gather(a, na, dst) != length) || (memcmp(src, dst, length) != 0))
+    {
+      printf("%zu my_gather MISMATCH\n", length);
+      exit(EXIT_FAILURE);
+    }
+
+    memset(dst, 0, sizeof(dst));
+    if((my_scatter(src, b, nb) != length) || (memcmp(src, dst, length) != 0))
+    {
+      printf("%zu my_scatter MISMATCH\n", length);
+      exit(EXIT_FAILURE);
+    }
+
+    /* Read back in random sized fields, peeking where possible */
+    memset(dst, 0, sizeof(dst));
+    mem_cursor_init(&cursor, a, na);
+    for(i = 0; i < length; i += n)
+    {
+      n = (size_t)rand() % 40 + 1;
+      if(mem_cursor_peek(&cursor, n) &&
+         (memcmp(mem_cursor_peek(&cursor, n), src + i, n) != 0))
+      {
+        break;
+      }
+      n = mem_cursor_read(&cursor, dst + i, n);
+    }
+    if((memcmp(src, dst, length) != 0) || mem_cursor_read(&cursor, dst, 1))
+    {
+      printf("%zu mem_cursor_read MISMATCH\n", length);
+      exit(EXIT_FAILURE);
+    }
+  }
+  printf("segment check: 20000 random splits OK\n");
+}
+
+void bench_gather(void)
+{
+  uint8_t header[GATHER_HEADER], trailer[GATHER_TRAILER];
+  uint8_t * payload = bench_buffer(GATHER_MAX_SIZE);
+  uint8_t * frame = bench_buffer(GATHER_MAX_SIZE + 64);
+  uint64_t start, t_gather, t_copies, t_cursor, t_flat;
+  volatile uint32_t sink = 0;
+  size_t size, reps, i, span;
+  mem_cursor_t cursor;
+  mem_seg_t segs[3];
+  uint8_t * piece;
+  crc32_t crc;
+
+  check_segments();
+
+  memset(header, 0xA5, sizeof(header));
+  memset(trailer, 0x5A, sizeof(trailer));
+  printf("%10s %12s %12s %12s %12s  (ns/frame)\n", "payload", "gather",
+         "3x memcopy", "crc cursor", "crc flat");
+  for(size = 64; size <= GATHER_MAX_SIZE; size <<= 2)
+  {
+    reps = bench_reps(size);
+    segs[0].ptr = header;
+    segs[0].length = sizeof(header);
+    segs[1].ptr = payload;
+    segs[1].length = size;
+    segs[2].ptr = trailer;
+    segs[2].length = sizeof(trailer);
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      my_gather(segs, 3, frame);
+    }
+    t_gather = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      my_memcopy(header, frame, sizeof(header));
+      my_memcopy(payload, frame + sizeof(header), size);
+      my_memcopy(trailer, frame + sizeof(header) + size, sizeof(trailer));
+    }
+    t_copies = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      crc32_init(&crc);
+      mem_cursor_init(&cursor, segs, 3);
+      while((piece = mem_cursor_next(&cursor, (size_t)-1, &span)))
+      {
+        crc32_update(&crc, piece, span);
+      }
+      sink += crc32_final(&crc);
+    }
+    t_cursor = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      sink += crc32(frame, my_gather(segs, 3, frame));
+    }
+    t_flat = bench_now_ns() - start;
+
+    printf("%10zu %12.1f %12.1f %12.1f %12.1f\n", size,
+           (double)t_gather / reps, (double)t_copies / reps,
+           (double)t_cursor / reps, (double)t_flat / reps);
+  }
+
+  (void)sink;
+  free(payload);
+  free(frame);
+}
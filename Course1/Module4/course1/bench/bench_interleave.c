@@ -0,0 +1,248 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_interleave.c
+ * @brief my_deinterleave and my_interleave against nested loops
+ *
+ * Every supported kernel variant is checked against a plain loop for
+ * 1 to 6 channels of 1 to 4 byte samples and all short frame counts,
+ * with the buffers at odd offsets. Then each kernel layout and a six
+ * channel one are timed both ways on a cache resident block and on
+ * 64 MiB, next to the frame by frame loop a caller would write.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 31 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define ILV_SMALL_SIZE   ((size_t)64 * 1024)
+#define ILV_LARGE_SIZE   ((size_t)64 * 1024 * 1024)
+#define ILV_MAX_CHANNELS (6)
+#define ILV_CHECK_FRAMES (100)
+
+static const size_t ilv_widths[] = { 1, 2, 4 };
+static const size_t ilv_channels[] = { 2, 3, 4, 6 };
+
+#define ILV_WIDTH_COUNT   (sizeof(ilv_widths) / sizeof(ilv_widths[0]))
+#define ILV_CHANNEL_COUNT (sizeof(ilv_channels) / sizeof(ilv_channels[0]))
+
+/* Reference for the checks, any width */
+static void split_loop(const uint8_t * src, uint8_t * const * dst,
+                       size_t channels, size_t frames, size_t width)
+{
+  size_t f, c;
+
+  for(f = 0; f < frames; f++)
+  {
+    for(c = 0; c < channels; c++)
+    {
+      memcpy(dst[c] + f * width, src + (f * channels + c) * width, width);
+    }
+  }
+}
+
+/* The loops a caller would write for each sample type, timed */
+static void split_typed(const uint8_t * src, uint8_t * const * dst,
+                        size_t channels, size_t frames, size_t width)
+{
+  size_t f, c;
+
+  for(f = 0; f < frames; f++)
+  {
+    for(c = 0; c < channels; c++)
+    {
+      if(width == 1)
+      {
+        dst[c][f] = src[f * channels + c];
+      }
+      else if(width == 2)
+      {
+        ((uint16_t *)dst[c])[f] = ((const uint16_t *)src)[f * channels + c];
+      }
+      else
+      {
+        ((int32_t *)dst[c])[f] = ((const int32_t *)src)[f * channels + c];
+      }
+    }
+  }
+}
+
+static void merge_typed(uint8_t * const * src, uint8_t * dst,
+                        size_t channels, size_t frames, size_t width)
+{
+  size_t f, c;
+
+  for(f = 0; f < frames; f++)
+  {
+    for(c = 0; c < channels; c++)
+    {
+      if(width == 1)
+      {
+        dst[f * channels + c] = src[c][f];
+      }
+      else if(width == 2)
+      {
+        ((uint16_t *)dst)[f * channels + c] = ((const uint16_t *)src[c])[f];
+      }
+      else
+      {
+        ((int32_t *)dst)[f * channels + c] = ((const int32_t *)src[c])[f];
+      }
+    }
+  }
+}
+
+/* Splits each layout, compares it with the loop, then merges it back */
+static int check_variant(void)
+{
+  static uint8_t src[ILV_CHECK_FRAMES * ILV_MAX_CHANNELS * 4 + 16];
+  static uint8_t dst[ILV_CHECK_FRAMES * ILV_MAX_CHANNELS * 4 + 16];
+  static uint8_t out[ILV_MAX_CHANNELS][ILV_CHECK_FRAMES * 4 + 16];
+  static uint8_t ref[ILV_MAX_CHANNELS][ILV_CHECK_FRAMES * 4 + 16];
+  uint8_t * chans[ILV_MAX_CHANNELS], * refs[ILV_MAX_CHANNELS];
+  size_t channels, width, frames, c, i;
+
+  for(i = 0; i < sizeof(src); i++)
+  {
+    src[i] = (uint8_t)(i * 7 + 1);
+  }
+  for(c = 0; c < ILV_MAX_CHANNELS; c++)
+  {
+    chans[c] = out[c] + 1 + c;
+    refs[c] = ref[c] + 1 + c;
+  }
+
+  for(channels = 1; channels <= ILV_MAX_CHANNELS; channels++)
+  {
+    for(width = 1; width <= 4; width++)
+    {
+      for(frames = 0; frames <= ILV_CHECK_FRAMES; frames++)
+      {
+        memset(out, 0xEE, sizeof(out));
+        memset(ref, 0xEE, sizeof(ref));
+        my_deinterleave(src + 3, chans, channels, frames, width);
+        split_loop(src + 3, refs, channels, frames, width);
+        if(memcmp(out, ref, sizeof(out)) != 0)
+        {
+          printf("  split %zu x %zu frames %zu MISMATCH\n", channels,
+                 width, frames);
+          return 0;
+        }
+
+        memset(dst, 0xEE, sizeof(dst));
+        my_interleave(chans, dst + 5, channels, frames, width);
+        if((memcmp(dst + 5, src + 3, frames * channels * width) != 0) ||
+           (dst[4] != 0xEE) || (dst[5 + frames * channels * width] != 0xEE))
+        {
+          printf("  merge %zu x %zu frames %zu MISMATCH\n", channels,
+                 width, frames);
+          return 0;
+        }
+      }
+    }
+  }
+
+  return 1;
+}
+
+static void bench_layout(uint8_t * src, uint8_t * const * chans,
+                         size_t size, size_t channels, size_t width)
+{
+  size_t frames = size / (channels * width);
+  size_t reps = bench_reps(size), i;
+  uint64_t start, split, split_ref, merge, merge_ref;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    my_deinterleave(src, chans, channels, frames, width);
+  }
+  split = bench_now_ns() - start;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    split_typed(src, chans, channels, frames, width);
+  }
+  split_ref = bench_now_ns() - start;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    my_interleave(chans, src, channels, frames, width);
+  }
+  merge = bench_now_ns() - start;
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    merge_typed(chans, src, channels, frames, width);
+  }
+  merge_ref = bench_now_ns() - start;
+
+  printf("%4zu x %-2zu %10zu %10.2f %10.2f %10.2f %10.2f\n", channels,
+         width, size, bench_gbps((double)size * reps, split),
+         bench_gbps((double)size * reps, split_ref),
+         bench_gbps((double)size * reps, merge),
+         bench_gbps((double)size * reps, merge_ref));
+}
+
+void bench_interleave(void)
+{
+  uint8_t * src = bench_buffer(ILV_LARGE_SIZE);
+  uint8_t * chans[ILV_MAX_CHANNELS];
+  mem_variant_t startup = memory_get_variant();
+  size_t w, c, size;
+  mem_variant_t v;
+
+  for(v = MEM_VARIANT_WORD; v < MEM_VARIANT_COUNT; v++)
+  {
+    if(memory_select_variant(v) && !check_variant())
+    {
+      printf("interleave check failed for %s\n", memory_variant_name(v));
+      exit(EXIT_FAILURE);
+    }
+  }
+  memory_select_variant(startup);
+  printf("interleave check: up to %d channels, %d frames OK\n",
+         ILV_MAX_CHANNELS, ILV_CHECK_FRAMES);
+
+  for(c = 0; c < ILV_MAX_CHANNELS; c++)
+  {
+    chans[c] = bench_buffer(ILV_LARGE_SIZE / 2);
+  }
+
+  printf("%-9s %10s %10s %10s %10s %10s  (GB/s, %s)\n", "layout", "bytes",
+         "split", "loop", "merge", "loop",
+         memory_variant_name(memory_get_variant()));
+  for(size = ILV_SMALL_SIZE; size <= ILV_LARGE_SIZE; size <<= 10)
+  {
+    for(c = 0; c < ILV_CHANNEL_COUNT; c++)
+    {
+      for(w = 0; w < ILV_WIDTH_COUNT; w++)
+      {
+        bench_layout(src, chans, size, ilv_channels[c], ilv_widths[w]);
+      }
+    }
+  }
+
+  free(src);
+  for(c = 0; c < ILV_MAX_CHANNELS; c++)
+  {
+    free(chans[c]);
+  }
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_memcopy.c
+ * @brief Size sweep of my_memcopy against libc memcpy
+ *
+ * Copies between two page aligned buffers, offset by one byte on the
+ * source side so the head/body/tail split is exercised, for every
+ * power of two from 1 byte to 64 MiB. Sizes where my_memcopy reaches
+ * less than MEMCOPY_MIN_RATIO of the libc rate are flagged with LOW
+ * and counted at the end.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 10 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define MEMCOPY_MAX_SIZE ((size_t)64 * 1024 * 1024)
+
+/* Lowest my/libc throughput ratio accepted at any size */
+#define MEMCOPY_MIN_RATIO (0.5)
+
+void bench_memcopy(void)
+{
+  uint8_t * src = bench_buffer(MEMCOPY_MAX_SIZE + 1);
+  uint8_t * dst = bench_buffer(MEMCOPY_MAX_SIZE);
+  size_t size, reps, i, low = 0;
+  uint64_t start, mine, libc;
+  double ratio;
+
+  for(i = 0; i <= MEMCOPY_MAX_SIZE; i++)
+  {
+    src[i] = (uint8_t)(i * 31);
+  }
+
+  printf("%10s %12s %12s %8s\n", "bytes", "my GB/s", "libc GB/s", "ratio");
+  for(size = 1; size <= MEMCOPY_MAX_SIZE; size <<= 1)
+  {
+    reps = bench_reps(size);
+
+    memset(dst, 0, size);
+    my_memcopy(src + 1, dst, size);
+    if(memcmp(src + 1, dst, size) != 0)
+    {
+      printf("%10zu my_memcopy MISMATCH\n", size);
+      exit(EXIT_FAILURE);
+    }
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      my_memcopy(src + 1, dst, size);
+    }
+    mine = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      memcpy(dst, src + 1, size);
+    }
+    libc = bench_now_ns() - start;
+
+    ratio = mine ? (double)libc / (double)mine : 0.0;
+    if(ratio < MEMCOPY_MIN_RATIO)
+    {
+      low++;
+    }
+    printf("%10zu %12.2f %12.2f %8.2f%s\n", size,
+           bench_gbps((double)size * reps, mine),
+           bench_gbps((double)size * reps, libc),
+           ratio, (ratio < MEMCOPY_MIN_RATIO) ? "  LOW" : "");
+  }
+  printf("%zu sizes below a %.2f ratio to libc\n", low, MEMCOPY_MIN_RATIO);
+
+  free(src);
+  free(dst);
+}
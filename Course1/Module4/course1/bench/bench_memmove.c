@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_memmove.c
+ * @brief Overlapping my_memmove against libc memmove
+ *
+ * First checks every small length and distance (both directions)
+ * against libc memmove, then sweeps large in-place shifts up and down
+ * by a short and a long distance.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 10 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define MEMMOVE_MAX_SIZE   ((size_t)64 * 1024 * 1024)
+#define MEMMOVE_CHECK_SIZE (300)
+
+static void fill(uint8_t * ptr, size_t length)
+{
+  size_t i;
+  for(i = 0; i < length; i++)
+  {
+    ptr[i] = (uint8_t)(i * 7 + 3);
+  }
+}
+
+static int check_overlaps(void)
+{
+  uint8_t mine[2 * MEMMOVE_CHECK_SIZE];
+  uint8_t libc[2 * MEMMOVE_CHECK_SIZE];
+  size_t length, dist;
+
+  for(length = 0; length < MEMMOVE_CHECK_SIZE; length++)
+  {
+    for(dist = 1; dist < MEMMOVE_CHECK_SIZE; dist++)
+    {
+      fill(mine, sizeof(mine));
+      fill(libc, sizeof(libc));
+      my_memmove(mine + dist, mine + 1, length);
+      memmove(libc + 1, libc + dist, length);
+      if(memcmp(mine, libc, sizeof(mine)) != 0)
+      {
+        printf("down: length %zu distance %zu MISMATCH\n", length, dist - 1);
+        return 0;
+      }
+
+      fill(mine, sizeof(mine));
+      fill(libc, sizeof(libc));
+      my_memmove(mine + 1, mine + dist, length);
+      memmove(libc + dist, libc + 1, length);
+      if(memcmp(mine, libc, sizeof(mine)) != 0)
+      {
+        printf("up: length %zu distance %zu MISMATCH\n", length, dist - 1);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+static uint64_t time_move(uint8_t * buf, size_t size, size_t dist,
+                          int up, int use_libc)
+{
+  size_t reps = bench_reps(size), i;
+  uint8_t * src = up ? buf : buf + dist;
+  uint8_t * dst = up ? buf + dist : buf;
+  uint64_t start = bench_now_ns();
+
+  for(i = 0; i < reps; i++)
+  {
+    if(use_libc)
+    {
+      memmove(dst, src, size);
+    }
+    else
+    {
+      my_memmove(src, dst, size);
+    }
+  }
+
+  return bench_now_ns() - start;
+}
+
+void bench_memmove(void)
+{
+  static const size_t dists[] = { 3, 4099 };
+  uint8_t * buf = bench_buffer(MEMMOVE_MAX_SIZE + 8192);
+  size_t size, d;
+  int up;
+
+  if(!check_overlaps())
+  {
+    exit(EXIT_FAILURE);
+  }
+  printf("overlap check: all lengths < %d, all distances OK\n",
+         MEMMOVE_CHECK_SIZE);
+
+  printf("%10s %6s %4s %12s %12s %8s\n",
+         "bytes", "dist", "dir", "my GB/s", "libc GB/s", "ratio");
+  for(size = 1024; size <= MEMMOVE_MAX_SIZE; size <<= 2)
+  {
+    for(d = 0; d < sizeof(dists) / sizeof(dists[0]); d++)
+    {
+      for(up = 0; up <= 1; up++)
+      {
+        double bytes = (double)size * bench_reps(size);
+        uint64_t mine = time_move(buf, size, dists[d], up, 0);
+        uint64_t libc = time_move(buf, size, dists[d], up, 1);
+
+        printf("%10zu %6zu %4s %12.2f %12.2f %8.2f\n", size, dists[d],
+               up ? "up" : "down", bench_gbps(bytes, mine),
+               bench_gbps(bytes, libc),
+               mine ? (double)libc / (double)mine : 0.0);
+      }
+    }
+  }
+
+  free(buf);
+}
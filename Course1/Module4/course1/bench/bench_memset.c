@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_memset.c
+ * @brief Broadcast my_memset against the old byte loop and libc memset
+ *
+ * Sweeps fill sizes with streaming stores forced off and forced on,
+ * then measures how long a small hot working set takes to re-read
+ * after a large clear in each mode.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 10 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define MEMSET_MAX_SIZE  ((size_t)256 * 1024 * 1024)
+#define MEMSET_HOT_SIZE  ((size_t)512 * 1024)
+#define MEMSET_HOT_CLEAR ((size_t)64 * 1024 * 1024)
+
+/* The loop my_memset used to be, kept from turning into a memset call */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns",
+                                  "no-tree-vectorize")))
+static void byte_loop(uint8_t * src, size_t length, uint8_t value)
+{
+  size_t i;
+  for(i = 0; i < length; i++)
+  {
+    src[i] = value;
+  }
+}
+
+static uint64_t time_fill(uint8_t * buf, size_t size, int mode)
+{
+  size_t reps = bench_reps(size), i;
+  uint64_t start = bench_now_ns();
+
+  for(i = 0; i < reps; i++)
+  {
+    switch(mode)
+    {
+      case 0:  byte_loop(buf, size, (uint8_t)i); break;
+      case 1:  my_memset(buf, size, (uint8_t)i); break;
+      default: memset(buf, (int)(uint8_t)i, size); break;
+    }
+  }
+
+  return bench_now_ns() - start;
+}
+
+static uint64_t time_hot_reread(uint8_t * hot, uint8_t * big)
+{
+  volatile uint64_t sink = 0;
+  uint64_t sum = 0, start;
+  size_t i;
+
+  for(i = 0; i < MEMSET_HOT_SIZE; i += 64)
+  {
+    sum += hot[i];
+  }
+  my_memzero(big, MEMSET_HOT_CLEAR);
+
+  start = bench_now_ns();
+  for(i = 0; i < MEMSET_HOT_SIZE; i += 64)
+  {
+    sum += hot[i];
+  }
+  sink = sum;
+  (void)sink;
+
+  return bench_now_ns() - start;
+}
+
+void bench_memset(void)
+{
+  uint8_t * buf = bench_buffer(MEMSET_MAX_SIZE);
+  uint8_t * hot = bench_buffer(MEMSET_HOT_SIZE);
+  size_t saved = my_memset_get_nt_threshold();
+  size_t size;
+
+  printf("default streaming threshold: %zu bytes\n", saved);
+  printf("%10s %12s %12s %12s %12s\n",
+         "bytes", "byte GB/s", "temp GB/s", "nt GB/s", "libc GB/s");
+  for(size = 64; size <= MEMSET_MAX_SIZE; size <<= 2)
+  {
+    double bytes = (double)size * bench_reps(size);
+    uint64_t byte, temporal, stream, libc;
+
+    byte = time_fill(buf, size, 0);
+    my_memset_set_nt_threshold(MEMSET_NT_DISABLED);
+    temporal = time_fill(buf, size, 1);
+    my_memset_set_nt_threshold(0);
+    stream = time_fill(buf, size, 1);
+    libc = time_fill(buf, size, 2);
+
+    printf("%10zu %12.2f %12.2f %12.2f %12.2f\n", size,
+           bench_gbps(bytes, byte), bench_gbps(bytes, temporal),
+           bench_gbps(bytes, stream), bench_gbps(bytes, libc));
+  }
+
+  my_memset_set_nt_threshold(MEMSET_NT_DISABLED);
+  printf("hot %zu KiB re-read after %zu MiB clear, temporal: %llu ns\n",
+         MEMSET_HOT_SIZE >> 10, MEMSET_HOT_CLEAR >> 20,
+         (unsigned long long)time_hot_reread(hot, buf));
+  my_memset_set_nt_threshold(0);
+  printf("hot %zu KiB re-read after %zu MiB clear, streaming: %llu ns\n",
+         MEMSET_HOT_SIZE >> 10, MEMSET_HOT_CLEAR >> 20,
+         (unsigned long long)time_hot_reread(hot, buf));
+
+  my_memset_set_nt_threshold(saved);
+  free(hot);
+  free(buf);
+}
@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_mpmc.c
+ * @brief Throughput and latency of the MPMC queue
+ *
+ * N producers push time-stamped 64-byte slots through a 1024-slot
+ * queue to N consumers, for N = 1, 2, 4 and 8. Every consumer checks
+ * that the slots of each producer arrive in order and records the
+ * push-to-pop latency. A thread that finds the queue full or empty
+ * yields its CPU.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 22 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "mpmc.h"
+
+#define MPMC_CAPACITY    (1024)
+#define MPMC_ITEMS       ((size_t)1 << 20)
+#define MPMC_MAX_THREADS (8)
+
+typedef struct
+{
+  uint64_t stamp;      /* bench_now_ns() at push */
+  uint32_t producer;
+  uint32_t seq;        /* Per producer, counts up from 0 */
+  uint8_t payload[48];
+} mpmc_slot_t;
+
+static struct
+{
+  mpmc_queue_t q;
+  size_t per_producer;
+  size_t threads;
+  int go;
+  size_t popped;       /* Slots taken by consumers so far */
+  size_t recorded;     /* Next free entry of latency */
+  uint64_t * latency;
+  int failed;
+} mb;
+
+static void wait_for_go(void)
+{
+  while(!__atomic_load_n(&mb.go, __ATOMIC_ACQUIRE))
+  {
+    sched_yield();
+  }
+}
+
+static void * producer(void * arg)
+{
+  mpmc_slot_t slot = { 0 };
+  size_t i;
+
+  slot.producer = (uint32_t)(uintptr_t)arg;
+  wait_for_go();
+  for(i = 0; i < mb.per_producer; i++)
+  {
+    slot.seq = (uint32_t)i;
+    slot.stamp = bench_now_ns();
+    while(!mpmc_push(&mb.q, (uint8_t *)&slot))
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void * consumer(void * arg)
+{
+  uint32_t next[MPMC_MAX_THREADS] = { 0 };
+  size_t total = mb.per_producer * mb.threads;
+  mpmc_slot_t slot;
+
+  (void)arg;
+  wait_for_go();
+  while(__atomic_load_n(&mb.popped, __ATOMIC_RELAXED) < total)
+  {
+    if(!mpmc_pop(&mb.q, (uint8_t *)&slot))
+    {
+      sched_yield();
+      continue;
+    }
+    mb.latency[__atomic_fetch_add(&mb.recorded, 1, __ATOMIC_RELAXED)] =
+        bench_now_ns() - slot.stamp;
+    __atomic_fetch_add(&mb.popped, 1, __ATOMIC_RELAXED);
+
+    /* FIFO: one consumer sees each producer's slots in order */
+    if((slot.producer >= mb.threads) || (slot.seq < next[slot.producer]))
+    {
+      __atomic_store_n(&mb.failed, 1, __ATOMIC_RELAXED);
+    }
+    next[slot.producer] = slot.seq + 1;
+  }
+
+  return NULL;
+}
+
+static int compare_u64(const void * a, const void * b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+void bench_mpmc(void)
+{
+  pthread_t threads[2 * MPMC_MAX_THREADS];
+  size_t n, i, total;
+  uint64_t start, elapsed;
+
+  mb.latency = malloc(MPMC_ITEMS * sizeof(uint64_t));
+  if(!mb.latency || !mpmc_init(&mb.q, MPMC_CAPACITY, sizeof(mpmc_slot_t)))
+  {
+    printf("mpmc: allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  printf("%6s %12s %10s %10s %10s %10s  (latency ns)\n", "P/C", "Mops/s",
+         "p50", "p99", "p99.9", "max");
+  for(n = 1; n <= MPMC_MAX_THREADS; n <<= 1)
+  {
+    mb.threads = n;
+    mb.per_producer = MPMC_ITEMS / n;
+    total = mb.per_producer * n;
+    mb.go = 0;
+    mb.popped = mb.recorded = 0;
+    mb.failed = 0;
+
+    for(i = 0; i < n; i++)
+    {
+      if((pthread_create(&threads[i], NULL, producer, (void *)(uintptr_t)i) !=
+          0) ||
+         (pthread_create(&threads[n + i], NULL, consumer, NULL) != 0))
+      {
+        printf("mpmc: pthread_create failed\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    start = bench_now_ns();
+    __atomic_store_n(&mb.go, 1, __ATOMIC_RELEASE);
+    for(i = 0; i < 2 * n; i++)
+    {
+      pthread_join(threads[i], NULL);
+    }
+    elapsed = bench_now_ns() - start;
+
+    if(mb.failed || (mb.recorded != total))
+    {
+      printf("%6zu mpmc MISMATCH\n", n);
+      exit(EXIT_FAILURE);
+    }
+
+    qsort(mb.latency, total, sizeof(uint64_t), compare_u64);
+    printf("%4zu/%-2zu %11.2f %10llu %10llu %10llu %10llu\n", n, n,
+           (double)total * 1000.0 / (double)(elapsed ? elapsed : 1),
+           (unsigned long long)mb.latency[total / 2],
+           (unsigned long long)mb.latency[total - total / 100],
+           (unsigned long long)mb.latency[total - total / 1000],
+           (unsigned long long)mb.latency[total - 1]);
+  }
+
+  mpmc_destroy(&mb.q);
+  free(mb.latency);
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_parallel.c
+ * @brief Thread scaling of my_memcopy_parallel and my_memset_parallel
+ *
+ * Restarts the pool with 1, 2, 4, ... threads and finally the number
+ * of online CPUs (at least 2), and measures a 256 MiB copy and fill,
+ * checking the result of every run.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 16 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+#include "memory.h"
+#include "memory_parallel.h"
+
+#define PARALLEL_SIZE ((size_t)256 * 1024 * 1024)
+#define PARALLEL_REPS (4)
+
+void bench_parallel(void)
+{
+  uint8_t * src = bench_buffer(PARALLEL_SIZE);
+  uint8_t * dst = bench_buffer(PARALLEL_SIZE);
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t max = (cpus > 2) ? (size_t)cpus : 2;
+  size_t threads, i;
+  uint64_t start, copy, fill;
+
+  for(i = 0; i < PARALLEL_SIZE; i++)
+  {
+    src[i] = (uint8_t)(i ^ (i >> 12));
+  }
+
+  printf("%8s %12s %12s\n", "threads", "copy GB/s", "fill GB/s");
+  /* Powers of two, then max itself when it is not one */
+  for(threads = 1; threads <= max;
+      threads = ((threads < max) && (threads * 2 > max)) ? max : threads * 2)
+  {
+    memory_parallel_init(threads);
+
+    start = bench_now_ns();
+    for(i = 0; i < PARALLEL_REPS; i++)
+    {
+      my_memcopy_parallel(src + 3, dst + 1, PARALLEL_SIZE - 3);
+    }
+    copy = bench_now_ns() - start;
+    if(memcmp(src + 3, dst + 1, PARALLEL_SIZE - 3) != 0)
+    {
+      printf("%8zu copy MISMATCH\n", threads);
+      exit(EXIT_FAILURE);
+    }
+
+    start = bench_now_ns();
+    for(i = 0; i < PARALLEL_REPS; i++)
+    {
+      my_memset_parallel(dst + 5, PARALLEL_SIZE - 5, (uint8_t)(i + 1));
+    }
+    fill = bench_now_ns() - start;
+    if((dst[5] != PARALLEL_REPS) || (dst[PARALLEL_SIZE - 1] != PARALLEL_REPS) ||
+       (dst[4] == PARALLEL_REPS))
+    {
+      printf("%8zu fill MISMATCH\n", threads);
+      exit(EXIT_FAILURE);
+    }
+
+    printf("%8zu %12.2f %12.2f\n", memory_parallel_threads(),
+           bench_gbps((double)PARALLEL_SIZE * PARALLEL_REPS, copy),
+           bench_gbps((double)PARALLEL_SIZE * PARALLEL_REPS, fill));
+  }
+
+  memory_parallel_shutdown();
+  free(src);
+  free(dst);
+}
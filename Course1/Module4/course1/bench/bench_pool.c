@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_pool.c
+ * @brief The block pool and reserve_words/free_words against malloc/free
+ *
+ * Two patterns: the reserve-use-free pairs course1.c does in every
+ * test, and bursts of POOL_BLOCKS_PER_CLASS live blocks freed in
+ * reverse order. The pool column calls pool_reserve/pool_release
+ * directly; the reserve_words column goes through the thread caches
+ * on the HOST, which sit in front of the pool.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 12 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "memory.h"
+#include "pool.h"
+
+#define POOL_BENCH_OPS (4u * 1024u * 1024u)
+
+/* Allocator measured by a run */
+typedef enum
+{
+  POOL_BENCH_POOL = 0,
+  POOL_BENCH_RESERVE,
+  POOL_BENCH_MALLOC
+} pool_bench_mode_t;
+
+static int32_t * bench_alloc(size_t words, pool_bench_mode_t mode)
+{
+  switch(mode)
+  {
+  case POOL_BENCH_POOL:
+    return pool_reserve(words);
+  case POOL_BENCH_RESERVE:
+    return reserve_words(words);
+  default:
+    return malloc(words * sizeof(int32_t));
+  }
+}
+
+static void bench_free(int32_t * ptr, pool_bench_mode_t mode)
+{
+  switch(mode)
+  {
+  case POOL_BENCH_POOL:
+    if(ptr)
+    {
+      pool_release(ptr);
+    }
+    break;
+  case POOL_BENCH_RESERVE:
+    free_words(ptr);
+    break;
+  default:
+    free(ptr);
+    break;
+  }
+}
+
+static uint64_t time_pairs(size_t words, pool_bench_mode_t mode)
+{
+  int32_t * volatile sink;
+  int32_t * ptr;
+  uint64_t start = bench_now_ns();
+  size_t i;
+
+  for(i = 0; i < POOL_BENCH_OPS; i++)
+  {
+    ptr = bench_alloc(words, mode);
+    sink = ptr;
+    bench_free(ptr, mode);
+  }
+  (void)sink;
+
+  return bench_now_ns() - start;
+}
+
+static uint64_t time_bursts(size_t words, pool_bench_mode_t mode)
+{
+  int32_t * live[POOL_BLOCKS_PER_CLASS];
+  uint64_t start = bench_now_ns();
+  size_t i, j;
+
+  for(i = 0; i < POOL_BENCH_OPS / POOL_BLOCKS_PER_CLASS; i++)
+  {
+    for(j = 0; j < POOL_BLOCKS_PER_CLASS; j++)
+    {
+      live[j] = bench_alloc(words, mode);
+    }
+    for(j = POOL_BLOCKS_PER_CLASS; j-- > 0; )
+    {
+      bench_free(live[j], mode);
+    }
+  }
+
+  return bench_now_ns() - start;
+}
+
+static double mops(uint64_t ns)
+{
+  return ns ? (double)POOL_BENCH_OPS * 1000.0 / (double)ns : 0.0;
+}
+
+void bench_pool(void)
+{
+  static const size_t sizes[] = { 8, 10, POOL_MAX_BLOCK_W };
+  size_t i;
+
+  /* Every size is its own class, measured on the pool before caching */
+  printf("%6s %8s %14s %14s %14s\n", "words", "pattern", "pool Mops/s",
+         "reserve Mops/s", "malloc Mops/s");
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    printf("%6zu %8s %14.1f %14.1f %14.1f\n", sizes[i], "pairs",
+           mops(time_pairs(sizes[i], POOL_BENCH_POOL)),
+           mops(time_pairs(sizes[i], POOL_BENCH_RESERVE)),
+           mops(time_pairs(sizes[i], POOL_BENCH_MALLOC)));
+    printf("%6zu %8s %14.1f %14.1f %14.1f\n", sizes[i], "bursts",
+           mops(time_bursts(sizes[i], POOL_BENCH_POOL)),
+           mops(time_bursts(sizes[i], POOL_BENCH_RESERVE)),
+           mops(time_bursts(sizes[i], POOL_BENCH_MALLOC)));
+  }
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_remap.c
+ * @brief my_memzero storing zeros against dropping pages
+ *
+ * A buffer from reserve_aligned is filled, then cleared by my_memzero
+ * once with page dropping disabled and once with it enabled. For each
+ * way the table gives the time of the clear, the resident set size
+ * right after it and the time to write the whole buffer again, which
+ * is where dropped pages pay their page faults. The clears start 3
+ * bytes into the buffer and stop 5 bytes short of its end, and the
+ * result is checked, so the edge handling is exercised as well.
+ *
+ * Settings (environment):
+ *   BENCH_MAX_SIZE  largest buffer, K/M/G suffixes allowed (default 1G)
+ *
+ * @author Mahmoud Hamdy
+ * @date October 28 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench.h"
+#include "memory.h"
+
+#define REMAP_MIN_SIZE ((size_t)16 * 1024 * 1024)
+#define REMAP_MAX_SIZE ((size_t)1024 * 1024 * 1024)
+#define REMAP_HEAD     (3)
+#define REMAP_TAIL     (5)
+
+/* Resident set size of the process in MiB */
+static double remap_rss(void)
+{
+  unsigned long size = 0, resident = 0;
+  FILE * f = fopen("/proc/self/statm", "r");
+
+  if(f)
+  {
+    if(fscanf(f, "%lu %lu", &size, &resident) != 2)
+    {
+      resident = 0;
+    }
+    fclose(f);
+  }
+
+  return (double)resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+static void remap_verify(const uint8_t * buf, size_t size)
+{
+  size_t i, step = 4093;
+
+  if((buf[REMAP_HEAD - 1] != 0x5A) || (buf[size - REMAP_TAIL] != 0x5A))
+  {
+    printf("remap: bytes outside the cleared range changed\n");
+    exit(EXIT_FAILURE);
+  }
+  for(i = REMAP_HEAD; i < size - REMAP_TAIL; i += step)
+  {
+    if(buf[i] != 0)
+    {
+      printf("remap: byte %zu not cleared\n", i);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if(buf[REMAP_HEAD] || buf[size - REMAP_TAIL - 1])
+  {
+    printf("remap: edge bytes not cleared\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void bench_remap(void)
+{
+  size_t max = bench_env("BENCH_MAX_SIZE", REMAP_MAX_SIZE);
+  size_t threshold = my_memzero_get_remap_threshold();
+  size_t size;
+  uint64_t start, zero_ns, write_ns;
+  uint8_t * buf;
+  double rss;
+  int remap;
+
+  printf("%12s %8s %10s %12s %12s\n", "bytes", "mode", "zero ms",
+         "RSS after MiB", "rewrite ms");
+  for(size = REMAP_MIN_SIZE; size <= max; size <<= 2)
+  {
+    buf = reserve_aligned(size, 4096, MEM_ALIGNED_DEFAULT);
+    if(!buf)
+    {
+      printf("%12zu cannot allocate\n", size);
+      break;
+    }
+
+    for(remap = 0; remap < 2; remap++)
+    {
+      my_memset(buf, size, 0x5A);
+      my_memzero_set_remap_threshold(remap ? 0 : MEMZERO_REMAP_DISABLED);
+
+      start = bench_now_ns();
+      my_memzero(buf + REMAP_HEAD, size - REMAP_HEAD - REMAP_TAIL);
+      zero_ns = bench_now_ns() - start;
+      rss = remap_rss();
+      remap_verify(buf, size);
+
+      start = bench_now_ns();
+      my_memset(buf, size, 0x5A);
+      write_ns = bench_now_ns() - start;
+
+      printf("%12zu %8s %10.2f %12.1f %12.2f\n", size,
+             remap ? "remap" : "store", zero_ns / 1e6, rss, write_ns / 1e6);
+    }
+    free_aligned(buf);
+  }
+  my_memzero_set_remap_threshold(threshold);
+}
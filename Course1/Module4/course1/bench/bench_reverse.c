@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_reverse.c
+ * @brief Block my_reverse against the old pairwise byte swap
+ *
+ * Checks every length up to a few blocks against the pairwise swap,
+ * then sweeps buffer sizes from 16 bytes to 1 MiB.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 10 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define REVERSE_MAX_SIZE   ((size_t)1024 * 1024)
+#define REVERSE_CHECK_SIZE (300)
+
+/* The pairwise swap my_reverse used to be */
+__attribute__((noinline, optimize("no-tree-vectorize")))
+static void pairwise_reverse(uint8_t * src, size_t length)
+{
+  size_t left, right;
+  uint8_t temp;
+
+  if(length < 2)
+  {
+    return;
+  }
+  for(left = 0, right = length - 1; left < right; left++, right--)
+  {
+    temp = src[left];
+    src[left] = src[right];
+    src[right] = temp;
+  }
+}
+
+void bench_reverse(void)
+{
+  uint8_t * mine = bench_buffer(REVERSE_MAX_SIZE + 1);
+  uint8_t * ref = bench_buffer(REVERSE_MAX_SIZE + 1);
+  size_t size, reps, i;
+  uint64_t start, fast, slow;
+
+  for(size = 0; size < REVERSE_CHECK_SIZE; size++)
+  {
+    for(i = 0; i <= size; i++)
+    {
+      mine[i] = ref[i] = (uint8_t)(i * 13 + 1);
+    }
+    my_reverse(mine + 1, size);
+    pairwise_reverse(ref + 1, size);
+    if(memcmp(mine, ref, size + 1) != 0)
+    {
+      printf("%zu my_reverse MISMATCH\n", size);
+      exit(EXIT_FAILURE);
+    }
+  }
+  printf("reverse check: all lengths < %d OK\n", REVERSE_CHECK_SIZE);
+
+  printf("%10s %12s %12s %8s\n", "bytes", "my GB/s", "pair GB/s", "speedup");
+  for(size = 16; size <= REVERSE_MAX_SIZE; size <<= 2)
+  {
+    reps = bench_reps(size) / 4 + 1;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      my_reverse(mine, size);
+    }
+    fast = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      pairwise_reverse(ref, size);
+    }
+    slow = bench_now_ns() - start;
+
+    printf("%10zu %12.2f %12.2f %8.2f\n", size,
+           bench_gbps((double)size * reps, fast),
+           bench_gbps((double)size * reps, slow),
+           fast ? (double)slow / (double)fast : 0.0);
+  }
+
+  free(mine);
+  free(ref);
+}
@@ -0,0 +1,175 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_ringbuf.c
+ * @brief Producer/consumer throughput of the SPSC ring buffer
+ *
+ * A producer thread streams a known byte sequence through a 64 KiB
+ * ring to the main thread, which checks every byte. Single byte
+ * push/pop is measured, then bulk write/read with several span sizes.
+ * A side that finds the ring full or empty yields its CPU.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 21 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "ringbuf.h"
+
+#define RINGBUF_SIZE       ((size_t)64 * 1024)
+#define RINGBUF_BYTES      ((size_t)64 * 1024 * 1024)
+#define RINGBUF_BYTE_BYTES ((size_t)8 * 1024 * 1024)
+
+/* The stream repeats every 251 bytes, a prime, so no span lines up */
+#define RINGBUF_PERIOD     (251)
+
+typedef struct
+{
+  ringbuf_t ring;
+  size_t span;        /* 0 for single byte push/pop */
+  size_t total;
+  uint8_t * pattern;  /* span + RINGBUF_PERIOD bytes of the stream */
+} ringbuf_bench_t;
+
+static void * producer(void * arg)
+{
+  ringbuf_bench_t * b = arg;
+  size_t sent = 0, length, i;
+
+  while(sent < b->total)
+  {
+    if(!b->span)
+    {
+      while(!ringbuf_push(&b->ring, b->pattern[sent % RINGBUF_PERIOD]))
+      {
+        sched_yield();
+      }
+      sent++;
+      continue;
+    }
+
+    length = (b->total - sent < b->span) ? b->total - sent : b->span;
+    for(i = 0; i < length; )
+    {
+      i += ringbuf_write(&b->ring, b->pattern + (sent + i) % RINGBUF_PERIOD,
+                         length - i);
+      if(i < length)
+      {
+        sched_yield();
+      }
+    }
+    sent += length;
+  }
+
+  return NULL;
+}
+
+/* Consumes everything the producer sends, returns 0 on a bad byte */
+static int consumer(ringbuf_bench_t * b)
+{
+  uint8_t * chunk = bench_buffer(b->span ? b->span : 1);
+  size_t received = 0, length;
+  uint8_t value;
+
+  while(received < b->total)
+  {
+    if(!b->span)
+    {
+      if(!ringbuf_pop(&b->ring, &value))
+      {
+        sched_yield();
+        continue;
+      }
+      if(value != b->pattern[received++ % RINGBUF_PERIOD])
+      {
+        break;
+      }
+      continue;
+    }
+
+    length = ringbuf_read(&b->ring, chunk, b->span);
+    if(!length)
+    {
+      sched_yield();
+    }
+    if(memcmp(chunk, b->pattern + received % RINGBUF_PERIOD, length) != 0)
+    {
+      break;
+    }
+    received += length;
+  }
+
+  free(chunk);
+  return received == b->total;
+}
+
+void bench_ringbuf(void)
+{
+  static const size_t spans[] = { 0, 16, 256, 4096, 32768 };
+  uint8_t * storage = bench_buffer(RINGBUF_SIZE);
+  ringbuf_bench_t b;
+  size_t i;
+  pthread_t thread;
+  uint64_t start, elapsed;
+  size_t s;
+  int ok;
+
+  b.pattern = bench_buffer(spans[4] + RINGBUF_PERIOD);
+  for(i = 0; i < spans[4] + RINGBUF_PERIOD; i++)
+  {
+    b.pattern[i] = (uint8_t)((i % RINGBUF_PERIOD) * 7 + 1);
+  }
+
+  printf("%10s %12s %12s\n", "span", "GB/s", "Mops/s");
+  for(s = 0; s < sizeof(spans) / sizeof(spans[0]); s++)
+  {
+    ringbuf_init(&b.ring, storage, RINGBUF_SIZE);
+    b.span = spans[s];
+    b.total = spans[s] ? RINGBUF_BYTES : RINGBUF_BYTE_BYTES;
+
+    start = bench_now_ns();
+    if(pthread_create(&thread, NULL, producer, &b) != 0)
+    {
+      printf("ringbuf: pthread_create failed\n");
+      exit(EXIT_FAILURE);
+    }
+    ok = consumer(&b);
+    pthread_join(thread, NULL);
+    elapsed = bench_now_ns() - start;
+
+    if(!ok || ringbuf_count(&b.ring))
+    {
+      printf("%10zu ringbuf MISMATCH\n", spans[s]);
+      exit(EXIT_FAILURE);
+    }
+
+    if(spans[s])
+    {
+      printf("%10zu", spans[s]);
+    }
+    else
+    {
+      printf("%10s", "byte");
+    }
+    printf(" %12.2f %12.2f\n", bench_gbps((double)b.total, elapsed),
+           (double)b.total / (double)(spans[s] ? spans[s] : 1) * 1000.0 /
+           (double)(elapsed ? elapsed : 1));
+  }
+
+  free(b.pattern);
+  free(storage);
+}
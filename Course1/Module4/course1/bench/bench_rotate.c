@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_rotate.c
+ * @brief my_rotate against rotating through a reserve_words temporary
+ *
+ * my_rotate is checked against a byte by byte rotation for all short
+ * lengths and shifts. Then both ways are timed for sizes from 64
+ * bytes to 16 MiB with shifts of one byte, a quarter and a third of
+ * the buffer. The temporary way copies the first shift bytes out, moves
+ * the rest down with my_memmove and copies them back behind it, the
+ * way call sites did it before my_rotate.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 30 2020
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define ROTATE_MIN_SIZE   ((size_t)64)
+#define ROTATE_MAX_SIZE   ((size_t)16 * 1024 * 1024)
+#define ROTATE_CHECK_SIZE (160)
+
+static uint8_t * rotate_temp(uint8_t * src, size_t length, size_t shift)
+{
+  uint8_t * temp = (uint8_t *)reserve_words((shift + 3) / 4);
+
+  if(!temp)
+  {
+    printf("rotate: allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  my_memmove(src, temp, shift);
+  my_memmove(src + shift, src, length - shift);
+  my_memmove(temp, src + length - shift, shift);
+  free_words((int32_t *)temp);
+
+  return src;
+}
+
+static void rotate_check(void)
+{
+  uint8_t a[ROTATE_CHECK_SIZE], ref[ROTATE_CHECK_SIZE];
+  size_t length, shift, i;
+
+  for(length = 0; length < ROTATE_CHECK_SIZE; length++)
+  {
+    for(shift = 0; shift <= length + 1; shift++)
+    {
+      for(i = 0; i < length; i++)
+      {
+        a[i] = (uint8_t)(i * 5 + 3);
+      }
+      for(i = 0; i < length; i++)
+      {
+        ref[i] = a[(i + shift) % length];
+      }
+      my_rotate(a, length, shift);
+      if(memcmp(a, ref, length) != 0)
+      {
+        printf("rotate length %zu shift %zu MISMATCH\n", length, shift);
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+}
+
+void bench_rotate(void)
+{
+  uint8_t * buf = bench_buffer(ROTATE_MAX_SIZE);
+  uint64_t start, mine, temp;
+  size_t size, reps, i, s, shift;
+
+  rotate_check();
+  printf("rotate check: all lengths < %d OK\n", ROTATE_CHECK_SIZE);
+
+  printf("%10s %10s %12s %12s  (GB/s)\n", "bytes", "shift", "my_rotate",
+         "temporary");
+  for(size = ROTATE_MIN_SIZE; size <= ROTATE_MAX_SIZE; size <<= 2)
+  {
+    reps = bench_reps(size);
+    for(s = 0; s < 3; s++)
+    {
+      shift = (s == 0) ? 1 : size / (5 - s);
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        my_rotate(buf, size, shift);
+      }
+      mine = bench_now_ns() - start;
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        rotate_temp(buf, size, shift);
+      }
+      temp = bench_now_ns() - start;
+
+      printf("%10zu %10zu %12.2f %12.2f\n", size, shift,
+             bench_gbps((double)size * reps, mine),
+             bench_gbps((double)size * reps, temp));
+    }
+  }
+
+  free(buf);
+}
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_search.c
+ * @brief my_memcmp, my_memchr and my_memrchr against libc
+ *
+ * Every supported kernel variant is checked against libc for all short
+ * lengths and hit positions, then the three functions are timed with
+ * the hit at the far end of the buffer (the worst case for early exit)
+ * for sizes from 16 bytes to 16 MiB.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 15 2020
+ *
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define SEARCH_MAX_SIZE   ((size_t)16 * 1024 * 1024)
+#define SEARCH_CHECK_SIZE (200)
+
+static int sign(int value)
+{
+  return (value > 0) - (value < 0);
+}
+
+static int check_variant(void)
+{
+  uint8_t a[SEARCH_CHECK_SIZE + 8], b[SEARCH_CHECK_SIZE + 8];
+  size_t length, hit;
+
+  for(length = 0; length < SEARCH_CHECK_SIZE; length++)
+  {
+    for(hit = 0; hit <= length; hit++)
+    {
+      memset(a, 0x11, sizeof(a));
+      memset(b, 0x11, sizeof(b));
+      a[1 + hit] = 0x80;
+      b[3 + hit] = 0x7F;
+
+      if(sign(my_memcmp(a + 1, b + 3, length)) !=
+         sign(memcmp(a + 1, b + 3, length)))
+      {
+        printf("  memcmp %zu/%zu MISMATCH\n", length, hit);
+        return 0;
+      }
+      if((my_memchr(a + 1, length, 0x80) != memchr(a + 1, 0x80, length)) ||
+         (my_memchr(a + 1, length, 0x22) != (uint8_t *)0))
+      {
+        printf("  memchr %zu/%zu MISMATCH\n", length, hit);
+        return 0;
+      }
+      a[1 + length / 2] = 0x80;
+      if((my_memrchr(a + 1, length, 0x80) != memrchr(a + 1, 0x80, length)) ||
+         (my_memrchr(a + 1, length, 0x22) != (uint8_t *)0))
+      {
+        printf("  memrchr %zu/%zu MISMATCH\n", length, hit);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+void bench_search(void)
+{
+  uint8_t * a = bench_buffer(SEARCH_MAX_SIZE);
+  uint8_t * b = bench_buffer(SEARCH_MAX_SIZE);
+  mem_variant_t startup = memory_get_variant();
+  volatile uintptr_t sink = 0;
+  uint64_t start, mine[3], libc[3];
+  size_t size, reps, i;
+  mem_variant_t v;
+  int op;
+
+  for(v = MEM_VARIANT_WORD; v < MEM_VARIANT_COUNT; v++)
+  {
+    if(memory_select_variant(v) && !check_variant())
+    {
+      printf("search check failed for %s\n", memory_variant_name(v));
+      exit(EXIT_FAILURE);
+    }
+  }
+  memory_select_variant(startup);
+  printf("search check: all lengths < %d OK\n", SEARCH_CHECK_SIZE);
+
+  printf("%10s %8s %8s %8s %8s %8s %8s  (GB/s, my/libc)\n", "bytes",
+         "cmp", "libc", "chr", "libc", "rchr", "libc");
+  for(size = 16; size <= SEARCH_MAX_SIZE; size <<= 2)
+  {
+    reps = bench_reps(size);
+
+    /* Equal up to the last byte, value only at the far end */
+    a[size - 1] = 1;
+    b[size - 1] = 2;
+    for(op = 0; op < 3; op++)
+    {
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        switch(op)
+        {
+          case 0:  sink += (uintptr_t)my_memcmp(a, b, size); break;
+          case 1:  sink += (uintptr_t)my_memchr(a, size, 1); break;
+          default: sink += (uintptr_t)my_memrchr(a + 1, size - 1, 0x5B);
+                   break;
+        }
+      }
+      mine[op] = bench_now_ns() - start;
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        switch(op)
+        {
+          case 0:  sink += (uintptr_t)memcmp(a, b, size); break;
+          case 1:  sink += (uintptr_t)memchr(a, 1, size); break;
+          default: sink += (uintptr_t)memrchr(a + 1, 0x5B, size - 1);
+                   break;
+        }
+      }
+      libc[op] = bench_now_ns() - start;
+    }
+    a[size - 1] = b[size - 1] = 0x5A;
+
+    printf("%10zu", size);
+    for(op = 0; op < 3; op++)
+    {
+      printf(" %8.2f %8.2f", bench_gbps((double)size * reps, mine[op]),
+             bench_gbps((double)size * reps, libc[op]));
+    }
+    printf("\n");
+  }
+
+  (void)sink;
+  free(a);
+  free(b);
+}
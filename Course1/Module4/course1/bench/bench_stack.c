@@ -0,0 +1,156 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_stack.c
+ * @brief Stack painting speed and peak stack use of library calls
+ *
+ * A probe that touches a known amount of stack checks stack_measure
+ * first, then the peak stack of a few memory, data and checksum calls
+ * is reported, followed by how fast a large stack region is painted.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 26 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "memory.h"
+#include "data.h"
+#include "stats.h"
+#include "crc32.h"
+#include "stack.h"
+
+#define STACK_THREAD_SIZE ((size_t)256 * 1024)
+#define STACK_PAINT_SIZE  ((size_t)8 * 1024 * 1024)
+#define STACK_DATA_SIZE   ((size_t)64 * 1024)
+#define STACK_PROBE_SIZE  (4096)
+
+static uint8_t * stack_data;
+static volatile uint32_t stack_sink;
+
+/* Touches STACK_PROBE_SIZE bytes of locals */
+static void probe(void * arg)
+{
+  volatile uint8_t local[STACK_PROBE_SIZE];
+  size_t i;
+
+  (void)arg;
+  for(i = 0; i < sizeof(local); i++)
+  {
+    local[i] = (uint8_t)i;
+  }
+  stack_sink = local[STACK_PROBE_SIZE / 2];
+}
+
+static void run_memcopy(void * arg)
+{
+  (void)arg;
+  my_memcopy(stack_data, stack_data + STACK_DATA_SIZE / 2,
+             STACK_DATA_SIZE / 2);
+}
+
+static void run_memset(void * arg)
+{
+  (void)arg;
+  my_memset(stack_data, STACK_DATA_SIZE, 0x11);
+}
+
+static void run_reverse(void * arg)
+{
+  (void)arg;
+  my_reverse(stack_data, STACK_DATA_SIZE);
+}
+
+static void run_itoa(void * arg)
+{
+  (void)arg;
+  stack_sink = my_itoa(-123456789, stack_data, 2);
+}
+
+static void run_sort(void * arg)
+{
+  (void)arg;
+  sort_array(stack_data, 256);
+}
+
+static void run_crc32(void * arg)
+{
+  (void)arg;
+  stack_sink = crc32(stack_data, STACK_DATA_SIZE);
+}
+
+static const struct
+{
+  const char * name;
+  void (*fn)(void *);
+} stack_calls[] =
+{
+  { "my_memcopy 32 KiB", run_memcopy },
+  { "my_memset 64 KiB", run_memset },
+  { "my_reverse 64 KiB", run_reverse },
+  { "my_itoa base 2", run_itoa },
+  { "sort_array 256", run_sort },
+  { "crc32 64 KiB", run_crc32 },
+};
+
+#define STACK_CALL_COUNT (sizeof(stack_calls) / sizeof(stack_calls[0]))
+
+void bench_stack(void)
+{
+  stack_region_t region;
+  uint64_t start, elapsed;
+  size_t used, i, reps;
+
+  stack_data = bench_buffer(STACK_DATA_SIZE);
+
+  used = stack_measure(probe, NULL, STACK_THREAD_SIZE);
+  if((used < STACK_PROBE_SIZE) || (used > STACK_PROBE_SIZE + 1024))
+  {
+    printf("stack check: probe of %d bytes measured %zu\n",
+           STACK_PROBE_SIZE, used);
+    exit(EXIT_FAILURE);
+  }
+  printf("stack check: probe of %d bytes measured %zu OK\n",
+         STACK_PROBE_SIZE, used);
+
+  printf("%-24s %10s\n", "call", "peak bytes");
+  for(i = 0; i < STACK_CALL_COUNT; i++)
+  {
+    printf("%-24s %10zu\n", stack_calls[i].name,
+           stack_measure(stack_calls[i].fn, NULL, STACK_THREAD_SIZE));
+  }
+
+  region.bottom = bench_buffer(STACK_PAINT_SIZE);
+  region.top = region.bottom + STACK_PAINT_SIZE;
+  reps = bench_reps(STACK_PAINT_SIZE);
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    stack_region_paint(&region, region.top);
+  }
+  elapsed = bench_now_ns() - start;
+  printf("paint %zu bytes: %.2f GB/s", STACK_PAINT_SIZE,
+         bench_gbps((double)STACK_PAINT_SIZE * reps, elapsed));
+
+  start = bench_now_ns();
+  for(i = 0; i < reps; i++)
+  {
+    stack_sink += (uint32_t)stack_region_used(&region);
+  }
+  elapsed = bench_now_ns() - start;
+  printf(", scan %.2f GB/s\n",
+         bench_gbps((double)STACK_PAINT_SIZE * reps, elapsed));
+
+  free(region.bottom);
+  free(stack_data);
+}
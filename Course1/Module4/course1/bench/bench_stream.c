@@ -0,0 +1,278 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_stream.c
+ * @brief STREAM-style bandwidth suite of the memory module against libc
+ *
+ * Runs copy, move, set, zero and reverse over sizes from 16 bytes to
+ * 256 MiB (every power of four) and several buffer misalignments,
+ * each against its libc counterpart (libc has no reverse). A point is
+ * a batch of calls moving about BENCH_BYTES_PER_RUN bytes, run
+ * BENCH_WARMUP times untimed and then BENCH_REPEAT times, keeping the
+ * best batch as STREAM does. GB/s counts the bytes of one buffer per
+ * call, the same as the other benchmarks.
+ *
+ * Settings (environment):
+ *   BENCH_WARMUP    untimed batches per point (default 1)
+ *   BENCH_REPEAT    timed batches per point (default 3)
+ *   BENCH_MAX_SIZE  largest size, K/M/G suffixes allowed (default 256M)
+ *   BENCH_CSV       file receiving every point as CSV (none if unset)
+ *
+ * @author Mahmoud Hamdy
+ * @date October 24 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define STREAM_MAX_SIZE  ((size_t)256 * 1024 * 1024)
+#define STREAM_MIN_SIZE  (16)
+
+/* Distance between source and destination of the overlapping move */
+#define STREAM_MOVE_SHIFT (64)
+
+/* Both buffers are offset by this many bytes from a page boundary */
+static const size_t stream_aligns[] = { 0, 1, 7, 32 };
+
+#define STREAM_ALIGN_COUNT (sizeof(stream_aligns) / sizeof(stream_aligns[0]))
+
+typedef void (*stream_fn_t)(uint8_t * src, uint8_t * dst, size_t length);
+
+static void my_copy(uint8_t * src, uint8_t * dst, size_t length)
+{
+  my_memcopy(src, dst, length);
+}
+
+static void libc_copy(uint8_t * src, uint8_t * dst, size_t length)
+{
+  memcpy(dst, src, length);
+}
+
+/* Overlapping move inside dst, towards lower addresses */
+static void my_move(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  my_memmove(dst + STREAM_MOVE_SHIFT, dst, length);
+}
+
+static void libc_move(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  memmove(dst, dst + STREAM_MOVE_SHIFT, length);
+}
+
+static void my_set(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  my_memset(dst, length, 0xA5);
+}
+
+static void libc_set(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  memset(dst, 0xA5, length);
+}
+
+static void my_zero(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  my_memzero(dst, length);
+}
+
+static void libc_zero(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  memset(dst, 0, length);
+}
+
+static void my_rev(uint8_t * src, uint8_t * dst, size_t length)
+{
+  (void)src;
+  my_reverse(dst, length);
+}
+
+static const struct
+{
+  const char * name;
+  stream_fn_t mine;
+  stream_fn_t libc;   /* Null pointer if libc has no counterpart */
+} stream_ops[] =
+{
+  { "copy", my_copy, libc_copy },
+  { "move", my_move, libc_move },
+  { "set", my_set, libc_set },
+  { "zero", my_zero, libc_zero },
+  { "reverse", my_rev, NULL },
+};
+
+#define STREAM_OP_COUNT (sizeof(stream_ops) / sizeof(stream_ops[0]))
+
+/* Best time of one call over the timed batches, in nanoseconds */
+static double stream_time(stream_fn_t fn, uint8_t * src, uint8_t * dst,
+                          size_t size, size_t warmup, size_t repeat)
+{
+  size_t reps = bench_reps(size), batch, i;
+  uint64_t start, elapsed, best = 0;
+
+  for(batch = 0; batch < warmup + repeat; batch++)
+  {
+    start = bench_now_ns();
+    for(i = 0; i < reps; i++)
+    {
+      fn(src, dst, size);
+    }
+    elapsed = bench_now_ns() - start;
+    if((batch >= warmup) && (!best || (elapsed < best)))
+    {
+      best = elapsed;
+    }
+  }
+
+  return (double)best / (double)reps;
+}
+
+/* Every op against libc on short buffers, so a broken kernel stops here */
+static void stream_check(uint8_t * src)
+{
+  uint8_t a[1024], b[1024];
+  size_t op, align, length, i;
+  uint8_t * r;
+
+  for(op = 0; op < STREAM_OP_COUNT; op++)
+  {
+    for(align = 0; align < STREAM_ALIGN_COUNT; align++)
+    {
+      for(length = 0; length < 600; length += 7)
+      {
+        for(i = 0; i < sizeof(a); i++)
+        {
+          a[i] = b[i] = (uint8_t)(i * 13 + length);
+        }
+        stream_ops[op].mine(src + stream_aligns[align],
+                            a + stream_aligns[align], length);
+        if(stream_ops[op].libc)
+        {
+          stream_ops[op].libc(src + stream_aligns[align],
+                              b + stream_aligns[align], length);
+        }
+        else
+        {
+          r = b + stream_aligns[align];
+          for(i = 0; i < length / 2; i++)
+          {
+            uint8_t t = r[i];
+            r[i] = r[length - 1 - i];
+            r[length - 1 - i] = t;
+          }
+        }
+        if(memcmp(a, b, sizeof(a)) != 0)
+        {
+          printf("%s align %zu length %zu MISMATCH\n", stream_ops[op].name,
+                 stream_aligns[align], length);
+          exit(EXIT_FAILURE);
+        }
+      }
+    }
+  }
+}
+
+void bench_stream(void)
+{
+  size_t warmup = bench_env("BENCH_WARMUP", 1);
+  size_t repeat = bench_env("BENCH_REPEAT", 3);
+  size_t max = bench_env("BENCH_MAX_SIZE", STREAM_MAX_SIZE);
+  const char * csv_path = getenv("BENCH_CSV");
+  size_t pad = STREAM_MOVE_SHIFT + 1024;
+  uint8_t * src, * dst;
+  size_t op, align, size;
+  double mine, libc;
+  FILE * csv = NULL;
+
+  if(repeat == 0)
+  {
+    repeat = 1;
+  }
+  if(max < STREAM_MIN_SIZE)
+  {
+    max = STREAM_MIN_SIZE;
+  }
+  src = bench_buffer(max + pad);
+  dst = bench_buffer(max + pad);
+
+  stream_check(src);
+  printf("stream check: all ops and alignments OK\n");
+
+  if(csv_path && *csv_path)
+  {
+    csv = fopen(csv_path, "w");
+    if(!csv)
+    {
+      fprintf(stderr, "stream: cannot open %s\n", csv_path);
+      exit(EXIT_FAILURE);
+    }
+    fprintf(csv, "op,impl,bytes,align,ns_per_call,gbps\n");
+  }
+
+  printf("warm-up %zu, repeat %zu (best of), up to %zu bytes\n", warmup,
+         repeat, max);
+  printf("%8s %10s %6s %12s %10s %12s %10s %8s\n", "op", "bytes", "align",
+         "my ns/call", "my GB/s", "libc ns/call", "libc GB/s", "ratio");
+  for(op = 0; op < STREAM_OP_COUNT; op++)
+  {
+    for(size = STREAM_MIN_SIZE; size <= max; size <<= 2)
+    {
+      for(align = 0; align < STREAM_ALIGN_COUNT; align++)
+      {
+        uint8_t * s = src + stream_aligns[align];
+        uint8_t * d = dst + stream_aligns[align];
+
+        mine = stream_time(stream_ops[op].mine, s, d, size, warmup, repeat);
+        libc = stream_ops[op].libc ?
+               stream_time(stream_ops[op].libc, s, d, size, warmup, repeat) :
+               0.0;
+
+        printf("%8s %10zu %6zu %12.1f %10.2f", stream_ops[op].name, size,
+               stream_aligns[align], mine, size / mine);
+        if(stream_ops[op].libc)
+        {
+          printf(" %12.1f %10.2f %8.2f\n", libc, size / libc, libc / mine);
+        }
+        else
+        {
+          printf(" %12s %10s %8s\n", "-", "-", "-");
+        }
+
+        if(csv)
+        {
+          fprintf(csv, "%s,my,%zu,%zu,%.2f,%.3f\n", stream_ops[op].name, size,
+                  stream_aligns[align], mine, size / mine);
+          if(stream_ops[op].libc)
+          {
+            fprintf(csv, "%s,libc,%zu,%zu,%.2f,%.3f\n", stream_ops[op].name,
+                    size, stream_aligns[align], libc, size / libc);
+          }
+        }
+      }
+    }
+  }
+
+  if(csv)
+  {
+    fclose(csv);
+    printf("stream: CSV written to %s\n", csv_path);
+  }
+  free(src);
+  free(dst);
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_swap.c
+ * @brief swap16/32/64_array against an element by element loop
+ *
+ * Every supported kernel variant is checked against __builtin_bswap
+ * for all short counts at odd offsets, both in place and out of
+ * place. Then each width is timed out of place and in place for sizes
+ * from 4 KiB to 64 MiB, next to the plain loop a caller would write
+ * (which the compiler is free to vectorize).
+ *
+ * @author Mahmoud Hamdy
+ * @date October 29 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "memory.h"
+
+#define SWAP_MIN_SIZE   ((size_t)4 * 1024)
+#define SWAP_MAX_SIZE   ((size_t)64 * 1024 * 1024)
+#define SWAP_CHECK_SIZE (600)
+
+typedef uint8_t * (*swap_fn_t)(uint8_t * src, uint8_t * dst, size_t count);
+
+static const struct
+{
+  size_t width;
+  swap_fn_t fn;
+} swap_widths[] =
+{
+  { 2, swap16_array },
+  { 4, swap32_array },
+  { 8, swap64_array },
+};
+
+#define SWAP_WIDTH_COUNT (sizeof(swap_widths) / sizeof(swap_widths[0]))
+
+static void swap_loop(uint8_t * src, uint8_t * dst, size_t count,
+                      size_t width)
+{
+  size_t i;
+
+  for(i = 0; i < count; i++)
+  {
+    if(width == 2)
+    {
+      uint16_t v;
+      memcpy(&v, src + 2 * i, 2);
+      v = __builtin_bswap16(v);
+      memcpy(dst + 2 * i, &v, 2);
+    }
+    else if(width == 4)
+    {
+      uint32_t v;
+      memcpy(&v, src + 4 * i, 4);
+      v = __builtin_bswap32(v);
+      memcpy(dst + 4 * i, &v, 4);
+    }
+    else
+    {
+      uint64_t v;
+      memcpy(&v, src + 8 * i, 8);
+      v = __builtin_bswap64(v);
+      memcpy(dst + 8 * i, &v, 8);
+    }
+  }
+}
+
+static int check_variant(void)
+{
+  uint8_t src[SWAP_CHECK_SIZE + 16], dst[SWAP_CHECK_SIZE + 16];
+  uint8_t ref[SWAP_CHECK_SIZE + 16];
+  size_t w, count, i, width;
+
+  for(i = 0; i < sizeof(src); i++)
+  {
+    src[i] = (uint8_t)(i * 7 + 1);
+  }
+  for(w = 0; w < SWAP_WIDTH_COUNT; w++)
+  {
+    width = swap_widths[w].width;
+    for(count = 0; count * width < SWAP_CHECK_SIZE; count++)
+    {
+      memset(dst, 0xEE, sizeof(dst));
+      memset(ref, 0xEE, sizeof(ref));
+      swap_widths[w].fn(src + 1, dst + 3, count);
+      swap_loop(src + 1, ref + 3, count, width);
+      if(memcmp(dst, ref, sizeof(dst)) != 0)
+      {
+        printf("  swap%zu count %zu MISMATCH\n", 8 * width, count);
+        return 0;
+      }
+
+      memcpy(dst, src, sizeof(dst));
+      swap_widths[w].fn(dst + 5, dst + 5, count);
+      memcpy(ref, src, sizeof(ref));
+      swap_loop(ref + 5, ref + 5, count, width);
+      if(memcmp(dst, ref, sizeof(dst)) != 0)
+      {
+        printf("  swap%zu in place count %zu MISMATCH\n", 8 * width, count);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+void bench_swap(void)
+{
+  uint8_t * src = bench_buffer(SWAP_MAX_SIZE);
+  uint8_t * dst = bench_buffer(SWAP_MAX_SIZE);
+  mem_variant_t startup = memory_get_variant();
+  uint64_t start, mine, inplace, loop;
+  size_t w, size, reps, i, width;
+  mem_variant_t v;
+
+  for(v = MEM_VARIANT_WORD; v < MEM_VARIANT_COUNT; v++)
+  {
+    if(memory_select_variant(v) && !check_variant())
+    {
+      printf("swap check failed for %s\n", memory_variant_name(v));
+      exit(EXIT_FAILURE);
+    }
+  }
+  memory_select_variant(startup);
+  printf("swap check: all counts < %d bytes OK\n", SWAP_CHECK_SIZE);
+
+  printf("%6s %10s %10s %10s %10s  (GB/s)\n", "width", "bytes", "swapNN",
+         "in place", "loop");
+  for(w = 0; w < SWAP_WIDTH_COUNT; w++)
+  {
+    width = swap_widths[w].width;
+    for(size = SWAP_MIN_SIZE; size <= SWAP_MAX_SIZE; size <<= 2)
+    {
+      reps = bench_reps(size);
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        swap_widths[w].fn(src, dst, size / width);
+      }
+      mine = bench_now_ns() - start;
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        swap_widths[w].fn(dst, dst, size / width);
+      }
+      inplace = bench_now_ns() - start;
+
+      start = bench_now_ns();
+      for(i = 0; i < reps; i++)
+      {
+        swap_loop(src, dst, size / width, width);
+      }
+      loop = bench_now_ns() - start;
+
+      printf("%6zu %10zu %10.2f %10.2f %10.2f\n", 8 * width, size,
+             bench_gbps((double)size * reps, mine),
+             bench_gbps((double)size * reps, inplace),
+             bench_gbps((double)size * reps, loop));
+    }
+  }
+
+  free(src);
+  free(dst);
+}
@@ -0,0 +1,187 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file bench_tcache.c
+ * @brief Multi-threaded reserve_words/free_words against malloc/free
+ *
+ * Every thread keeps a window of live blocks and replaces the oldest
+ * one on each step with a block of a random size between 1 and 512
+ * words, tagging it and checking the tag before it is freed, so a
+ * block handed out twice fails the run. The blocks still live at the
+ * end are freed by the main thread, which moves them between caches.
+ * Rates are allocations per second over all threads, for 1 to 16
+ * threads.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 27 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "memory.h"
+
+#define TCACHE_OPS         ((size_t)1 << 20)
+#define TCACHE_WINDOW      (32)
+#define TCACHE_MAX_THREADS (16)
+
+typedef struct
+{
+  pthread_t thread;
+  uint32_t id;
+  int use_malloc;
+  int32_t * live[TCACHE_WINDOW];
+  size_t words[TCACHE_WINDOW];
+  int failed;
+} tcache_worker_t;
+
+static tcache_worker_t workers[TCACHE_MAX_THREADS];
+
+static int32_t * tcache_reserve(int use_malloc, size_t words)
+{
+  return use_malloc ? malloc(sizeof(int32_t) * words) : reserve_words(words);
+}
+
+static void tcache_free(int use_malloc, int32_t * ptr)
+{
+  if(use_malloc)
+  {
+    free(ptr);
+  }
+  else
+  {
+    free_words(ptr);
+  }
+}
+
+/* Tag stored in the first and last word of a live block */
+static int32_t tcache_tag(uint32_t id, size_t slot, size_t words)
+{
+  return (int32_t)((id << 24) ^ (slot << 12) ^ words);
+}
+
+static int tcache_check(tcache_worker_t * w, size_t slot)
+{
+  int32_t tag = tcache_tag(w->id, slot, w->words[slot]);
+
+  return (w->live[slot][0] == tag) &&
+         (w->live[slot][w->words[slot] - 1] == tag);
+}
+
+static void * tcache_run(void * arg)
+{
+  tcache_worker_t * w = arg;
+  uint32_t seed = 0x9E3779B9u * (w->id + 1);
+  size_t i, slot, words;
+
+  for(i = 0; i < TCACHE_OPS; i++)
+  {
+    slot = i % TCACHE_WINDOW;
+    if(w->live[slot])
+    {
+      if(!tcache_check(w, slot))
+      {
+        w->failed = 1;
+      }
+      tcache_free(w->use_malloc, w->live[slot]);
+    }
+
+    /* xorshift32, sizes spread evenly over the powers of two */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    words = (size_t)1 << (seed % 9);
+    words += (seed >> 23) % words;
+
+    w->live[slot] = tcache_reserve(w->use_malloc, words);
+    if(!w->live[slot])
+    {
+      w->failed = 1;
+      return NULL;
+    }
+    w->words[slot] = words;
+    w->live[slot][0] = w->live[slot][words - 1] = tcache_tag(w->id, slot,
+                                                             words);
+  }
+
+  return NULL;
+}
+
+/* Allocations per second over all threads, in millions */
+static double tcache_time(size_t threads, int use_malloc)
+{
+  uint64_t start, elapsed;
+  size_t t, slot;
+
+  for(t = 0; t < threads; t++)
+  {
+    workers[t].id = (uint32_t)t;
+    workers[t].use_malloc = use_malloc;
+    for(slot = 0; slot < TCACHE_WINDOW; slot++)
+    {
+      workers[t].live[slot] = NULL;
+    }
+  }
+
+  start = bench_now_ns();
+  for(t = 0; t < threads; t++)
+  {
+    if(pthread_create(&workers[t].thread, NULL, tcache_run, &workers[t]))
+    {
+      printf("tcache: cannot start thread %zu\n", t);
+      exit(EXIT_FAILURE);
+    }
+  }
+  for(t = 0; t < threads; t++)
+  {
+    pthread_join(workers[t].thread, NULL);
+  }
+  elapsed = bench_now_ns() - start;
+
+  for(t = 0; t < threads; t++)
+  {
+    for(slot = 0; slot < TCACHE_WINDOW; slot++)
+    {
+      if(workers[t].live[slot])
+      {
+        if(!tcache_check(&workers[t], slot))
+        {
+          workers[t].failed = 1;
+        }
+        tcache_free(use_malloc, workers[t].live[slot]);
+      }
+    }
+    if(workers[t].failed)
+    {
+      printf("tcache: thread %zu saw a corrupted block\n", t);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  return (double)(TCACHE_OPS * threads) * 1e3 / (double)elapsed;
+}
+
+void bench_tcache(void)
+{
+  size_t threads;
+  double mine, libc;
+
+  printf("%8s %14s %14s %8s\n", "threads", "reserve Mops/s", "malloc Mops/s",
+         "ratio");
+  for(threads = 1; threads <= TCACHE_MAX_THREADS; threads <<= 1)
+  {
+    mine = tcache_time(threads, 0);
+    libc = tcache_time(threads, 1);
+    printf("%8zu %14.1f %14.1f %8.2f\n", threads, mine, libc, mine / libc);
+  }
+}
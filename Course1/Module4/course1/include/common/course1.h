@@ -29,7 +29,92 @@
 #define TEST_MEMMOVE_LENGTH (16)
 #define TEST_ERROR          (1)
 #define TEST_NO_ERROR       (0)
-#define TESTCOUNT           (8)
+#if defined(HOST)
+#define TESTCOUNT_PLATFORM  (26)
+#else
+#define TESTCOUNT_PLATFORM  (21)
+#endif
+#if defined(MEMORY_STATS)
+#define TESTCOUNT           (TESTCOUNT_PLATFORM + 1)
+#else
+#define TESTCOUNT           (TESTCOUNT_PLATFORM)
+#endif
+
+/* Backing buffer of test_arena */
+#define ARENA_TEST_SIZE_B (64)
+#define ARENA_TEST_SIZE_W (ARENA_TEST_SIZE_B / 4)
+
+/* Bytes searched by test_search, unaligned and over several blocks */
+#define SEARCH_TEST_SIZE_W (32)
+#define SEARCH_TEST_LENGTH (100)
+#define SEARCH_TEST_OFFSET (3)
+
+/* Adler-32 of the ASCII string "Wikipedia", the usual self-test */
+#define ADLER32_TEST_CHECK (0x11E60398u)
+
+/* Buffers of test_memcopy_checksum, copies from 1 byte to all of it */
+#define COPY_CRC_TEST_SIZE_W (256)
+#define COPY_CRC_TEST_SIZE_B (COPY_CRC_TEST_SIZE_W * 4)
+
+/* Ring of test_ringbuf and the fill that puts its indices near the end */
+#define RING_TEST_SIZE_B (16)
+#define RING_TEST_SIZE_W (RING_TEST_SIZE_B / 4)
+#define RING_TEST_SKIP_B (10)
+
+/* Frame of test_gather and the bytes its segments hold */
+#define GATHER_TEST_SIZE_W  (16)
+#define GATHER_TEST_SIZE_B  (GATHER_TEST_SIZE_W * 4)
+#define GATHER_TEST_TOTAL_B (32)
+
+/* Largest alignment test_reserve_aligned asks for */
+#define ALIGNED_TEST_MAX_ALIGN (256)
+
+/* Bytes swapped by test_swap, whole 16, 32 and 64-bit values */
+#define SWAP_TEST_SIZE_W (64)
+#define SWAP_TEST_LENGTH (200)
+
+/* Bytes rotated by test_rotate, with both parts over 32 bytes for some */
+#define ROTATE_TEST_SIZE_W (32)
+#define ROTATE_TEST_LENGTH (100)
+
+/* Frames of test_interleave, up to 4 channels of 4 byte samples */
+#define INTERLEAVE_TEST_FRAMES (37)
+#define INTERLEAVE_TEST_SIZE_W (4 * INTERLEAVE_TEST_FRAMES)
+
+/* Frames of test_memcopy2d, rows padded past the widest copy */
+#define COPY2D_TEST_HEIGHT    (10)
+#define COPY2D_TEST_SRC_PITCH (48)
+#define COPY2D_TEST_DST_PITCH (44)
+#define COPY2D_TEST_SIZE_W    (COPY2D_TEST_HEIGHT * COPY2D_TEST_SRC_PITCH / 4)
+
+/* Buffers of test_dma, one slice per chain that can be in flight */
+#define DMA_TEST_SLICE_B (32)
+#define DMA_TEST_SIZE_B  (DMA_TEST_SLICE_B * DMA_MAX_INFLIGHT)
+#define DMA_TEST_SIZE_W  (DMA_TEST_SIZE_B / 4)
+
+/* Queue of test_mpmc and the odd slot size pushed through it */
+#define MPMC_TEST_CAPACITY (4)
+#define MPMC_TEST_SLOT_B   (12)
+
+/* Heap sized requests of test_memory_stats, in histogram buckets 8 and 11 */
+#define STATS_TEST_SMALL_W (100)
+#define STATS_TEST_LARGE_W (1000)
+
+/* Lowered remap threshold of test_memzero_remap and the bytes kept */
+#define REMAP_TEST_THRESHOLD (8192)
+#define REMAP_TEST_HEAD_B    (100)
+#define REMAP_TEST_TAIL_B    (300)
+
+/* Buffers of test_parallel_reinit, several pool chunks each */
+#define PARALLEL_TEST_SIZE_B  (2 * 1024 * 1024)
+#define PARALLEL_TEST_SIZE_W  (PARALLEL_TEST_SIZE_B / 4)
+#define PARALLEL_TEST_THREADS (4)
+#define PARALLEL_TEST_ROUNDS  (16)
+
+/* Probe array of test_stack_measure and the frame overhead allowed */
+#define STACK_TEST_SIZE_B  (64 * 1024)
+#define STACK_TEST_PROBE_B (4096)
+#define STACK_TEST_SLACK_B (512)
 
 #define BASE_16 (16)
 #define BASE_10 (10)
@@ -130,5 +215,221 @@ int8_t test_memset();
  */
 int8_t test_reverse();
 
+/**
+ * @brief function to test the arena allocator
+ * 
+ * This function checks the alignment padding between arena allocations,
+ * that a failed allocation leaves the arena untouched, that
+ * arena_rewind returns to a mark and that arena_reset empties it.
+ *
+ * @return void
+ */
+int8_t test_arena();
+
+/**
+ * @brief function to test the compare and search functionality
+ * 
+ * This function puts a differing byte at the head, in the body and at
+ * the tail of an unaligned array and checks that my_memcmp, my_memchr
+ * and my_memrchr find it there and nowhere else.
+ *
+ * @return void
+ */
+int8_t test_search();
+
+/**
+ * @brief function to test the checksum functionality
+ * 
+ * This function checks crc32 and adler32 against their published check
+ * values, both in one call and fed a byte at a time.
+ *
+ * @return void
+ */
+int8_t test_checksum();
+
+/**
+ * @brief function to test the fused copy and checksum functionality
+ * 
+ * This function checks that my_memcopy_crc32 and my_memcopy_adler32
+ * copy the same bytes and give the same checksums as my_memcopy
+ * followed by crc32 and adler32, for short, unaligned and long copies.
+ *
+ * @return void
+ */
+int8_t test_memcopy_checksum();
+
+/**
+ * @brief function to test the ring buffer functionality
+ * 
+ * This function moves the ring indices close to the end of the buffer,
+ * then writes and reads across the wrap-around and checks the bytes
+ * come out in order and that full and empty rings refuse more.
+ *
+ * @return void
+ */
+int8_t test_ringbuf();
+
+/**
+ * @brief function to test the gather and scatter functionality
+ * 
+ * This function gathers a frame split over segments, one of them
+ * empty, scatters other bytes back into it and walks it with a cursor,
+ * checking that fields straddling a segment boundary are read whole.
+ *
+ * @return void
+ */
+int8_t test_gather();
+
+/**
+ * @brief function to test the aligned allocator
+ * 
+ * This function reserves buffers of a few sizes at every power of two
+ * alignment up to ALIGNED_TEST_MAX_ALIGN, writes them whole and frees
+ * them, and checks that alignments that are not a power of two are
+ * refused. On the HOST a buffer mapped on its own pages is checked too.
+ *
+ * @return void
+ */
+int8_t test_reserve_aligned();
+
+/**
+ * @brief function to test the byte order swap functionality
+ * 
+ * This function swaps unaligned arrays of 16, 32 and 64-bit values
+ * into another array and in place, and checks every value has its
+ * bytes reversed.
+ *
+ * @return void
+ */
+int8_t test_swap();
+
+/**
+ * @brief function to test the rotate functionality
+ * 
+ * This function rotates an array by no shift, one byte, its whole
+ * length, shifts that leave either part over 32 bytes and a shift
+ * beyond the length, and checks every byte against its source.
+ *
+ * @return void
+ */
+int8_t test_rotate();
+
+/**
+ * @brief function to test the interleave functionality
+ * 
+ * This function splits frames of 2, 3 and 4 channels of 1, 2 and 4
+ * byte samples into channel arrays, checks every sample and merges
+ * them back into the original frames.
+ *
+ * @return void
+ */
+int8_t test_interleave();
+
+/**
+ * @brief function to test the 2D copy functionality
+ * 
+ * This function copies rectangles of element sized, odd and wide rows
+ * between buffers whose pitch is larger than the row, and of rows that
+ * are back to back in both, and checks the rows arrive and the padding
+ * between them is left alone.
+ *
+ * @return void
+ */
+int8_t test_memcopy2d();
+
+/**
+ * @brief function to test the block pool
+ * 
+ * This function checks that requests land in the smallest class that
+ * fits, that blocks are aligned to their size, that a released block
+ * is handed out again and that sizes beyond the largest class are
+ * refused.
+ *
+ * @return void
+ */
+int8_t test_pool();
+
+/**
+ * @brief function to test the asynchronous copy engine
+ * 
+ * This function fills the queue with chains of two copies each, polls
+ * and waits on their handles, checks the copied bytes and that the
+ * invalid handle and one not handed out yet are refused.
+ *
+ * @return void
+ */
+int8_t test_dma();
+
+#if defined(MEMORY_STATS)
+/**
+ * @brief function to test the allocation statistics
+ * 
+ * This function reserves and frees two heap sized buffers and checks
+ * the live and peak bytes, the call counters and the histogram after
+ * each step.
+ *
+ * @return void
+ */
+int8_t test_memory_stats();
+#endif
+
+#if defined(HOST)
+/**
+ * @brief function to test restarting the parallel copy pool
+ * 
+ * This function restarts the thread pool after a parallel copy and
+ * checks that the next copy is correct and that no worker started by
+ * the restart runs the earlier job again.
+ *
+ * @return void
+ */
+int8_t test_parallel_reinit();
+
+/**
+ * @brief function to test blocks freed on another thread
+ * 
+ * This function hands every pool block of the largest class to a
+ * thread that frees them and exits, then checks that the pool gets
+ * them back and that each is reserved again exactly once.
+ *
+ * @return void
+ */
+int8_t test_tcache_cross_thread();
+
+/**
+ * @brief function to test the thread stack measurement
+ * 
+ * This function measures a probe that fills a local array of
+ * STACK_TEST_PROBE_B bytes and checks that the peak reported covers
+ * the array and little more.
+ *
+ * @return void
+ */
+int8_t test_stack_measure();
+
+/**
+ * @brief function to test the MPMC queue on one thread
+ * 
+ * This function fills the queue, drains part of it, refills it across
+ * the end of the cell array and checks every slot comes out whole and
+ * in the order pushed, and that bad capacities are refused.
+ *
+ * @return void
+ */
+int8_t test_mpmc();
+
+/**
+ * @brief function to test clearing a mapped buffer by dropping pages
+ * 
+ * This function lowers the my_memzero remap threshold, clears most of
+ * a buffer mapped by reserve_aligned and of a heap one, both with
+ * partial pages at the ends, and checks that the cleared bytes read
+ * back as zeros and that the bytes around them are kept.
+ *
+ * @return void
+ */
+int8_t test_memzero_remap();
+#endif
+
 #endif /* __COURSE1_H__ */
 
@@ -0,0 +1,161 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file crc32.h
+ * @brief Streaming CRC-32 and Adler-32 over arbitrary-length buffers
+ *
+ * This header file provides the IEEE 802.3 CRC-32 (reflected
+ * polynomial 0xEDB88320, as used by Ethernet, zlib and PNG). A
+ * checksum is started with crc32_init, fed any number of buffers
+ * with crc32_update and read with crc32_final, so split buffers give
+ * the same result as one contiguous one.
+ *
+ * On the MSP432 the bytes go through the CRC32 peripheral. The
+ * peripheral is shared, so crc32_update must not be called from an
+ * interrupt that can preempt another crc32_update. On the HOST a
+ * slicing-by-8 table walk is used, or PCLMULQDQ folding on x86 CPUs
+ * that have it.
+ *
+ * Adler-32 (RFC 1950, as used by zlib) follows the same pattern. It
+ * is weaker than CRC-32 but several times cheaper without hardware.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 19 2020
+ *
+ */
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* CRC-32 of the ASCII string "123456789", the usual self-test */
+#define CRC32_CHECK (0xCBF43926u)
+
+/* Running checksum, only valid between crc32_init and crc32_final */
+typedef struct
+{
+  uint32_t state;
+} crc32_t;
+
+/* Running checksum, only valid between adler32_init and adler32_final */
+typedef struct
+{
+  uint32_t state;
+} adler32_t;
+
+/**
+ * @brief Starts a checksum
+ * 
+ * @param crc Pointer to the checksum to be started
+ * 
+ * @return void
+ */
+void crc32_init(crc32_t * crc);
+
+/**
+ * @brief Adds bytes to a checksum
+ * 
+ * @param crc Pointer to a started checksum
+ * @param src Pointer to the bytes to add
+ * @param length Number of bytes to add
+ * 
+ * @return void
+ */
+void crc32_update(crc32_t * crc, const uint8_t * src, size_t length);
+
+/**
+ * @brief Copies bytes and adds them to a checksum in one pass
+ * 
+ * Every byte is checksummed from the register it was loaded into on
+ * its way to dst, so the source is only read once.
+ * 
+ * @param crc Pointer to a started checksum
+ * @param dst Pointer to destination array, must not overlap src
+ * @param src Pointer to the bytes to copy and add
+ * @param length Number of bytes to copy and add
+ * 
+ * @return void
+ */
+void crc32_update_copy(crc32_t * crc, uint8_t * dst, const uint8_t * src,
+                       size_t length);
+
+/**
+ * @brief Finishes a checksum
+ * 
+ * @param crc Pointer to a started checksum
+ * 
+ * @return CRC-32 of every byte added since crc32_init
+ */
+uint32_t crc32_final(crc32_t * crc);
+
+/**
+ * @brief Computes the CRC-32 of a single buffer
+ * 
+ * @param src Pointer to the bytes to check
+ * @param length Number of bytes to check
+ * 
+ * @return CRC-32 of the buffer
+ */
+uint32_t crc32(const uint8_t * src, size_t length);
+
+/**
+ * @brief Starts an Adler-32 checksum
+ * 
+ * @param adler Pointer to the checksum to be started
+ * 
+ * @return void
+ */
+void adler32_init(adler32_t * adler);
+
+/**
+ * @brief Adds bytes to an Adler-32 checksum
+ * 
+ * @param adler Pointer to a started checksum
+ * @param src Pointer to the bytes to add
+ * @param length Number of bytes to add
+ * 
+ * @return void
+ */
+void adler32_update(adler32_t * adler, const uint8_t * src, size_t length);
+
+/**
+ * @brief Copies bytes and adds them to an Adler-32 checksum in one pass
+ * 
+ * @param adler Pointer to a started checksum
+ * @param dst Pointer to destination array, must not overlap src
+ * @param src Pointer to the bytes to copy and add
+ * @param length Number of bytes to copy and add
+ * 
+ * @return void
+ */
+void adler32_update_copy(adler32_t * adler, uint8_t * dst, const uint8_t * src,
+                         size_t length);
+
+/**
+ * @brief Finishes an Adler-32 checksum
+ * 
+ * @param adler Pointer to a started checksum
+ * 
+ * @return Adler-32 of every byte added since adler32_init
+ */
+uint32_t adler32_final(adler32_t * adler);
+
+/**
+ * @brief Computes the Adler-32 of a single buffer
+ * 
+ * @param src Pointer to the bytes to check
+ * @param length Number of bytes to check
+ * 
+ * @return Adler-32 of the buffer
+ */
+uint32_t adler32(const uint8_t * src, size_t length);
+
+#endif /* __CRC32_H__ */
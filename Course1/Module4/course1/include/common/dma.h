@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file dma.h
+ * @brief Asynchronous copy engine with a submit/poll/wait interface
+ *
+ * This header file provides non-blocking bulk copies. A copy is
+ * described by one descriptor or a chain of them; submitting it
+ * returns a handle the caller can poll or wait on while it keeps
+ * computing. Chains complete in submission order.
+ *
+ * On the MSP432 the chains are run by the uDMA controller in memory
+ * scatter-gather mode on DMA_COPY_CHANNEL. On the HOST a worker
+ * thread stands in for the controller and copies with my_memcopy.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 18 2020
+ *
+ */
+#ifndef __DMA_H__
+#define __DMA_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Chains that can be submitted and not yet completed at once */
+#ifndef DMA_MAX_INFLIGHT
+#define DMA_MAX_INFLIGHT (8)
+#endif
+
+/* uDMA channel used for the copies (MSP432 only) */
+#ifndef DMA_COPY_CHANNEL
+#define DMA_COPY_CHANNEL (0)
+#endif
+
+/* Handle value that never refers to a submitted chain */
+#define DMA_INVALID_HANDLE ((dma_handle_t)0)
+
+/* One copy of a chain. Must stay untouched until the chain completes */
+typedef struct dma_desc
+{
+  const uint8_t * src;     /* Source array */
+  uint8_t * dst;           /* Destination array, must not overlap src */
+  size_t length;           /* Number of bytes to be copied */
+  struct dma_desc * next;  /* Next copy of the chain, or a Null pointer */
+} dma_desc_t;
+
+/* Sequence number of a submitted chain */
+typedef uint32_t dma_handle_t;
+
+typedef enum
+{
+  DMA_COPY_DONE = 0,
+  DMA_COPY_PENDING,
+  DMA_COPY_INVALID
+} dma_status_t;
+
+/**
+ * @brief Sets up the copy engine
+ * 
+ * Enables the uDMA controller on the MSP432, starts the worker
+ * thread on the HOST. Called by dma_copy_submit if needed.
+ * 
+ * @return 1 on success, 0 otherwise
+ */
+uint8_t dma_init(void);
+
+/**
+ * @brief Stops the copy engine
+ * 
+ * Waits for every submitted chain, then releases the controller or
+ * the worker thread.
+ * 
+ * @return void
+ */
+void dma_shutdown(void);
+
+/**
+ * @brief Queues a chain of copies
+ * 
+ * The copies of the chain are done in order, after every chain
+ * submitted before it. Returns at once.
+ * 
+ * @param desc Pointer to the first descriptor of the chain
+ * 
+ * @return Handle of the chain, or DMA_INVALID_HANDLE if
+ *         DMA_MAX_INFLIGHT chains are already pending
+ */
+dma_handle_t dma_copy_submit(dma_desc_t * desc);
+
+/**
+ * @brief Queues a copy of a rectangle between two pitched buffers
+ * 
+ * The uDMA counterpart of my_memcopy2d. Fills one descriptor per row
+ * and submits them as one chain, so on the MSP432 every row becomes a
+ * task of the scatter-gather list (word transfers when the row ends
+ * are word aligned). Rows that follow each other in both buffers take
+ * a single descriptor.
+ * 
+ * @param desc Pointer to room for height descriptors, untouched until
+ *        the chain completes
+ * @param src Pointer to the first source row
+ * @param src_pitch Bytes from one source row to the next
+ * @param dst Pointer to the first destination row
+ * @param dst_pitch Bytes from one destination row to the next
+ * @param width Bytes per row
+ * @param height Number of rows
+ * 
+ * @return Handle of the chain, or DMA_INVALID_HANDLE as for
+ *         dma_copy_submit
+ */
+dma_handle_t dma_copy2d_submit(dma_desc_t * desc, const uint8_t * src,
+                               size_t src_pitch, uint8_t * dst,
+                               size_t dst_pitch, size_t width,
+                               size_t height);
+
+/**
+ * @brief Checks whether a chain has completed
+ * 
+ * @param handle Handle returned by dma_copy_submit
+ * 
+ * @return DMA_COPY_DONE, DMA_COPY_PENDING, or DMA_COPY_INVALID for a
+ *         handle that was never returned by dma_copy_submit
+ */
+dma_status_t dma_copy_poll(dma_handle_t handle);
+
+/**
+ * @brief Blocks until a chain has completed
+ * 
+ * @param handle Handle returned by dma_copy_submit
+ * 
+ * @return DMA_COPY_DONE, or DMA_COPY_INVALID for a handle that was
+ *         never returned by dma_copy_submit
+ */
+dma_status_t dma_copy_wait(dma_handle_t handle);
+
+#endif /* __DMA_H__ */
@@ -24,6 +24,128 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "crc32.h"
+
+/* Default size from which my_memset/my_memzero use streaming stores */
+#ifndef MEMSET_NT_THRESHOLD_DEFAULT
+#define MEMSET_NT_THRESHOLD_DEFAULT ((size_t)8 * 1024 * 1024)
+#endif
+
+/* Threshold value that turns streaming stores off */
+#define MEMSET_NT_DISABLED ((size_t)-1)
+
+/* Default size from which my_memzero drops pages instead of storing */
+#ifndef MEMZERO_REMAP_THRESHOLD_DEFAULT
+#define MEMZERO_REMAP_THRESHOLD_DEFAULT ((size_t)16 * 1024 * 1024)
+#endif
+
+/* Threshold value that turns page dropping off */
+#define MEMZERO_REMAP_DISABLED ((size_t)-1)
+
+/* Flags of reserve_aligned, ignored on the MSP432 */
+#define MEM_ALIGNED_DEFAULT (0)        /* Heap memory */
+#define MEM_ALIGNED_THP     (1u << 0)  /* Transparent huge pages (madvise) */
+#define MEM_ALIGNED_HUGETLB (1u << 1)  /* MAP_HUGETLB pages, else THP */
+
+/* Size from which reserve_aligned maps buffers of its own on the HOST */
+#ifndef MEM_ALIGNED_MAP_THRESHOLD
+#define MEM_ALIGNED_MAP_THRESHOLD ((size_t)1024 * 1024)
+#endif
+
+/* Huge page size assumed by the MEM_ALIGNED_THP/HUGETLB mappings */
+#define MEM_HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+/* Rows ahead of the one being copied that my_memcopy2d prefetches */
+#ifndef MEM_COPY2D_AHEAD
+#define MEM_COPY2D_AHEAD (2)
+#endif
+
+#if defined(HOST)
+/* Per-thread caches in front of reserve_words: classes of 4 << c words */
+#ifndef MEM_TCACHE_CLASSES
+#define MEM_TCACHE_CLASSES (8)
+#endif
+#define MEM_TCACHE_MIN_W   (4)
+
+/* Blocks a thread keeps per class before giving a batch back */
+#ifndef MEM_TCACHE_DEPTH
+#define MEM_TCACHE_DEPTH   (64)
+#endif
+
+/* Blocks moved to the shared lists at a time */
+#ifndef MEM_TCACHE_BATCH
+#define MEM_TCACHE_BATCH   (32)
+#endif
+#endif
+
+/* Alignment used by arena_alloc when none is requested */
+#define ARENA_DEFAULT_ALIGN (8)
+
+/**
+ * Bump allocator over a caller supplied buffer. Allocations are
+ * released all at once with arena_reset, or back to a saved position
+ * with arena_rewind; there is no per-object free.
+ */
+typedef struct
+{
+  uint8_t * base; /* Start of the backing buffer */
+  size_t size;    /* Size of the backing buffer in bytes */
+  size_t used;    /* Bytes handed out so far, including padding */
+} mem_arena_t;
+
+/* Saved arena position, see arena_mark and arena_rewind */
+typedef size_t mem_arena_mark_t;
+
+/* One piece of a scattered buffer, as taken by my_gather and friends */
+typedef struct
+{
+  uint8_t * ptr;  /* Start of the piece */
+  size_t length;  /* Size of the piece in bytes */
+} mem_seg_t;
+
+/**
+ * Read position in a list of segments, so a scattered frame can be
+ * parsed in place. Empty segments are skipped.
+ */
+typedef struct
+{
+  const mem_seg_t * segs; /* Segment list being read */
+  size_t count;           /* Number of segments */
+  size_t index;           /* Segment holding the next byte */
+  size_t offset;          /* Offset of the next byte in that segment */
+} mem_cursor_t;
+
+/* Kernel variants the wide memory operations can run on */
+typedef enum
+{
+  MEM_VARIANT_AUTO = 0, /* Best variant the running CPU supports */
+  MEM_VARIANT_WORD,     /* Portable 32/64-bit word kernels */
+  MEM_VARIANT_SSE2,     /* x86 HOST only */
+  MEM_VARIANT_AVX2,     /* x86 HOST only */
+  MEM_VARIANT_AVX512,   /* x86 HOST only, needs AVX-512F and BW */
+  MEM_VARIANT_COUNT
+} mem_variant_t;
+
+#if defined(MEMORY_STATS)
+/* Buckets of the allocation size histogram */
+#define MEM_STATS_BUCKETS (32)
+
+/**
+ * Counters kept by reserve_words and free_words when built with
+ * MEMORY_STATS. Pool allocations count their whole block, heap ones
+ * the bytes requested.
+ */
+typedef struct
+{
+  size_t live_bytes;    /* Bytes currently reserved */
+  size_t peak_bytes;    /* Highest live_bytes seen */
+  size_t reserve_calls; /* Successful reserve_words calls */
+  size_t free_calls;    /* free_words calls with a non-null pointer */
+  size_t failed_calls;  /* reserve_words calls that returned null */
+  size_t histogram[MEM_STATS_BUCKETS]; /* [b]: requests of 2^b..2^(b+1)-1
+                                          bytes, [0] also counts 0 */
+} mem_stats_t;
+#endif
 
 /**
  * @brief Sets a value of a data array 
@@ -102,6 +224,9 @@ void clear_all(char * ptr, unsigned int size);
  * overlapping must be handled so that the overlapped data 
  * (to be copied later) must not be lost.
  * 
+ * The move uses the same wide kernels as my_memcopy, walking forward
+ * when the destination is below the source and backward otherwise.
+ * 
  * @param src Pointer to source array
  * @param dst Pointer to destination array
  * @param length Number of bytes to be moved
@@ -119,6 +244,12 @@ uint8_t * my_memmove(uint8_t * src, uint8_t * dst, size_t length);
  * overlapping of positions is undefined and may lead to 
  * corruption of data. 
  * 
+ * Short copies are a few overlapping unaligned loads and stores,
+ * whatever the alignment. Longer ones are done in three parts: a short
+ * copy until the destination is aligned, a wide body (SSE2/AVX2/AVX-512
+ * vectors on the host, 64-bit words on the MSP432) and a short copy of
+ * the tail.
+ * 
  * @param src Pointer to source array
  * @param dst Pointer to destination array
  * @param length Number of bytes to be copied
@@ -127,12 +258,214 @@ uint8_t * my_memmove(uint8_t * src, uint8_t * dst, size_t length);
  */
 uint8_t * my_memcopy(uint8_t * src, uint8_t * dst, size_t length);
 
+/**
+ * @brief Copies contents and computes their CRC-32 in one pass.
+ * 
+ * Same as my_memcopy, with every byte added to a running CRC-32 (see
+ * crc32.h) on its way through the registers. Compared with a copy
+ * followed by crc32_update over the destination, the data is read
+ * from memory once instead of twice.
+ * 
+ * @param src Pointer to source array
+ * @param dst Pointer to destination array, must not overlap src
+ * @param length Number of bytes to be copied
+ * @param crc Pointer to a started checksum, updated with the bytes
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * my_memcopy_crc32(uint8_t * src, uint8_t * dst, size_t length,
+                           crc32_t * crc);
+
+/**
+ * @brief Copies contents and computes their Adler-32 in one pass.
+ * 
+ * The Adler-32 counterpart of my_memcopy_crc32.
+ * 
+ * @param src Pointer to source array
+ * @param dst Pointer to destination array, must not overlap src
+ * @param length Number of bytes to be copied
+ * @param adler Pointer to a started checksum, updated with the bytes
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * my_memcopy_adler32(uint8_t * src, uint8_t * dst, size_t length,
+                             adler32_t * adler);
+
+/**
+ * @brief Copies a rectangle of bytes between two pitched buffers.
+ * 
+ * Copies height rows of width bytes, row r starting at src + r *
+ * src_pitch and landing at dst + r * dst_pitch, e.g. a tile out of a
+ * frame buffer. Rows of 1, 2, 4 or 8 bytes are moved as one element,
+ * wider rows go through the copy engine of my_memcopy. On the HOST
+ * the rows MEM_COPY2D_AHEAD ahead are prefetched as the copy goes.
+ * Rows that follow each other in both buffers are copied as one
+ * block. See dma_copy2d_submit for the same copy on the uDMA.
+ * 
+ * @param src Pointer to the first source row
+ * @param src_pitch Bytes from one source row to the next
+ * @param dst Pointer to the first destination row, not overlapping
+ *        any source row
+ * @param dst_pitch Bytes from one destination row to the next
+ * @param width Bytes per row
+ * @param height Number of rows
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * my_memcopy2d(uint8_t * src, size_t src_pitch, uint8_t * dst,
+                       size_t dst_pitch, size_t width, size_t height);
+
+/**
+ * @brief Packs elements found at a fixed stride into one array.
+ * 
+ * my_memcopy2d with a destination pitch of size, e.g. one field out
+ * of an array of records.
+ * 
+ * @param src Pointer to the first element
+ * @param stride Bytes from one source element to the next
+ * @param dst Pointer to destination array of count * size bytes
+ * @param size Bytes per element
+ * @param count Number of elements
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * my_gather_strided(uint8_t * src, size_t stride, uint8_t * dst,
+                            size_t size, size_t count);
+
+/**
+ * @brief Spreads packed elements out at a fixed stride.
+ * 
+ * The reverse of my_gather_strided.
+ * 
+ * @param src Pointer to source array of count * size bytes
+ * @param dst Pointer to the first destination element
+ * @param stride Bytes from one destination element to the next
+ * @param size Bytes per element
+ * @param count Number of elements
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * my_scatter_strided(uint8_t * src, uint8_t * dst, size_t stride,
+                             size_t size, size_t count);
+
+/**
+ * @brief Copies a list of segments into one array.
+ * 
+ * Every segment goes through the same wide copy engine as
+ * my_memcopy, straight into its place in dst, so a frame made of
+ * header, payload and trailer pieces is assembled in one pass.
+ * 
+ * @param segs Pointer to the source segments
+ * @param count Number of source segments
+ * @param dst Pointer to destination array, large enough for all of them
+ * 
+ * @return Number of bytes copied
+ */
+size_t my_gather(const mem_seg_t * segs, size_t count, uint8_t * dst);
+
+/**
+ * @brief Copies one array out to a list of segments.
+ * 
+ * The reverse of my_gather: each segment is filled in turn from
+ * consecutive bytes of src.
+ * 
+ * @param src Pointer to source array
+ * @param segs Pointer to the destination segments
+ * @param count Number of destination segments
+ * 
+ * @return Number of bytes copied
+ */
+size_t my_scatter(uint8_t * src, const mem_seg_t * segs, size_t count);
+
+/**
+ * @brief Copies between two lists of segments.
+ * 
+ * Copies the bytes described by src into the space described by dst,
+ * regardless of where either list is split, until one of them runs
+ * out. No segment may overlap another.
+ * 
+ * @param src Pointer to the source segments
+ * @param src_count Number of source segments
+ * @param dst Pointer to the destination segments
+ * @param dst_count Number of destination segments
+ * 
+ * @return Number of bytes copied
+ */
+size_t my_memcopy_v(const mem_seg_t * src, size_t src_count,
+                    const mem_seg_t * dst, size_t dst_count);
+
+/**
+ * @brief Total size of a list of segments.
+ * 
+ * @param segs Pointer to the segments
+ * @param count Number of segments
+ * 
+ * @return Sum of their lengths in bytes
+ */
+size_t mem_seg_total(const mem_seg_t * segs, size_t count);
+
+/**
+ * @brief Places a cursor at the start of a list of segments.
+ * 
+ * @param cursor Pointer to the cursor
+ * @param segs Pointer to the segments, must outlive the cursor
+ * @param count Number of segments
+ * 
+ * @return void
+ */
+void mem_cursor_init(mem_cursor_t * cursor, const mem_seg_t * segs,
+                     size_t count);
+
+/**
+ * @brief Returns the next bytes in place, if they are contiguous.
+ * 
+ * Gives direct access to the next length bytes when they all lie in
+ * the current segment, without copying or advancing. Fields that
+ * straddle a segment boundary need mem_cursor_read instead.
+ * 
+ * @param cursor Pointer to the cursor
+ * @param length Number of bytes wanted
+ * 
+ * @return Pointer to the bytes, or a Null pointer if they are split
+ *         over segments or fewer than length remain
+ */
+uint8_t * mem_cursor_peek(mem_cursor_t * cursor, size_t length);
+
+/**
+ * @brief Returns the rest of the current segment in place.
+ * 
+ * Advances the cursor past the returned span, for walking a frame one
+ * contiguous piece at a time (e.g. to checksum it).
+ * 
+ * @param cursor Pointer to the cursor
+ * @param max Most bytes to return
+ * @param length Pointer to where the span length is stored
+ * 
+ * @return Pointer to the span, or a Null pointer at the end
+ */
+uint8_t * mem_cursor_next(mem_cursor_t * cursor, size_t max, size_t * length);
+
+/**
+ * @brief Copies bytes out from the cursor and advances it.
+ * 
+ * @param cursor Pointer to the cursor
+ * @param dst Pointer to destination array, or a Null pointer to skip
+ * @param length Number of bytes to copy
+ * 
+ * @return Number of bytes copied, less than length at the end
+ */
+size_t mem_cursor_read(mem_cursor_t * cursor, uint8_t * dst, size_t length);
+
 /**
  * @brief Sets array of bytes to a value.
  * 
  * Given a pointer to an array of bytes, this will set a number 
  * of bytes given by the length provided to a specific value.
  * 
+ * The value is broadcast to whole words or vectors. On the host,
+ * buffers of at least the non-temporal threshold are written with
+ * streaming stores so they do not evict the cached working set.
+ * 
  * @param src Pointer to source array
  * @param length Number of bytes to be set
  * @param value Value to be assigned to bytes locations
@@ -147,6 +480,11 @@ uint8_t * my_memset(uint8_t * src, size_t length, uint8_t value);
  * Given a pointer to an array of bytes, this will clear a number  
  * of bytes given by the length provided.
  * 
+ * On the HOST, clears of at least the remap threshold inside a buffer
+ * mapped by reserve_aligned give the whole pages back to the kernel
+ * with madvise(MADV_DONTNEED) instead, which maps in zero pages on the
+ * next touch; only the partial pages at both ends are stored to.
+ * 
  * @param src Pointer to source array
  * @param length Number of bytes to be cleared
  * 
@@ -154,6 +492,49 @@ uint8_t * my_memset(uint8_t * src, size_t length, uint8_t value);
  */
 uint8_t * my_memzero(uint8_t * src, size_t length);
 
+/**
+ * @brief Sets the streaming store threshold of my_memset/my_memzero
+ * 
+ * Fills of at least this many bytes bypass the caches with
+ * non-temporal stores (HOST only, ignored on the MSP432). Pass
+ * MEMSET_NT_DISABLED to always use regular stores.
+ * 
+ * @param threshold Size in bytes from which streaming stores are used
+ * 
+ * @return void
+ */
+void my_memset_set_nt_threshold(size_t threshold);
+
+/**
+ * @brief Returns the streaming store threshold of my_memset/my_memzero
+ * 
+ * @return Size in bytes from which streaming stores are used
+ */
+size_t my_memset_get_nt_threshold(void);
+
+/**
+ * @brief Sets the page dropping threshold of my_memzero
+ * 
+ * Clears of at least this many bytes inside a buffer mapped by
+ * reserve_aligned drop whole pages rather than store zeros (HOST
+ * only, ignored on the MSP432). Dropped pages cost a page fault and
+ * a fresh zero page on the next touch, so this pays off for buffers
+ * that are cleared well before, or instead of, being rewritten. Pass
+ * MEMZERO_REMAP_DISABLED to always store.
+ * 
+ * @param threshold Size in bytes from which pages are dropped
+ * 
+ * @return void
+ */
+void my_memzero_set_remap_threshold(size_t threshold);
+
+/**
+ * @brief Returns the page dropping threshold of my_memzero
+ * 
+ * @return Size in bytes from which pages are dropped
+ */
+size_t my_memzero_get_remap_threshold(void);
+
 /**
  * @brief Reverses array of bytes.
  * 
@@ -161,6 +542,9 @@ uint8_t * my_memzero(uint8_t * src, size_t length);
  * of a number of bytes given by the 
  * length provided.
  * 
+ * Blocks are taken from both ends at once and byte-reversed in
+ * registers (byte shuffles on the host, __REV words on the MSP432).
+ * 
  * @param src Pointer to source array
  * @param length Number of bytes whose order to be reversed
  * 
@@ -168,11 +552,164 @@ uint8_t * my_memzero(uint8_t * src, size_t length);
  */
 uint8_t * my_reverse(uint8_t * src, size_t length);
 
+/**
+ * @brief Rotates array of bytes in place.
+ * 
+ * Moves the byte at position shift to the start of the array, the
+ * bytes before it wrapping around to the end (a left rotation; pass
+ * length - shift to rotate right). Works in place without a heap
+ * buffer: the two parts are reversed and then the whole array, each
+ * pass running on the my_reverse kernels. When either part is at most
+ * 32 bytes it goes through the stack instead, so the rest is moved
+ * just once.
+ * 
+ * @param src Pointer to source array
+ * @param length Number of bytes in the array
+ * @param shift Number of positions to rotate by, taken modulo length
+ * 
+ * @return Pointer to source array
+ */
+uint8_t * my_rotate(uint8_t * src, size_t length, size_t shift);
+
+/**
+ * @brief Swaps the byte order of an array of 16-bit values
+ * 
+ * Converts count big-endian values to host order or back. dst may be
+ * src to convert in place, but the arrays must not overlap otherwise.
+ * No alignment is required. Whole blocks go through byte shuffles on
+ * the host and __REV16 on the MSP432.
+ * 
+ * @param src Pointer to source array
+ * @param dst Pointer to destination array, or src
+ * @param count Number of 16-bit values
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * swap16_array(uint8_t * src, uint8_t * dst, size_t count);
+
+/**
+ * @brief Swaps the byte order of an array of 32-bit values
+ * 
+ * As swap16_array, for 32-bit values (__REV on the MSP432).
+ * 
+ * @param src Pointer to source array
+ * @param dst Pointer to destination array, or src
+ * @param count Number of 32-bit values
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * swap32_array(uint8_t * src, uint8_t * dst, size_t count);
+
+/**
+ * @brief Swaps the byte order of an array of 64-bit values
+ * 
+ * As swap16_array, for 64-bit values (two __REV on the MSP432).
+ * 
+ * @param src Pointer to source array
+ * @param dst Pointer to destination array, or src
+ * @param count Number of 64-bit values
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * swap64_array(uint8_t * src, uint8_t * dst, size_t count);
+
+/**
+ * @brief Splits interleaved samples into one array per channel
+ * 
+ * Frame f of src holds one sample of width bytes for every channel in
+ * turn; sample f of channel c lands at dst[c] + f * width. Two to four
+ * channels of 1, 2 or 4 byte samples (uint8_t, uint16_t, int32_t) run
+ * through the vector kernels, other layouts sample by sample. Each
+ * channel array can then be handed to the functions in stats.h.
+ * 
+ * @param src Pointer to the interleaved samples
+ * @param dst Array of channels pointers to the channel arrays, none of
+ *        them overlapping src or each other
+ * @param channels Number of channels
+ * @param frames Number of frames
+ * @param width Bytes per sample
+ * 
+ * @return void
+ */
+void my_deinterleave(uint8_t * src, uint8_t * const * dst, size_t channels,
+                     size_t frames, size_t width);
+
+/**
+ * @brief Merges one array per channel into interleaved samples
+ * 
+ * The reverse of my_deinterleave, with the same fast layouts.
+ * 
+ * @param src Array of channels pointers to the channel arrays
+ * @param dst Pointer to the interleaved samples, not overlapping any
+ *        channel array
+ * @param channels Number of channels
+ * @param frames Number of frames
+ * @param width Bytes per sample
+ * 
+ * @return void
+ */
+void my_interleave(uint8_t * const * src, uint8_t * dst, size_t channels,
+                   size_t frames, size_t width);
+
+/**
+ * @brief Compares two arrays of bytes.
+ * 
+ * Given two pointers and a length, this returns the difference of the
+ * first pair of bytes that do not match, as unsigned values. Whole
+ * words (SWAR on the MSP432) or vectors (on the host) are compared at
+ * once and the scan stops at the first block that differs.
+ * 
+ * @param src1 Pointer to first array
+ * @param src2 Pointer to second array
+ * @param length Number of bytes to compare
+ * 
+ * @return 0 if equal, negative if src1 sorts first, positive otherwise
+ */
+int32_t my_memcmp(uint8_t * src1, uint8_t * src2, size_t length);
+
+/**
+ * @brief Finds the first occurrence of a byte.
+ * 
+ * Scans an array of bytes from the start a word or vector at a time
+ * and stops at the first block holding the value.
+ * 
+ * @param src Pointer to source array
+ * @param length Number of bytes to search
+ * @param value Byte to look for
+ * 
+ * @return Pointer to the first matching byte, or a Null pointer
+ */
+uint8_t * my_memchr(uint8_t * src, size_t length, uint8_t value);
+
+/**
+ * @brief Finds the last occurrence of a byte.
+ * 
+ * Same as my_memchr, scanning from the end of the array downwards.
+ * 
+ * @param src Pointer to source array
+ * @param length Number of bytes to search
+ * @param value Byte to look for
+ * 
+ * @return Pointer to the last matching byte, or a Null pointer
+ */
+uint8_t * my_memrchr(uint8_t * src, size_t length, uint8_t value);
+
 /**
  * @brief Allocates words dynamically.
  * 
  * This will dynamically allocates a number of words given by 
- * the length provided.
+ * the length provided. Small requests are served in O(1) from the
+ * static block pool (see pool.h), larger ones or those arriving
+ * while their pool class is exhausted fall back to malloc.
+ * 
+ * On the HOST requests of up to MEM_TCACHE_MIN_W << (MEM_TCACHE_CLASSES
+ * - 1) words go through a cache private to the calling thread first.
+ * Freed blocks return to the cache of the thread freeing them. An
+ * overflowing cache hands MEM_TCACHE_BATCH blocks back, as does a
+ * thread on exit: pool blocks are released to the pool, malloc backed
+ * ones go to a shared list that the other caches refill from. The
+ * shared lists, the pool and malloc are only reached, under one lock,
+ * when no cached block is left.
  * 
  * @param length Number of words to be allocated (if available)
  * 
@@ -192,4 +729,150 @@ int32_t * reserve_words(size_t length);
  */
 void free_words(int32_t * src);
 
+#if defined(MEMORY_STATS)
+/**
+ * @brief Copies the reserve_words counters
+ * 
+ * Each counter is read atomically, but counters may be updated by
+ * other threads in between, so they are only consistent when the
+ * allocator is quiet.
+ * 
+ * @param stats Pointer to the structure receiving the counters
+ * 
+ * @return void
+ */
+void memory_stats_snapshot(mem_stats_t * stats);
+
+/**
+ * @brief Clears the reserve_words counters
+ * 
+ * The call and histogram counters go back to zero and the peak is
+ * lowered to the bytes currently live, so a section of code can be
+ * measured on its own. Live bytes are kept.
+ * 
+ * @return void
+ */
+void memory_stats_reset(void);
+#endif
+
+/**
+ * @brief Allocates an aligned buffer.
+ * 
+ * Returns size bytes starting on a multiple of alignment, e.g. 64 to
+ * keep vector loads inside cache lines or 4096 for page aligned DMA
+ * buffers. On the HOST the huge page flags map the buffer on its own
+ * 2 MiB aligned pages, cutting TLB misses on large buffers;
+ * MEM_ALIGNED_HUGETLB needs pages reserved in vm.nr_hugepages and
+ * quietly falls back to transparent huge pages without them. Without
+ * flags, buffers of at least MEM_ALIGNED_MAP_THRESHOLD bytes are
+ * mapped on their own pages as well, which lets my_memzero drop
+ * them. On the MSP432 requests that fit are served from pool blocks,
+ * which are aligned to their own size, and the rest from the heap.
+ * 
+ * @param size Number of bytes to be allocated
+ * @param alignment Required alignment in bytes, a power of two
+ * @param flags MEM_ALIGNED_DEFAULT or MEM_ALIGNED_* backing flags
+ * 
+ * @return Pointer to memory if successful, or a Null pointer otherwise
+ */
+uint8_t * reserve_aligned(size_t size, size_t alignment, uint32_t flags);
+
+/**
+ * @brief Frees a buffer allocated by reserve_aligned
+ * 
+ * @param src Pointer returned by reserve_aligned, or a Null pointer
+ * 
+ * @return void
+ */
+void free_aligned(uint8_t * src);
+
+/**
+ * @brief Creates an arena over a buffer
+ * 
+ * Given a buffer owned by the caller (typically a static array on
+ * the MSP432), this will set up an empty arena that hands out memory
+ * from it. The buffer must outlive the arena.
+ * 
+ * @param arena Pointer to the arena to set up
+ * @param buffer Pointer to the backing buffer
+ * @param size Size of the backing buffer in bytes
+ * 
+ * @return void
+ */
+void arena_create(mem_arena_t * arena, uint8_t * buffer, size_t size);
+
+/**
+ * @brief Allocates bytes from an arena
+ * 
+ * Bumps the arena position past the padding needed for the requested
+ * alignment and the requested number of bytes.
+ * 
+ * @param arena Pointer to the arena
+ * @param length Number of bytes to allocate
+ * @param align Power of two alignment, or 0 for ARENA_DEFAULT_ALIGN
+ * 
+ * @return Pointer to the allocation, or a Null pointer if the arena
+ *         does not have enough room left or align is not a power of two
+ */
+uint8_t * arena_alloc(mem_arena_t * arena, size_t length, size_t align);
+
+/**
+ * @brief Saves the current position of an arena
+ * 
+ * @param arena Pointer to the arena
+ * 
+ * @return Mark to be passed to arena_rewind
+ */
+mem_arena_mark_t arena_mark(const mem_arena_t * arena);
+
+/**
+ * @brief Releases everything allocated since a mark
+ * 
+ * @param arena Pointer to the arena
+ * @param mark Position previously returned by arena_mark
+ * 
+ * @return void
+ */
+void arena_rewind(mem_arena_t * arena, mem_arena_mark_t mark);
+
+/**
+ * @brief Releases every allocation of an arena
+ * 
+ * @param arena Pointer to the arena
+ * 
+ * @return void
+ */
+void arena_reset(mem_arena_t * arena);
+
+/**
+ * @brief Selects the kernels used by the wide memory operations
+ * 
+ * On x86 HOST builds my_memcopy, my_memmove, my_memset, my_memzero
+ * and my_reverse go through a kernel table chosen from CPUID before
+ * main() runs, or from the MEMORY_VARIANT environment variable
+ * (word, sse2, avx2, avx512). This forces another table, e.g. for
+ * benchmarks and tests. Other builds only have the word kernels.
+ * 
+ * @param variant Variant to use, MEM_VARIANT_AUTO for the best one
+ * 
+ * @return 1 if the variant is now in use, 0 if the CPU lacks it
+ */
+uint8_t memory_select_variant(mem_variant_t variant);
+
+/**
+ * @brief Returns the kernel variant in use
+ * 
+ * @return Variant picked at startup or by memory_select_variant
+ */
+mem_variant_t memory_get_variant(void);
+
+/**
+ * @brief Returns the printable name of a kernel variant
+ * 
+ * @param variant Variant to name
+ * 
+ * @return Name of the variant, as accepted by MEMORY_VARIANT
+ */
+const char * memory_variant_name(mem_variant_t variant);
+
 #endif /* __MEMORY_H__ */
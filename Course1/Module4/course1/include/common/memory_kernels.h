@@ -0,0 +1,224 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file memory_kernels.h
+ * @brief Wide kernel tables shared by the memory module implementation
+ *
+ * The public functions of memory.c split every operation into a short
+ * head, a wide body and a short tail. The body is done by one of
+ * the kernel tables below: the portable word kernels on every build,
+ * plus the SSE2, AVX2 and AVX-512 kernels of memory_x86.c on x86 HOST
+ * builds, picked at startup. This header is private to the module.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 14 2020
+ *
+ */
+#ifndef __MEMORY_KERNELS_H__
+#define __MEMORY_KERNELS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Word types used by the kernels. may_alias keeps it legal to walk the
+ * uint8_t buffers through them, and the aligned(1) variants are used
+ * for addresses that are not known to be aligned; the compiler emits
+ * plain LDR on the M4 and byte loads on cores without unaligned access.
+ */
+typedef uint32_t __attribute__((__may_alias__)) mem_word32_t;
+typedef uint64_t __attribute__((__may_alias__)) mem_word64_t;
+typedef uint16_t __attribute__((__may_alias__, __aligned__(1))) mem_uword16_t;
+typedef uint32_t __attribute__((__may_alias__, __aligned__(1))) mem_uword32_t;
+typedef uint64_t __attribute__((__may_alias__, __aligned__(1))) mem_uword64_t;
+
+typedef struct
+{
+  /* Alignment of dst the body kernels expect, in bytes */
+  size_t align;
+
+  /* Bytes handled per copy/fill block */
+  size_t block;
+
+  /* Longest copy_short/fill_short, at least block - 1 and align - 1 */
+  size_t short_max;
+
+  /* Bytes taken from each end per my_reverse step */
+  size_t rev_block;
+
+  /* Bytes examined per compare/search block */
+  size_t scan_block;
+
+  /* Bytes of every channel handled per (de)interleave block */
+  size_t ilv_block;
+
+  /*
+   * Copies whole blocks upwards. Each block is loaded in full before
+   * it is stored, so this is safe for overlap with dst below src.
+   */
+  void (*copy_fwd)(uint8_t * dst, const uint8_t * src, size_t blocks);
+
+  /*
+   * Copies whole blocks downwards, dst and src point one past the end.
+   * Safe for overlap with dst above src.
+   */
+  void (*copy_bwd)(uint8_t * dst, const uint8_t * src, size_t blocks);
+
+  /*
+   * Copies up to short_max bytes with a few overlapping unaligned
+   * loads and stores: the heads, tails and short copies of the copy
+   * engines. Every load is done before the first store, so it is safe
+   * for overlap in either direction.
+   */
+  void (*copy_short)(uint8_t * dst, const uint8_t * src, size_t length);
+
+  /* Fills whole blocks, with non-temporal stores if stream is set */
+  void (*fill)(uint8_t * dst, uint8_t value, size_t blocks, int stream);
+
+  /* Fills up to short_max bytes the way copy_short copies them */
+  void (*fill_short)(uint8_t * dst, uint8_t value, size_t length);
+
+  /*
+   * Reverses 2 * blocks * rev_block bytes from both ends inwards,
+   * right points one past the end of the region.
+   */
+  void (*reverse)(uint8_t * left, uint8_t * right, size_t blocks);
+
+  /*
+   * Reverses the bytes of every width byte element (2, 4 or 8) over
+   * whole copy blocks. dst may equal src, but must not overlap it
+   * otherwise. No alignment is required.
+   */
+  void (*swap)(uint8_t * dst, const uint8_t * src, size_t blocks,
+               size_t width);
+
+  /*
+   * Split interleaved frames of 2, 3 or 4 channels of width byte
+   * samples (1, 2 or 4) into one array per channel, and merge them
+   * back. The channel arrays are always written or read from their
+   * start. No alignment is required, and no buffers may overlap.
+   */
+  void (*deinterleave)(uint8_t * const * dst, const uint8_t * src,
+                       size_t blocks, size_t channels, size_t width);
+  void (*interleave)(uint8_t * dst, const uint8_t * const * src,
+                     size_t blocks, size_t channels, size_t width);
+
+  /*
+   * The scan kernels look at whole scan blocks from the start of the
+   * region (from the end for find_last) and stop at the first block
+   * holding a hit. They return its offset from the start of the
+   * region, or MEM_NOT_FOUND. No alignment is required.
+   */
+  size_t (*mismatch)(const uint8_t * a, const uint8_t * b, size_t blocks);
+  size_t (*find)(const uint8_t * src, uint8_t value, size_t blocks);
+  size_t (*find_last)(const uint8_t * src, uint8_t value, size_t blocks);
+} mem_kernels_t;
+
+/*
+ * Up to 16 bytes as two overlapping words of the largest size that
+ * fits, both loaded before either is stored. The short kernels of
+ * every variant end here.
+ */
+static inline void mem_copy_upto16(uint8_t * dst, const uint8_t * src,
+                                   size_t length)
+{
+  if(length >= 8)
+  {
+    uint64_t a = *(const mem_uword64_t *)(src);
+    uint64_t b = *(const mem_uword64_t *)(src + length - 8);
+    *(mem_uword64_t *)(dst) = a;
+    *(mem_uword64_t *)(dst + length - 8) = b;
+  }
+  else if(length >= 4)
+  {
+    uint32_t a = *(const mem_uword32_t *)(src);
+    uint32_t b = *(const mem_uword32_t *)(src + length - 4);
+    *(mem_uword32_t *)(dst) = a;
+    *(mem_uword32_t *)(dst + length - 4) = b;
+  }
+  else if(length >= 2)
+  {
+    uint16_t a = *(const mem_uword16_t *)(src);
+    uint16_t b = *(const mem_uword16_t *)(src + length - 2);
+    *(mem_uword16_t *)(dst) = a;
+    *(mem_uword16_t *)(dst + length - 2) = b;
+  }
+  else if(length)
+  {
+    *dst = *src;
+  }
+}
+
+static inline void mem_fill_upto16(uint8_t * dst, uint8_t value,
+                                   size_t length)
+{
+  uint64_t v = (uint64_t)value * 0x0101010101010101ull;
+
+  if(length >= 8)
+  {
+    *(mem_uword64_t *)(dst) = v;
+    *(mem_uword64_t *)(dst + length - 8) = v;
+  }
+  else if(length >= 4)
+  {
+    *(mem_uword32_t *)(dst) = (uint32_t)v;
+    *(mem_uword32_t *)(dst + length - 4) = (uint32_t)v;
+  }
+  else if(length >= 2)
+  {
+    *(mem_uword16_t *)(dst) = (uint16_t)v;
+    *(mem_uword16_t *)(dst + length - 2) = (uint16_t)v;
+  }
+  else if(length)
+  {
+    *dst = value;
+  }
+}
+
+/* Returned by the scan kernels when the blocks hold no hit */
+#define MEM_NOT_FOUND     ((size_t)-1)
+
+/**
+ * @brief Fills a buffer through the selected kernels
+ * 
+ * The engine behind my_memset, with the choice of streaming stores
+ * left to the caller (used by the parallel fill, whose chunks are
+ * smaller than the buffer the threshold applies to).
+ * 
+ * @param dst Pointer to the buffer
+ * @param value Value to be assigned to every byte
+ * @param length Number of bytes to be set
+ * @param stream Non-zero to use non-temporal stores on the host
+ * 
+ * @return void
+ */
+void mem_fill(uint8_t * dst, uint8_t value, size_t length, int stream);
+
+/* Portable word kernels (__REV on the MSP432), always available */
+extern const mem_kernels_t mem_kernels_word;
+
+#if defined(HOST) && (defined(__x86_64__) || defined(__i386__))
+#define MEM_KERNELS_X86
+
+extern const mem_kernels_t mem_kernels_sse2;
+extern const mem_kernels_t mem_kernels_avx2;
+extern const mem_kernels_t mem_kernels_avx512;
+
+/**
+ * @brief Checks a kernel table against the running CPU
+ * 
+ * @param kernels Pointer to one of the x86 kernel tables
+ * 
+ * @return 1 if the CPU and OS support the instructions it uses
+ */
+uint8_t mem_kernels_supported(const mem_kernels_t * kernels);
+#endif
+
+#endif /* __MEMORY_KERNELS_H__ */
@@ -0,0 +1,106 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file memory_parallel.h
+ * @brief Multi-threaded copy and fill for very large buffers (HOST only)
+ *
+ * This header file provides variants of my_memcopy and my_memset that
+ * split the buffer into page aligned chunks and hand them to a pool
+ * of worker threads, the calling thread working alongside them.
+ * Buffers below the cutoff are done by the calling thread alone.
+ * Only one parallel operation runs at a time; concurrent callers are
+ * serialized.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 16 2020
+ *
+ */
+#ifndef __MEMORY_PARALLEL_H__
+#define __MEMORY_PARALLEL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Default size from which the parallel variants use the thread pool */
+#ifndef MEMORY_PARALLEL_CUTOFF_DEFAULT
+#define MEMORY_PARALLEL_CUTOFF_DEFAULT ((size_t)16 * 1024 * 1024)
+#endif
+
+/* Chunks are multiples of this size and aligned to it in dst */
+#define MEMORY_PARALLEL_PAGE (4096)
+
+/* Upper bound on the threads of the pool, caller included */
+#define MEMORY_PARALLEL_MAX_THREADS (64)
+
+/**
+ * @brief Starts (or restarts) the thread pool
+ * 
+ * The parallel functions start a pool sized to the online CPUs on
+ * first use; this sets an explicit size instead, e.g. for scaling
+ * benchmarks. Must not be called while a parallel operation runs.
+ * 
+ * @param threads Threads taking part, caller included (0 for the
+ *        number of online CPUs), capped at MEMORY_PARALLEL_MAX_THREADS
+ * 
+ * @return 1 on success, 0 if no worker thread could be started
+ */
+uint8_t memory_parallel_init(size_t threads);
+
+/**
+ * @brief Stops the worker threads of the pool
+ * 
+ * @return void
+ */
+void memory_parallel_shutdown(void);
+
+/**
+ * @brief Returns the number of threads taking part in an operation
+ * 
+ * @return Thread count, caller included (1 before the pool starts)
+ */
+size_t memory_parallel_threads(void);
+
+/**
+ * @brief Sets the size below which the parallel variants stay serial
+ * 
+ * @param cutoff Size in bytes
+ * 
+ * @return void
+ */
+void memory_parallel_set_cutoff(size_t cutoff);
+
+/**
+ * @brief Copies contents from source to destination in parallel
+ * 
+ * Same contract as my_memcopy; buffers must not overlap.
+ * 
+ * @param src Pointer to source array
+ * @param dst Pointer to destination array
+ * @param length Number of bytes to be copied
+ * 
+ * @return Pointer to destination array
+ */
+uint8_t * my_memcopy_parallel(uint8_t * src, uint8_t * dst, size_t length);
+
+/**
+ * @brief Sets array of bytes to a value in parallel
+ * 
+ * Same contract as my_memset, including the streaming store
+ * threshold, which applies to the whole buffer.
+ * 
+ * @param src Pointer to source array
+ * @param length Number of bytes to be set
+ * @param value Value to be assigned to bytes locations
+ * 
+ * @return Pointer to source array
+ */
+uint8_t * my_memset_parallel(uint8_t * src, size_t length, uint8_t value);
+
+#endif /* __MEMORY_PARALLEL_H__ */
@@ -0,0 +1,102 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file mpmc.h
+ * @brief Bounded multi-producer/multi-consumer queue (HOST only)
+ *
+ * This header file provides a FIFO of fixed-size slots that any number
+ * of threads may push to and pop from at once, used to fan sample
+ * batches out to worker threads. There is no lock: every slot carries
+ * a sequence number telling producers and consumers whose turn it is
+ * (D. Vyukov's bounded MPMC queue), so threads only contend on the
+ * position counter of their own side.
+ *
+ * Push and pop copy a whole slot and return at once when the queue is
+ * full or empty; waiting is left to the caller.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 22 2020
+ *
+ */
+#ifndef __MPMC_H__
+#define __MPMC_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Cache line size, keeps the position counters and the cells apart */
+#define MPMC_LINE (64)
+
+/* Largest capacity, so push and pop can tell laps apart by sign */
+#define MPMC_MAX_CAPACITY (((size_t)-1 >> 2) + 1)
+
+typedef struct
+{
+  /* Set by mpmc_init, read-only afterwards */
+  uint8_t * cells;     /* capacity cells of stride bytes */
+  size_t stride;       /* Sequence number plus slot, in whole lines */
+  size_t slot_size;    /* Bytes copied by push and pop */
+  size_t mask;         /* capacity - 1 */
+
+  /* Next position to push, claimed by producers */
+  size_t enqueue_pos __attribute__((__aligned__(MPMC_LINE)));
+
+  /* Next position to pop, claimed by consumers */
+  size_t dequeue_pos __attribute__((__aligned__(MPMC_LINE)));
+} mpmc_queue_t;
+
+/**
+ * @brief Allocates an empty queue
+ * 
+ * @param q Pointer to the queue
+ * Every cell is padded to whole MPMC_LINE lines, so small slots cost a
+ * line each.
+ * 
+ * @param capacity Number of slots, a power of two from 2 up to
+ *        MPMC_MAX_CAPACITY
+ * @param slot_size Size of a slot in bytes
+ * 
+ * @return 1 on success, 0 for a bad capacity, a queue too large to
+ *         address or if allocation failed
+ */
+uint8_t mpmc_init(mpmc_queue_t * q, size_t capacity, size_t slot_size);
+
+/**
+ * @brief Frees the slots of a queue
+ * 
+ * No thread may be using the queue.
+ * 
+ * @param q Pointer to the queue
+ * 
+ * @return void
+ */
+void mpmc_destroy(mpmc_queue_t * q);
+
+/**
+ * @brief Copies a slot into the queue
+ * 
+ * @param q Pointer to the queue
+ * @param src Pointer to slot_size bytes to push
+ * 
+ * @return 1 if pushed, 0 if the queue is full
+ */
+uint8_t mpmc_push(mpmc_queue_t * q, uint8_t * src);
+
+/**
+ * @brief Copies the oldest slot out of the queue
+ * 
+ * @param q Pointer to the queue
+ * @param dst Pointer to slot_size bytes receiving the slot
+ * 
+ * @return 1 if popped, 0 if the queue is empty
+ */
+uint8_t mpmc_pop(mpmc_queue_t * q, uint8_t * dst);
+
+#endif /* __MPMC_H__ */
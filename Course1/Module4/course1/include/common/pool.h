@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file pool.h
+ * @brief Fixed-block pool allocator used behind reserve_words
+ *
+ * This header file provides a segregated-size pool of word blocks
+ * carved out of a static region. Each size class keeps its own free
+ * list, so reserving and releasing a block are O(1) and never
+ * fragment the heap. Block sizes double from one class to the next.
+ *
+ * The pool is not thread safe.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 12 2020
+ *
+ */
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Words in a block of the smallest class */
+#ifndef POOL_MIN_BLOCK_W
+#define POOL_MIN_BLOCK_W      (4)
+#endif
+
+/* Number of size classes (block sizes POOL_MIN_BLOCK_W << class) */
+#ifndef POOL_CLASS_COUNT
+#define POOL_CLASS_COUNT      (4)
+#endif
+
+/* Blocks available in every size class */
+#ifndef POOL_BLOCKS_PER_CLASS
+#define POOL_BLOCKS_PER_CLASS (16)
+#endif
+
+/* Largest request served by the pool, in words */
+#define POOL_MAX_BLOCK_W (POOL_MIN_BLOCK_W << (POOL_CLASS_COUNT - 1))
+
+/**
+ * @brief Reserves a block of words from the pool
+ * 
+ * Picks the smallest class whose blocks hold the requested number
+ * of words and pops a block from it.
+ * 
+ * @param length Number of words requested
+ * 
+ * @return Pointer to the block, or a Null pointer if the request is
+ *         larger than POOL_MAX_BLOCK_W or its class is exhausted
+ */
+int32_t * pool_reserve(size_t length);
+
+/**
+ * @brief Reserves an aligned block of words from the pool
+ * 
+ * Every block is aligned to its own size, so this picks the smallest
+ * class whose blocks are both large enough and at least as large as
+ * the alignment. Release the block with pool_release.
+ * 
+ * @param length Number of words requested
+ * @param align Required alignment in bytes, a power of two
+ * 
+ * @return Pointer to the block, or a Null pointer if no class fits or
+ *         the class is exhausted
+ */
+int32_t * pool_reserve_aligned(size_t length, size_t align);
+
+/**
+ * @brief Returns a block to its size class
+ * 
+ * @param src Pointer previously returned by pool_reserve
+ * 
+ * @return void
+ */
+void pool_release(int32_t * src);
+
+/**
+ * @brief Checks whether a pointer lies in the pool region
+ * 
+ * @param src Pointer to check
+ * 
+ * @return 1 if the pointer belongs to the pool, 0 otherwise
+ */
+uint8_t pool_owns(const int32_t * src);
+
+/**
+ * @brief Returns the capacity of a pool block
+ * 
+ * @param src Pointer previously returned by pool_reserve
+ * 
+ * @return Size of the block in words
+ */
+size_t pool_block_words(const int32_t * src);
+
+#endif /* __POOL_H__ */
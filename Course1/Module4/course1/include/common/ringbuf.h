@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file ringbuf.h
+ * @brief Lock-free single-producer/single-consumer byte ring buffer
+ *
+ * This header file provides a byte queue over a caller supplied
+ * buffer whose size is a power of two. One producer (a thread, or an
+ * interrupt handler on the MSP432) may push while one consumer pops,
+ * without locks or disabled interrupts; every call is wait-free and
+ * returns at once when the ring is full or empty.
+ *
+ * Each index is written by its own side only and published with a
+ * release store after the data, and the other side reads it with an
+ * acquire load before touching the data. Bulk calls move the bytes
+ * with at most two my_memcopy calls, one per side of the wrap.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 21 2020
+ *
+ */
+#ifndef __RINGBUF_H__
+#define __RINGBUF_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Keeps the two sides of a ring on separate cache lines */
+#if defined(HOST)
+#define RINGBUF_LINE (64)
+#else
+#define RINGBUF_LINE (4)
+#endif
+
+/*
+ * Both indices run freely and are only masked to address the buffer,
+ * so head - tail is the fill level even after they wrap around.
+ */
+typedef struct
+{
+  /* Set by ringbuf_init, read-only afterwards */
+  uint8_t * buffer;
+  size_t mask;
+
+  /* Consumer side: next index to read, last head seen */
+  size_t tail __attribute__((__aligned__(RINGBUF_LINE)));
+  size_t head_cache;
+
+  /* Producer side: next index to write, last tail seen */
+  size_t head __attribute__((__aligned__(RINGBUF_LINE)));
+  size_t tail_cache;
+} ringbuf_t;
+
+/**
+ * @brief Sets up an empty ring over a buffer
+ * 
+ * Must not race with any other call on the same ring.
+ * 
+ * @param rb Pointer to the ring
+ * @param buffer Pointer to the storage of the ring
+ * @param size Size of buffer in bytes, a power of two
+ * 
+ * @return 1 on success, 0 if size is not a power of two
+ */
+uint8_t ringbuf_init(ringbuf_t * rb, uint8_t * buffer, size_t size);
+
+/**
+ * @brief Pushes a byte (producer only)
+ * 
+ * @param rb Pointer to the ring
+ * @param value Byte to push
+ * 
+ * @return 1 if the byte was pushed, 0 if the ring is full
+ */
+uint8_t ringbuf_push(ringbuf_t * rb, uint8_t value);
+
+/**
+ * @brief Pops a byte (consumer only)
+ * 
+ * @param rb Pointer to the ring
+ * @param value Pointer to where the byte is stored
+ * 
+ * @return 1 if a byte was popped, 0 if the ring is empty
+ */
+uint8_t ringbuf_pop(ringbuf_t * rb, uint8_t * value);
+
+/**
+ * @brief Pushes as many bytes of an array as fit (producer only)
+ * 
+ * @param rb Pointer to the ring
+ * @param src Pointer to source array
+ * @param length Number of bytes to push
+ * 
+ * @return Number of bytes pushed, less than length if the ring filled
+ */
+size_t ringbuf_write(ringbuf_t * rb, uint8_t * src, size_t length);
+
+/**
+ * @brief Pops up to a number of bytes into an array (consumer only)
+ * 
+ * @param rb Pointer to the ring
+ * @param dst Pointer to destination array
+ * @param length Most bytes to pop
+ * 
+ * @return Number of bytes popped, less than length if the ring emptied
+ */
+size_t ringbuf_read(ringbuf_t * rb, uint8_t * dst, size_t length);
+
+/**
+ * @brief Number of bytes waiting in the ring
+ * 
+ * Exact when called by either side, a snapshot otherwise.
+ * 
+ * @param rb Pointer to the ring
+ * 
+ * @return Bytes that can be popped
+ */
+size_t ringbuf_count(ringbuf_t * rb);
+
+/**
+ * @brief Number of free bytes in the ring
+ * 
+ * @param rb Pointer to the ring
+ * 
+ * @return Bytes that can be pushed
+ */
+size_t ringbuf_space(ringbuf_t * rb);
+
+#endif /* __RINGBUF_H__ */
@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file stack.h
+ * @brief Stack high-water mark measurement by painting
+ *
+ * This header file provides functions that fill the unused part of a
+ * stack with a known pattern and later look for the deepest word that
+ * no longer holds it, which gives the peak stack use since painting.
+ *
+ * On the MSP432 the main stack runs from the initial stack pointer in
+ * the vector table down to the heap break, which starts at the .stack
+ * section placed by the linker and moves up as malloc grows the heap;
+ * Reset_Handler paints it after SystemInit. On the HOST a function can
+ * be run on a painted thread stack with stack_measure.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 26 2020
+ *
+ */
+#ifndef __STACK_H__
+#define __STACK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Byte written over the unused stack, rarely seen in live frames */
+#define STACK_PAINT_BYTE  (0xC5)
+
+/* Bytes left unpainted below the caller, room for the fill itself */
+#define STACK_PAINT_GUARD (256)
+
+/* A stack growing down from top towards bottom */
+typedef struct
+{
+  uint8_t * bottom; /* Lowest address of the stack */
+  uint8_t * top;    /* One past the highest address */
+} stack_region_t;
+
+/**
+ * @brief Paints the part of a stack below a given stack pointer
+ * 
+ * Fills the region from its bottom up to STACK_PAINT_GUARD bytes below
+ * sp with STACK_PAINT_BYTE, using my_memset. Pass the region top as sp
+ * to paint a stack that is not in use.
+ * 
+ * @param region Pointer to the stack region
+ * @param sp Lowest address currently in use on that stack
+ * 
+ * @return void
+ */
+void stack_region_paint(const stack_region_t * region, const uint8_t * sp);
+
+/**
+ * @brief Finds the peak use of a painted stack
+ * 
+ * Scans up from the bottom for the first word that lost the pattern.
+ * 
+ * @param region Pointer to the stack region
+ * 
+ * @return Bytes between the deepest touched word and the top
+ */
+size_t stack_region_used(const stack_region_t * region);
+
+#if defined(MSP432)
+/**
+ * @brief Paints the free part of the main stack
+ * 
+ * Called by Reset_Handler; may be called again to restart a
+ * measurement. Only the gap above the current heap break is painted,
+ * so live heap blocks are never overwritten.
+ * 
+ * @return void
+ */
+void stack_paint(void);
+
+/**
+ * @brief Peak use of the main stack since it was painted
+ * 
+ * The scan starts at the current heap break, so heap grown since the
+ * stack was painted is not counted as stack, and stack_size() minus
+ * this is the headroom left between heap and stack.
+ * 
+ * @return Bytes of stack used at the deepest point
+ */
+size_t stack_high_water(void);
+
+/**
+ * @brief Size of the main stack region
+ * 
+ * @return Bytes between the heap break and the initial stack pointer
+ */
+size_t stack_size(void);
+#endif
+
+#if defined(HOST)
+/**
+ * @brief Runs a function on a painted thread stack and measures it
+ * 
+ * Starts a thread on a freshly painted stack of the given size, runs
+ * fn(arg) on it and waits for it. The depth is taken from the frame
+ * that calls fn, so the thread library's own use is not counted.
+ * 
+ * @param fn Function to run
+ * @param arg Argument passed to fn
+ * @param size Size of the thread stack in bytes
+ * 
+ * @return Peak stack use of fn in bytes, or 0 if no thread could be
+ *         started
+ */
+size_t stack_measure(void (*fn)(void *), void * arg, size_t size);
+#endif
+
+#endif /* __STACK_H__ */
@@ -13,16 +13,55 @@ ifeq ($(PLATFORM),HOST)
 	# Add your Source files to this variable
 	SOURCES = 	./src/main.c	\
 				./src/memory.c	\
+				./src/memory_x86.c \
+				./src/memory_parallel.c \
+				./src/mpmc.c \
+				./src/pool.c	\
+				./src/dma.c	\
+				./src/crc32.c	\
+				./src/ringbuf.c	\
+				./src/stack.c	\
 				./src/stats.c	\
 				./src/data.c	\
 				./src/course1.c
 
 	# Add your include paths to this variable
 	INCLUDES = -I./include/common
+
+	# Benchmark sources, linked with SOURCES minus the application files
+	BENCH_SOURCES = ./bench/bench.c \
+					./bench/bench_memcopy.c \
+					./bench/bench_memmove.c \
+					./bench/bench_memset.c \
+					./bench/bench_reverse.c \
+					./bench/bench_pool.c \
+					./bench/bench_dispatch.c \
+					./bench/bench_parallel.c \
+					./bench/bench_dma.c \
+					./bench/bench_search.c \
+					./bench/bench_crc32.c \
+					./bench/bench_checksum.c \
+					./bench/bench_ringbuf.c \
+					./bench/bench_mpmc.c \
+					./bench/bench_gather.c \
+					./bench/bench_stream.c \
+					./bench/bench_aligned.c \
+					./bench/bench_stack.c \
+					./bench/bench_tcache.c \
+					./bench/bench_remap.c \
+					./bench/bench_swap.c \
+					./bench/bench_rotate.c \
+					./bench/bench_interleave.c \
+					./bench/bench_copy2d.c
 else
 	# Add your Source files to this variable
 	SOURCES =	./src/main.c	\
 				./src/memory.c	\
+				./src/pool.c	\
+				./src/dma.c	\
+				./src/crc32.c	\
+				./src/ringbuf.c	\
+				./src/stack.c	\
 				./src/stats.c	\
 				./src/data.c	\
 				./src/course1.c	\
@@ -17,12 +17,25 @@
  *
  */
 
+#if defined(HOST)
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#endif
 #include <stdint.h>
 #include "course1.h"
 #include "platform.h"
 #include "memory.h"
 #include "data.h"
 #include "stats.h"
+#include "crc32.h"
+#include "ringbuf.h"
+#include "pool.h"
+#include "dma.h"
+#if defined(HOST)
+#include "memory_parallel.h"
+#include "mpmc.h"
+#include "stack.h"
+#endif
 
 int8_t test_data1() {
   uint8_t * ptr;
@@ -321,20 +334,1170 @@ int8_t test_reverse()
   return ret;
 }
 
+int8_t test_arena()
+{
+  int8_t ret = TEST_NO_ERROR;
+  mem_arena_t arena;
+  mem_arena_mark_t mark;
+  uint8_t * buffer;
+  uint8_t * a;
+  uint8_t * b;
+  uint8_t * c;
+  size_t used;
+
+  PRINTF("test_arena()\n");
+  buffer = (uint8_t*)reserve_words(ARENA_TEST_SIZE_W);
+  if (! buffer )
+  {
+    return TEST_ERROR;
+  }
+  arena_create(&arena, buffer, ARENA_TEST_SIZE_B);
+
+  /* An odd sized allocation forces padding before the aligned one */
+  a = arena_alloc(&arena, 3, 1);
+  b = arena_alloc(&arena, 4, 8);
+  if ((a != buffer) || ! b || ((uintptr_t)b & 7) ||
+      (b < a + 3) || (b >= a + 3 + 8) ||
+      (arena.used != (size_t)(b - buffer) + 4))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Rewinding to a mark hands out the same memory again */
+  mark = arena_mark(&arena);
+  c = arena_alloc(&arena, 8, 0);
+  if (! c || ((uintptr_t)c & (ARENA_DEFAULT_ALIGN - 1)))
+  {
+    ret = TEST_ERROR;
+  }
+  arena_rewind(&arena, mark);
+  if ((arena.used != mark) || (arena_alloc(&arena, 8, 0) != c))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Failed allocations leave the arena as it was */
+  used = arena.used;
+  if (arena_alloc(&arena, ARENA_TEST_SIZE_B, 1) ||
+      arena_alloc(&arena, 1, 3) ||
+      (arena.used != used))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* After a reset the whole buffer is available again */
+  arena_reset(&arena);
+  if ((arena.used != 0) ||
+      (arena_alloc(&arena, ARENA_TEST_SIZE_B, 1) != buffer))
+  {
+    ret = TEST_ERROR;
+  }
+
+  free_words( (int32_t*)buffer );
+  return ret;
+}
+
+int8_t test_search()
+{
+  size_t i;
+  size_t pos;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * buffer;
+  uint8_t * other;
+  uint8_t * src;
+  uint8_t * cmp;
+  const size_t places[3] = { 0, SEARCH_TEST_LENGTH / 2,
+                             SEARCH_TEST_LENGTH - 1 };
+
+  PRINTF("test_search()\n");
+  buffer = (uint8_t*)reserve_words(SEARCH_TEST_SIZE_W);
+  other = (uint8_t*)reserve_words(SEARCH_TEST_SIZE_W);
+  if (! buffer || ! other)
+  {
+    free_words( (int32_t*)buffer );
+    free_words( (int32_t*)other );
+    return TEST_ERROR;
+  }
+  src = buffer + SEARCH_TEST_OFFSET;
+  cmp = other + SEARCH_TEST_OFFSET;
+
+  for (i = 0; i < 3; i++)
+  {
+    pos = places[i];
+    my_memset(src, SEARCH_TEST_LENGTH, 0x11);
+    my_memset(cmp, SEARCH_TEST_LENGTH, 0x11);
+
+    /* Misses: equal arrays and a value that is not there */
+    if (my_memcmp(src, cmp, SEARCH_TEST_LENGTH) ||
+        my_memchr(src, SEARCH_TEST_LENGTH, 0x22) ||
+        my_memrchr(src, SEARCH_TEST_LENGTH, 0x22))
+    {
+      ret = TEST_ERROR;
+    }
+
+    /* Hits at pos, and misses on either side of it */
+    src[pos] = 0x22;
+    if ((my_memcmp(src, cmp, SEARCH_TEST_LENGTH) <= 0) ||
+        (my_memcmp(cmp, src, SEARCH_TEST_LENGTH) >= 0) ||
+        my_memcmp(src, cmp, pos) ||
+        (my_memchr(src, SEARCH_TEST_LENGTH, 0x22) != src + pos) ||
+        (my_memrchr(src, SEARCH_TEST_LENGTH, 0x22) != src + pos) ||
+        my_memchr(src, pos, 0x22) ||
+        my_memrchr(src + pos + 1, SEARCH_TEST_LENGTH - pos - 1, 0x22))
+    {
+      ret = TEST_ERROR;
+    }
+  }
+
+  free_words( (int32_t*)buffer );
+  free_words( (int32_t*)other );
+  return ret;
+}
+
+int8_t test_checksum()
+{
+  size_t i;
+  int8_t ret = TEST_NO_ERROR;
+  const uint8_t * digits = (const uint8_t *)"123456789";
+  const uint8_t * word = (const uint8_t *)"Wikipedia";
+  crc32_t crc;
+  adler32_t adler;
+
+  PRINTF("test_checksum()\n");
+  if ((crc32(digits, 9) != CRC32_CHECK) ||
+      (adler32(word, 9) != ADLER32_TEST_CHECK))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Running checksums give the same result in pieces */
+  crc32_init(&crc);
+  adler32_init(&adler);
+  for (i = 0; i < 9; i++)
+  {
+    crc32_update(&crc, digits + i, 1);
+    adler32_update(&adler, word + i, 1);
+  }
+  if ((crc32_final(&crc) != CRC32_CHECK) ||
+      (adler32_final(&adler) != ADLER32_TEST_CHECK))
+  {
+    ret = TEST_ERROR;
+  }
+
+  return ret;
+}
+
+int8_t test_memcopy_checksum()
+{
+  size_t i, j;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * src;
+  uint8_t * fused;
+  uint8_t * plain;
+  crc32_t crc;
+  adler32_t adler;
+  const size_t lengths[4] = { 1, 7, 67, COPY_CRC_TEST_SIZE_B - 1 };
+
+  PRINTF("test_memcopy_checksum()\n");
+  src = (uint8_t*)reserve_words(COPY_CRC_TEST_SIZE_W);
+  fused = (uint8_t*)reserve_words(COPY_CRC_TEST_SIZE_W);
+  plain = (uint8_t*)reserve_words(COPY_CRC_TEST_SIZE_W);
+  if (! src || ! fused || ! plain)
+  {
+    free_words( (int32_t*)src );
+    free_words( (int32_t*)fused );
+    free_words( (int32_t*)plain );
+    return TEST_ERROR;
+  }
+
+  for (i = 0; i < COPY_CRC_TEST_SIZE_B; i++)
+  {
+    src[i] = (uint8_t)(i * 31 + 7);
+  }
+
+  /* Copies start one byte in, so neither side is aligned */
+  for (i = 0; i < 4; i++)
+  {
+    my_memzero(fused, COPY_CRC_TEST_SIZE_B);
+    crc32_init(&crc);
+    my_memcopy_crc32(src + 1, fused + 1, lengths[i], &crc);
+    my_memcopy(src + 1, plain + 1, lengths[i]);
+    if (crc32_final(&crc) != crc32(plain + 1, lengths[i]))
+    {
+      ret = TEST_ERROR;
+    }
+
+    adler32_init(&adler);
+    my_memcopy_adler32(src + 1, fused + 1, lengths[i], &adler);
+    if (adler32_final(&adler) != adler32(plain + 1, lengths[i]))
+    {
+      ret = TEST_ERROR;
+    }
+
+    for (j = 0; j <= lengths[i]; j++)
+    {
+      if (fused[j] != ((j == 0) ? 0 : plain[j]))
+      {
+        ret = TEST_ERROR;
+      }
+    }
+  }
+
+  free_words( (int32_t*)src );
+  free_words( (int32_t*)fused );
+  free_words( (int32_t*)plain );
+  return ret;
+}
+
+int8_t test_ringbuf()
+{
+  size_t i;
+  int8_t ret = TEST_NO_ERROR;
+  ringbuf_t ring;
+  uint8_t * storage;
+  uint8_t in[RING_TEST_SIZE_B + 4];
+  uint8_t out[RING_TEST_SIZE_B + 4];
+  uint8_t value;
+
+  PRINTF("test_ringbuf()\n");
+  storage = (uint8_t*)reserve_words(RING_TEST_SIZE_W);
+  if (! storage )
+  {
+    return TEST_ERROR;
+  }
+  for (i = 0; i < sizeof(in); i++)
+  {
+    in[i] = (uint8_t)(i + 1);
+  }
+
+  if (ringbuf_init(&ring, storage, RING_TEST_SIZE_B - 4) ||
+      ! ringbuf_init(&ring, storage, RING_TEST_SIZE_B))
+  {
+    free_words( (int32_t*)storage );
+    return TEST_ERROR;
+  }
+
+  /* Leaves both indices RING_TEST_SKIP_B bytes in */
+  if ((ringbuf_write(&ring, in, RING_TEST_SKIP_B) != RING_TEST_SKIP_B) ||
+      (ringbuf_read(&ring, out, RING_TEST_SKIP_B) != RING_TEST_SKIP_B))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Fills the ring across the end of the buffer, the rest is refused */
+  if ((ringbuf_write(&ring, in, RING_TEST_SIZE_B + 4) != RING_TEST_SIZE_B) ||
+      (ringbuf_count(&ring) != RING_TEST_SIZE_B) ||
+      (ringbuf_space(&ring) != 0) ||
+      ringbuf_push(&ring, 0))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Everything comes back in order, one byte then the rest */
+  if (! ringbuf_pop(&ring, &value) || (value != in[0]) ||
+      (ringbuf_read(&ring, out, RING_TEST_SIZE_B + 4) !=
+       RING_TEST_SIZE_B - 1) ||
+      ringbuf_pop(&ring, &value) ||
+      (ringbuf_count(&ring) != 0) ||
+      (ringbuf_space(&ring) != RING_TEST_SIZE_B))
+  {
+    ret = TEST_ERROR;
+  }
+  for (i = 0; i < RING_TEST_SIZE_B - 1; i++)
+  {
+    if (out[i] != in[i + 1])
+    {
+      ret = TEST_ERROR;
+    }
+  }
+
+  free_words( (int32_t*)storage );
+  return ret;
+}
+
+int8_t test_gather()
+{
+  size_t i, k;
+  size_t length;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * frame;
+  uint8_t * packed;
+  uint8_t field[4];
+  mem_cursor_t cursor;
+  mem_seg_t segs[4];
+
+  PRINTF("test_gather()\n");
+  frame = (uint8_t*)reserve_words(GATHER_TEST_SIZE_W);
+  packed = (uint8_t*)reserve_words(GATHER_TEST_SIZE_W);
+  if (! frame || ! packed)
+  {
+    free_words( (int32_t*)frame );
+    free_words( (int32_t*)packed );
+    return TEST_ERROR;
+  }
+  for (i = 0; i < GATHER_TEST_SIZE_B; i++)
+  {
+    frame[i] = (uint8_t)i;
+  }
+
+  /* Bytes 0-4, nothing, 20-30 and 40-55 of the frame */
+  segs[0].ptr = frame;
+  segs[0].length = 5;
+  segs[1].ptr = frame + 10;
+  segs[1].length = 0;
+  segs[2].ptr = frame + 20;
+  segs[2].length = 11;
+  segs[3].ptr = frame + 40;
+  segs[3].length = 16;
+
+  if ((mem_seg_total(segs, 4) != GATHER_TEST_TOTAL_B) ||
+      (my_gather(segs, 4, packed) != GATHER_TEST_TOTAL_B))
+  {
+    ret = TEST_ERROR;
+  }
+  for (i = 0, k = 0; i < 4; i++)
+  {
+    for (length = 0; length < segs[i].length; length++, k++)
+    {
+      if (packed[k] != segs[i].ptr[length])
+      {
+        ret = TEST_ERROR;
+      }
+    }
+  }
+
+  /* Scattering back lands in the segments and leaves the gaps alone */
+  for (k = 0; k < GATHER_TEST_TOTAL_B; k++)
+  {
+    packed[k] = (uint8_t)(0x80 + k);
+  }
+  if (my_scatter(packed, segs, 4) != GATHER_TEST_TOTAL_B)
+  {
+    ret = TEST_ERROR;
+  }
+  for (i = 0, k = 0; i < GATHER_TEST_SIZE_B; i++)
+  {
+    if ((i < 5) || ((i >= 20) && (i < 31)) || ((i >= 40) && (i < 56)))
+    {
+      if (frame[i] != (uint8_t)(0x80 + k))
+      {
+        ret = TEST_ERROR;
+      }
+      k++;
+    }
+    else if (frame[i] != (uint8_t)i)
+    {
+      ret = TEST_ERROR;
+    }
+  }
+
+  /* A field straddling segments 0 and 2 cannot be peeked, only read */
+  mem_cursor_init(&cursor, segs, 4);
+  if ((mem_cursor_peek(&cursor, 3) != frame) ||
+      (mem_cursor_read(&cursor, (uint8_t *)0, 3) != 3) ||
+      mem_cursor_peek(&cursor, 4) ||
+      (mem_cursor_read(&cursor, field, 4) != 4) ||
+      (field[0] != frame[3]) || (field[1] != frame[4]) ||
+      (field[2] != frame[20]) || (field[3] != frame[21]))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* The rest comes out a segment at a time */
+  if ((mem_cursor_peek(&cursor, 9) != frame + 22) ||
+      (mem_cursor_next(&cursor, GATHER_TEST_SIZE_B, &length) != frame + 22) ||
+      (length != 9) ||
+      (mem_cursor_next(&cursor, GATHER_TEST_SIZE_B, &length) != frame + 40) ||
+      (length != 16) ||
+      mem_cursor_next(&cursor, GATHER_TEST_SIZE_B, &length) ||
+      mem_cursor_read(&cursor, field, 1))
+  {
+    ret = TEST_ERROR;
+  }
+
+  free_words( (int32_t*)frame );
+  free_words( (int32_t*)packed );
+  return ret;
+}
+
+int8_t test_reserve_aligned()
+{
+  size_t i;
+  size_t align;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * ptr;
+  const size_t sizes[3] = { 1, 13, 200 };
+
+  PRINTF("test_reserve_aligned()\n");
+  for (align = 1; align <= ALIGNED_TEST_MAX_ALIGN; align <<= 1)
+  {
+    for (i = 0; i < 3; i++)
+    {
+      ptr = reserve_aligned(sizes[i], align, MEM_ALIGNED_DEFAULT);
+      if (! ptr || ((uintptr_t)ptr & (align - 1)))
+      {
+        ret = TEST_ERROR;
+      }
+      if (ptr)
+      {
+        my_memset(ptr, sizes[i], 0xA5);
+      }
+      free_aligned(ptr);
+    }
+  }
+
+  if (reserve_aligned(16, 0, MEM_ALIGNED_DEFAULT) ||
+      reserve_aligned(16, 24, MEM_ALIGNED_DEFAULT))
+  {
+    ret = TEST_ERROR;
+  }
+
+#if defined(HOST)
+  /* Large enough to be mapped instead of taken from the heap */
+  ptr = reserve_aligned(MEM_ALIGNED_MAP_THRESHOLD, 4096,
+                        MEM_ALIGNED_DEFAULT);
+  if (! ptr || ((uintptr_t)ptr & 4095))
+  {
+    ret = TEST_ERROR;
+  }
+  if (ptr)
+  {
+    my_memset(ptr, MEM_ALIGNED_MAP_THRESHOLD, 0xA5);
+  }
+  free_aligned(ptr);
+#endif
+
+  return ret;
+}
+
+int8_t test_swap()
+{
+  size_t i, w;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * src;
+  uint8_t * dst;
+  uint8_t * same;
+  uint8_t * (*swaps[3])(uint8_t *, uint8_t *, size_t) =
+    { swap16_array, swap32_array, swap64_array };
+
+  PRINTF("test_swap()\n");
+  src = (uint8_t*)reserve_words(SWAP_TEST_SIZE_W);
+  dst = (uint8_t*)reserve_words(SWAP_TEST_SIZE_W);
+  same = (uint8_t*)reserve_words(SWAP_TEST_SIZE_W);
+  if (! src || ! dst || ! same)
+  {
+    free_words( (int32_t*)src );
+    free_words( (int32_t*)dst );
+    free_words( (int32_t*)same );
+    return TEST_ERROR;
+  }
+
+  /* Values of 2, 4 and 8 bytes, all one byte off alignment */
+  for (w = 0; w < 3; w++)
+  {
+    for (i = 0; i < SWAP_TEST_LENGTH; i++)
+    {
+      src[i + 1] = (uint8_t)i;
+      same[i + 1] = (uint8_t)i;
+    }
+    if ((swaps[w](src + 1, dst + 1, SWAP_TEST_LENGTH >> (w + 1)) !=
+         dst + 1) ||
+        (swaps[w](same + 1, same + 1, SWAP_TEST_LENGTH >> (w + 1)) !=
+         same + 1))
+    {
+      ret = TEST_ERROR;
+    }
+    for (i = 0; i < SWAP_TEST_LENGTH; i++)
+    {
+      /* Byte j of a value of 2 << w bytes came from byte size - 1 - j */
+      if ((dst[i + 1] != (uint8_t)(i ^ ((2u << w) - 1))) ||
+          (same[i + 1] != dst[i + 1]))
+      {
+        ret = TEST_ERROR;
+      }
+    }
+  }
+
+  free_words( (int32_t*)src );
+  free_words( (int32_t*)dst );
+  free_words( (int32_t*)same );
+  return ret;
+}
+
+int8_t test_rotate()
+{
+  size_t i, s;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * set;
+  const size_t shifts[6] = { 0, 1, ROTATE_TEST_LENGTH, 40, 90,
+                             2 * ROTATE_TEST_LENGTH + 33 };
+
+  PRINTF("test_rotate()\n");
+  set = (uint8_t*)reserve_words(ROTATE_TEST_SIZE_W);
+  if (! set )
+  {
+    return TEST_ERROR;
+  }
+
+  for (s = 0; s < 6; s++)
+  {
+    for (i = 0; i < ROTATE_TEST_LENGTH; i++)
+    {
+      set[i] = (uint8_t)i;
+    }
+    if (my_rotate(set, ROTATE_TEST_LENGTH, shifts[s]) != set)
+    {
+      ret = TEST_ERROR;
+    }
+    for (i = 0; i < ROTATE_TEST_LENGTH; i++)
+    {
+      if (set[i] != (uint8_t)((i + shifts[s]) % ROTATE_TEST_LENGTH))
+      {
+        ret = TEST_ERROR;
+      }
+    }
+  }
+
+  free_words( (int32_t*)set );
+  return ret;
+}
+
+int8_t test_interleave()
+{
+  size_t c, f, b, w, channels;
+  size_t length;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * src;
+  uint8_t * dst;
+  uint8_t * planes;
+  uint8_t * chans[4];
+
+  PRINTF("test_interleave()\n");
+  src = (uint8_t*)reserve_words(INTERLEAVE_TEST_SIZE_W);
+  dst = (uint8_t*)reserve_words(INTERLEAVE_TEST_SIZE_W);
+  planes = (uint8_t*)reserve_words(INTERLEAVE_TEST_SIZE_W);
+  if (! src || ! dst || ! planes)
+  {
+    free_words( (int32_t*)src );
+    free_words( (int32_t*)dst );
+    free_words( (int32_t*)planes );
+    return TEST_ERROR;
+  }
+
+  for (channels = 2; channels <= 4; channels++)
+  {
+    for (w = 1; w <= 4; w <<= 1)
+    {
+      length = channels * INTERLEAVE_TEST_FRAMES * w;
+      for (c = 0; c < channels; c++)
+      {
+        chans[c] = planes + c * INTERLEAVE_TEST_FRAMES * w;
+      }
+      for (b = 0; b < length; b++)
+      {
+        src[b] = (uint8_t)(b * 7 + 3);
+      }
+
+      my_deinterleave(src, chans, channels, INTERLEAVE_TEST_FRAMES, w);
+      for (c = 0; c < channels; c++)
+      {
+        for (f = 0; f < INTERLEAVE_TEST_FRAMES; f++)
+        {
+          for (b = 0; b < w; b++)
+          {
+            if (chans[c][f * w + b] != src[(f * channels + c) * w + b])
+            {
+              ret = TEST_ERROR;
+            }
+          }
+        }
+      }
+
+      my_memzero(dst, length);
+      my_interleave(chans, dst, channels, INTERLEAVE_TEST_FRAMES, w);
+      if (my_memcmp(src, dst, length))
+      {
+        ret = TEST_ERROR;
+      }
+    }
+  }
+
+  free_words( (int32_t*)src );
+  free_words( (int32_t*)dst );
+  free_words( (int32_t*)planes );
+  return ret;
+}
+
+int8_t test_memcopy2d()
+{
+  size_t i, r, x;
+  size_t src_pitch, dst_pitch, width;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * src;
+  uint8_t * dst;
+  const size_t widths[4] = { 4, 5, COPY2D_TEST_DST_PITCH - 1, 12 };
+
+  PRINTF("test_memcopy2d()\n");
+  src = (uint8_t*)reserve_words(COPY2D_TEST_SIZE_W);
+  dst = (uint8_t*)reserve_words(COPY2D_TEST_SIZE_W);
+  if (! src || ! dst)
+  {
+    free_words( (int32_t*)src );
+    free_words( (int32_t*)dst );
+    return TEST_ERROR;
+  }
+  for (i = 0; i < COPY2D_TEST_SIZE_W * 4; i++)
+  {
+    src[i] = (uint8_t)i;
+  }
+
+  /* The last width is copied with both pitches equal to it */
+  for (i = 0; i < 4; i++)
+  {
+    width = widths[i];
+    src_pitch = (i < 3) ? COPY2D_TEST_SRC_PITCH : width;
+    dst_pitch = (i < 3) ? COPY2D_TEST_DST_PITCH : width;
+    my_memset(dst, COPY2D_TEST_SIZE_W * 4, 0xEE);
+    if (my_memcopy2d(src, src_pitch, dst, dst_pitch, width,
+                     COPY2D_TEST_HEIGHT) != dst)
+    {
+      ret = TEST_ERROR;
+    }
+
+    for (r = 0; r < COPY2D_TEST_HEIGHT; r++)
+    {
+      for (x = 0; x < dst_pitch; x++)
+      {
+        if (dst[r * dst_pitch + x] !=
+            ((x < width) ? src[r * src_pitch + x] : 0xEE))
+        {
+          ret = TEST_ERROR;
+        }
+      }
+    }
+  }
+
+  free_words( (int32_t*)src );
+  free_words( (int32_t*)dst );
+  return ret;
+}
+
+int8_t test_pool()
+{
+  size_t i;
+  int8_t ret = TEST_NO_ERROR;
+  int32_t * block;
+  int32_t local;
+  const size_t lengths[6] = { 1, POOL_MIN_BLOCK_W, POOL_MIN_BLOCK_W + 1,
+                              9, 17, POOL_MAX_BLOCK_W };
+  const size_t classes[6] = { 4, 4, 8, 16, 32, 32 };
+
+  PRINTF("test_pool()\n");
+  for (i = 0; i < 6; i++)
+  {
+    block = pool_reserve(lengths[i]);
+    if (! block || ! pool_owns(block) ||
+        (pool_block_words(block) != classes[i]) ||
+        ((uintptr_t)block & (classes[i] * sizeof(int32_t) - 1)))
+    {
+      ret = TEST_ERROR;
+      continue;
+    }
+
+    /* The block just released is the first one handed out again */
+    pool_release(block);
+    if (pool_reserve(lengths[i]) != block)
+    {
+      ret = TEST_ERROR;
+    }
+    pool_release(block);
+  }
+
+  /* Alignments are met by picking a larger class */
+  block = pool_reserve_aligned(1, 64);
+  if (! block || (pool_block_words(block) != 16) ||
+      ((uintptr_t)block & 63))
+  {
+    ret = TEST_ERROR;
+  }
+  if (block)
+  {
+    pool_release(block);
+  }
+
+  if (pool_reserve(0) || pool_reserve(POOL_MAX_BLOCK_W + 1) ||
+      pool_owns(&local))
+  {
+    ret = TEST_ERROR;
+  }
+
+  return ret;
+}
+
+int8_t test_dma()
+{
+  size_t i;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * src;
+  uint8_t * dst;
+  dma_desc_t desc[DMA_MAX_INFLIGHT][2];
+  dma_handle_t handles[DMA_MAX_INFLIGHT];
+
+  PRINTF("test_dma()\n");
+  src = (uint8_t*)reserve_words(DMA_TEST_SIZE_W);
+  dst = (uint8_t*)reserve_words(DMA_TEST_SIZE_W);
+  if (! src || ! dst)
+  {
+    free_words( (int32_t*)src );
+    free_words( (int32_t*)dst );
+    return TEST_ERROR;
+  }
+  for (i = 0; i < DMA_TEST_SIZE_B; i++)
+  {
+    src[i] = (uint8_t)(i + 1);
+  }
+  my_memzero(dst, DMA_TEST_SIZE_B);
+
+  if ((dma_copy_poll(DMA_INVALID_HANDLE) != DMA_COPY_INVALID) ||
+      (dma_copy_wait(DMA_INVALID_HANDLE) != DMA_COPY_INVALID))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Nothing is in flight, so every slot takes a chain */
+  for (i = 0; i < DMA_MAX_INFLIGHT; i++)
+  {
+    desc[i][0].src = src + i * DMA_TEST_SLICE_B;
+    desc[i][0].dst = dst + i * DMA_TEST_SLICE_B;
+    desc[i][0].length = 13;
+    desc[i][0].next = &desc[i][1];
+    desc[i][1].src = desc[i][0].src + 13;
+    desc[i][1].dst = desc[i][0].dst + 13;
+    desc[i][1].length = DMA_TEST_SLICE_B - 13;
+    desc[i][1].next = (dma_desc_t *)0;
+    handles[i] = dma_copy_submit(desc[i]);
+    if (handles[i] == DMA_INVALID_HANDLE)
+    {
+      ret = TEST_ERROR;
+    }
+  }
+  if (dma_copy_poll(handles[DMA_MAX_INFLIGHT - 1] + 1) != DMA_COPY_INVALID)
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Chains complete in order, so the last one done means all are */
+  if (dma_copy_wait(handles[DMA_MAX_INFLIGHT - 1]) != DMA_COPY_DONE)
+  {
+    ret = TEST_ERROR;
+  }
+  for (i = 0; i < DMA_MAX_INFLIGHT; i++)
+  {
+    if ((dma_copy_poll(handles[i]) != DMA_COPY_DONE) ||
+        (dma_copy_wait(handles[i]) != DMA_COPY_DONE))
+    {
+      ret = TEST_ERROR;
+    }
+  }
+  if (my_memcmp(src, dst, DMA_TEST_SIZE_B))
+  {
+    ret = TEST_ERROR;
+  }
+
+  dma_shutdown();
+  free_words( (int32_t*)src );
+  free_words( (int32_t*)dst );
+  return ret;
+}
+
+#if defined(MEMORY_STATS)
+int8_t test_memory_stats()
+{
+  int8_t ret = TEST_NO_ERROR;
+  int32_t * small;
+  int32_t * large;
+  mem_stats_t before;
+  mem_stats_t stats;
+  const size_t small_b = STATS_TEST_SMALL_W * sizeof(int32_t);
+  const size_t large_b = STATS_TEST_LARGE_W * sizeof(int32_t);
+
+  PRINTF("test_memory_stats()\n");
+  memory_stats_reset();
+  memory_stats_snapshot(&before);
+  if ((before.peak_bytes != before.live_bytes) || before.reserve_calls)
+  {
+    ret = TEST_ERROR;
+  }
+
+  small = reserve_words(STATS_TEST_SMALL_W);
+  large = reserve_words(STATS_TEST_LARGE_W);
+  memory_stats_snapshot(&stats);
+  if (! small || ! large ||
+      (stats.live_bytes != before.live_bytes + small_b + large_b) ||
+      (stats.peak_bytes != stats.live_bytes) ||
+      (stats.reserve_calls != 2) ||
+      (stats.histogram[8] != 1) || (stats.histogram[11] != 1))
+  {
+    ret = TEST_ERROR;
+  }
+
+  /* Freeing lowers the live bytes but not the peak */
+  free_words(small);
+  memory_stats_snapshot(&stats);
+  if ((stats.live_bytes != before.live_bytes + large_b) ||
+      (stats.peak_bytes != before.live_bytes + small_b + large_b) ||
+      (stats.free_calls != 1))
+  {
+    ret = TEST_ERROR;
+  }
+
+  free_words(large);
+  memory_stats_snapshot(&stats);
+  if ((stats.live_bytes != before.live_bytes) ||
+      (stats.peak_bytes != before.live_bytes + small_b + large_b) ||
+      (stats.free_calls != 2) || stats.failed_calls)
+  {
+    ret = TEST_ERROR;
+  }
+
+  return ret;
+}
+#endif
+
+#if defined(HOST)
+int8_t test_parallel_reinit()
+{
+  size_t i, round;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * src;
+  uint8_t * dst;
+  uint8_t * old;
+
+  PRINTF("test_parallel_reinit()\n");
+  src = (uint8_t*)reserve_words(PARALLEL_TEST_SIZE_W);
+  dst = (uint8_t*)reserve_words(PARALLEL_TEST_SIZE_W);
+  old = (uint8_t*)reserve_words(PARALLEL_TEST_SIZE_W);
+  if (! src || ! dst || ! old)
+  {
+    free_words( (int32_t*)src );
+    free_words( (int32_t*)dst );
+    free_words( (int32_t*)old );
+    return TEST_ERROR;
+  }
+
+  /* Every copy goes through the pool, which is restarted before each */
+  memory_parallel_set_cutoff(0);
+  for (round = 0; (round < PARALLEL_TEST_ROUNDS) && !ret; round++)
+  {
+    my_memset(src, PARALLEL_TEST_SIZE_B, (uint8_t)(round + 1));
+    my_memcopy_parallel(src, old, PARALLEL_TEST_SIZE_B);
+    my_memzero(old, PARALLEL_TEST_SIZE_B);
+    my_memset(src, PARALLEL_TEST_SIZE_B, 0xA5);
+
+    /* A new worker replaying the old job would write into old again */
+    if (! memory_parallel_init(PARALLEL_TEST_THREADS))
+    {
+      ret = TEST_ERROR;
+      break;
+    }
+    my_memcopy_parallel(src, dst, PARALLEL_TEST_SIZE_B);
+
+    for (i = 0; i < PARALLEL_TEST_SIZE_B; i++)
+    {
+      if ((dst[i] != 0xA5) || (old[i] != 0))
+      {
+        ret = TEST_ERROR;
+        break;
+      }
+    }
+  }
+  memory_parallel_set_cutoff(MEMORY_PARALLEL_CUTOFF_DEFAULT);
+  memory_parallel_shutdown();
+
+  free_words( (int32_t*)src );
+  free_words( (int32_t*)dst );
+  free_words( (int32_t*)old );
+  return ret;
+}
+
+/* Frees the blocks test_tcache_cross_thread reserved on the main thread */
+static void * free_blocks(void * arg)
+{
+  int32_t ** blocks = (int32_t **)arg;
+  size_t i;
+
+  for (i = 0; i < POOL_BLOCKS_PER_CLASS; i++)
+  {
+    free_words(blocks[i]);
+  }
+  return (void *)0;
+}
+
+int8_t test_tcache_cross_thread()
+{
+  int32_t * first[POOL_BLOCKS_PER_CLASS];
+  int32_t * again[POOL_BLOCKS_PER_CLASS];
+  int32_t * block;
+  pthread_t thread;
+  size_t i, j, seen;
+  int8_t ret = TEST_NO_ERROR;
+
+  PRINTF("test_tcache_cross_thread()\n");
+  /* No other test uses the largest class, so all of it is handed out */
+  for (i = 0; i < POOL_BLOCKS_PER_CLASS; i++)
+  {
+    first[i] = reserve_words(POOL_MAX_BLOCK_W);
+    if (! first[i] || ! pool_owns(first[i]))
+    {
+      ret = TEST_ERROR;
+    }
+  }
+  if (ret || pthread_create(&thread, NULL, free_blocks, first))
+  {
+    for (i = 0; i < POOL_BLOCKS_PER_CLASS; i++)
+    {
+      free_words(first[i]);
+    }
+    return TEST_ERROR;
+  }
+  pthread_join(thread, NULL);
+
+  /* The exiting thread flushed its cache, so the pool has them back */
+  block = pool_reserve(POOL_MAX_BLOCK_W);
+  if (! block)
+  {
+    ret = TEST_ERROR;
+  }
+  else
+  {
+    pool_release(block);
+  }
+
+  /* Each freed block comes back exactly once */
+  for (i = 0; i < POOL_BLOCKS_PER_CLASS; i++)
+  {
+    again[i] = reserve_words(POOL_MAX_BLOCK_W);
+    seen = 0;
+    for (j = 0; j < POOL_BLOCKS_PER_CLASS; j++)
+    {
+      seen += (again[i] == first[j]);
+    }
+    for (j = 0; j < i; j++)
+    {
+      seen += 2 * (again[i] == again[j]);
+    }
+    if (seen != 1)
+    {
+      ret = TEST_ERROR;
+    }
+  }
+
+  for (i = 0; i < POOL_BLOCKS_PER_CLASS; i++)
+  {
+    free_words(again[i]);
+  }
+  return ret;
+}
+
+/* Writes every byte of a STACK_TEST_PROBE_B array on the stack */
+static void stack_probe(void * arg)
+{
+  volatile uint8_t buffer[STACK_TEST_PROBE_B];
+  size_t i;
+
+  for (i = 0; i < STACK_TEST_PROBE_B; i++)
+  {
+    buffer[i] = (uint8_t)i;
+  }
+  *(uint8_t *)arg = buffer[STACK_TEST_PROBE_B - 1];
+}
+
+int8_t test_stack_measure()
+{
+  uint8_t last = 0;
+  size_t used;
+
+  PRINTF("test_stack_measure()\n");
+  used = stack_measure(stack_probe, &last, STACK_TEST_SIZE_B);
+  #ifdef VERBOSE
+  PRINTF("  Probe of %d bytes used %zu bytes\n", STACK_TEST_PROBE_B, used);
+  #endif
+
+  /* The array plus a frame, nowhere near the whole stack */
+  if ((used < STACK_TEST_PROBE_B) ||
+      (used > STACK_TEST_PROBE_B + STACK_TEST_SLACK_B) ||
+      (last != (uint8_t)(STACK_TEST_PROBE_B - 1)))
+  {
+    return TEST_ERROR;
+  }
+  return TEST_NO_ERROR;
+}
+
+int8_t test_mpmc()
+{
+  size_t i;
+  uint8_t next = 0;
+  uint8_t expect = 0;
+  int8_t ret = TEST_NO_ERROR;
+  mpmc_queue_t queue;
+  uint8_t slot[MPMC_TEST_SLOT_B];
+
+  PRINTF("test_mpmc()\n");
+  if (mpmc_init(&queue, MPMC_TEST_CAPACITY - 1, MPMC_TEST_SLOT_B) ||
+      mpmc_init(&queue, 0, MPMC_TEST_SLOT_B) ||
+      ! mpmc_init(&queue, MPMC_TEST_CAPACITY, MPMC_TEST_SLOT_B))
+  {
+    return TEST_ERROR;
+  }
+
+  /* Full after capacity pushes */
+  for (i = 0; i <= MPMC_TEST_CAPACITY; i++)
+  {
+    my_memset(slot, MPMC_TEST_SLOT_B, next);
+    if (mpmc_push(&queue, slot) != (i < MPMC_TEST_CAPACITY))
+    {
+      ret = TEST_ERROR;
+    }
+    next += (i < MPMC_TEST_CAPACITY);
+  }
+
+  /* Half out, then the freed cells are refilled on the next lap */
+  for (i = 0; i < MPMC_TEST_CAPACITY / 2; i++)
+  {
+    if (! mpmc_pop(&queue, slot) || (slot[0] != expect) ||
+        (slot[MPMC_TEST_SLOT_B - 1] != expect))
+    {
+      ret = TEST_ERROR;
+    }
+    expect++;
+  }
+  for (i = 0; i < MPMC_TEST_CAPACITY / 2; i++)
+  {
+    my_memset(slot, MPMC_TEST_SLOT_B, next++);
+    if (! mpmc_push(&queue, slot))
+    {
+      ret = TEST_ERROR;
+    }
+  }
+
+  /* Everything left comes out in order, then the queue is empty */
+  while (mpmc_pop(&queue, slot))
+  {
+    if ((slot[0] != expect) || (slot[MPMC_TEST_SLOT_B - 1] != expect))
+    {
+      ret = TEST_ERROR;
+    }
+    expect++;
+  }
+  if (expect != next)
+  {
+    ret = TEST_ERROR;
+  }
+
+  mpmc_destroy(&queue);
+  return ret;
+}
+
+int8_t test_memzero_remap()
+{
+  size_t i, b;
+  int8_t ret = TEST_NO_ERROR;
+  uint8_t * buffer;
+  const size_t sizes[2] = { MEM_ALIGNED_MAP_THRESHOLD,
+                            4 * REMAP_TEST_THRESHOLD };
+  size_t threshold = my_memzero_get_remap_threshold();
+
+  PRINTF("test_memzero_remap()\n");
+  my_memzero_set_remap_threshold(REMAP_TEST_THRESHOLD);
+
+  /* The first buffer is mapped on its own pages, the second is not */
+  for (b = 0; b < 2; b++)
+  {
+    buffer = reserve_aligned(sizes[b], 64, MEM_ALIGNED_DEFAULT);
+    if (! buffer )
+    {
+      ret = TEST_ERROR;
+      continue;
+    }
+    my_memset(buffer, sizes[b], 0xA5);
+    my_memzero(buffer + REMAP_TEST_HEAD_B,
+               sizes[b] - REMAP_TEST_HEAD_B - REMAP_TEST_TAIL_B);
+    for (i = 0; i < sizes[b]; i++)
+    {
+      if (buffer[i] != (((i < REMAP_TEST_HEAD_B) ||
+                         (i >= sizes[b] - REMAP_TEST_TAIL_B)) ? 0xA5 : 0))
+      {
+        ret = TEST_ERROR;
+        break;
+      }
+    }
+    free_aligned(buffer);
+  }
+
+  my_memzero_set_remap_threshold(threshold);
+  return ret;
+}
+#endif
+
+#ifdef MEMORY_STATS
+/* Runs one test and prints the reserve_words traffic it caused */
+static int8_t run_test(int8_t (*test)(void))
+{
+  mem_stats_t stats;
+  int8_t ret;
+
+  memory_stats_reset();
+  ret = test();
+  memory_stats_snapshot(&stats);
+  PRINTF("  Memory: %zu reserved, %zu freed, peak %zu bytes, %zu live\n",
+         stats.reserve_calls, stats.free_calls, stats.peak_bytes,
+         stats.live_bytes);
+
+  return ret;
+}
+#define RUN_TEST(test) run_test(test)
+#else
+#define RUN_TEST(test) test()
+#endif
+
 void course1(void) 
 {
   uint8_t i;
+  uint8_t n = 0;
   int8_t failed = 0;
   int8_t results[TESTCOUNT];
 
-  results[0] = test_data1();
-  results[1] = test_data2();
-  results[2] = test_memmove1();
-  results[3] = test_memmove2();
-  results[4] = test_memmove3();
-  results[5] = test_memcopy();
-  results[6] = test_memset();
-  results[7] = test_reverse();
+  results[n++] = RUN_TEST(test_data1);
+  results[n++] = RUN_TEST(test_data2);
+  results[n++] = RUN_TEST(test_memmove1);
+  results[n++] = RUN_TEST(test_memmove2);
+  results[n++] = RUN_TEST(test_memmove3);
+  results[n++] = RUN_TEST(test_memcopy);
+  results[n++] = RUN_TEST(test_memset);
+  results[n++] = RUN_TEST(test_reverse);
+  results[n++] = RUN_TEST(test_arena);
+  results[n++] = RUN_TEST(test_search);
+  results[n++] = RUN_TEST(test_checksum);
+  results[n++] = RUN_TEST(test_memcopy_checksum);
+  results[n++] = RUN_TEST(test_ringbuf);
+  results[n++] = RUN_TEST(test_gather);
+  results[n++] = RUN_TEST(test_reserve_aligned);
+  results[n++] = RUN_TEST(test_swap);
+  results[n++] = RUN_TEST(test_rotate);
+  results[n++] = RUN_TEST(test_interleave);
+  results[n++] = RUN_TEST(test_memcopy2d);
+  results[n++] = RUN_TEST(test_pool);
+  results[n++] = RUN_TEST(test_dma);
+#if defined(MEMORY_STATS)
+  results[n++] = RUN_TEST(test_memory_stats);
+#endif
+#if defined(HOST)
+  results[n++] = RUN_TEST(test_parallel_reinit);
+  results[n++] = RUN_TEST(test_tcache_cross_thread);
+  results[n++] = RUN_TEST(test_stack_measure);
+  results[n++] = RUN_TEST(test_mpmc);
+  results[n++] = RUN_TEST(test_memzero_remap);
+#endif
 
   for ( i = 0; i < TESTCOUNT; i++) 
   {
@@ -0,0 +1,552 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file crc32.c
+ * @brief Streaming CRC-32 and Adler-32 over arbitrary-length buffers
+ *
+ * The running state is the bit-reflected CRC register, preset to all
+ * ones and inverted by crc32_final. Every update hands the state to
+ * the engine and takes it back, so any number of checksums can be in
+ * progress at once.
+ *
+ * On the MSP432 the state is loaded as the seed of the CRC32 module,
+ * whose CRC32DI input takes data LSB first (the reflected algorithm).
+ * On the HOST the bytes are folded eight at a time with slicing-by-8
+ * tables built at startup, and on x86 CPUs with PCLMULQDQ everything
+ * from 64 bytes up is folded with carry-less multiplies instead.
+ * (The SSE4.2 crc32 instruction computes CRC-32C, a different
+ * polynomial, so it cannot be used here.)
+ *
+ * Adler-32 is summed a word at a time, or with SSSE3 32-byte blocks on
+ * x86 HOST builds. Every engine can store the bytes it reads to a
+ * second buffer, which gives the fused copy-and-checksum of
+ * my_memcopy_crc32 and my_memcopy_adler32 (see memory.h).
+ *
+ * @author Mahmoud Hamdy
+ * @date October 19 2020
+ *
+ */
+#include "crc32.h"
+#include "platform.h"
+
+#if defined(HOST) && (defined(__x86_64__) || defined(__i386__))
+#define CRC32_X86
+#include <immintrin.h>
+#endif
+
+/* Reflected IEEE 802.3 polynomial */
+#define CRC32_POLY  (0xEDB88320u)
+
+#if defined(MSP432)
+/***********************************************************
+ CRC32 Peripheral (MSP432)
+***********************************************************/
+typedef uint16_t __attribute__((__may_alias__)) crc32_half_t;
+
+typedef uint16_t __attribute__((__may_alias__, __aligned__(1))) crc32_uhalf_t;
+
+/*
+ * A halfword written to CRC32DI is taken low byte first, the same as
+ * two byte writes in memory order, so the body is fed 16 bits at a
+ * time. The result register reads back in the form the seed takes.
+ * With dst set every halfword is stored there as well, straight from
+ * the register that fed the peripheral.
+ */
+static uint32_t crc32_run(uint32_t state, uint8_t * dst, const uint8_t * src,
+                          size_t length)
+{
+  uint16_t half;
+
+  CRC32->INIRES32_LO = (uint16_t)state;
+  CRC32->INIRES32_HI = (uint16_t)(state >> 16);
+
+  if(length && ((uintptr_t)src & 1))
+  {
+    *(volatile uint8_t *)&CRC32->DI32 = *src;
+    if(dst)
+    {
+      *dst++ = *src;
+    }
+    src++;
+    length--;
+  }
+
+  for(; length >= 2; length -= 2)
+  {
+    half = *(const crc32_half_t *)src;
+    CRC32->DI32 = half;
+    if(dst)
+    {
+      *(crc32_uhalf_t *)dst = half;
+      dst += 2;
+    }
+    src += 2;
+  }
+
+  if(length)
+  {
+    *(volatile uint8_t *)&CRC32->DI32 = *src;
+    if(dst)
+    {
+      *dst = *src;
+    }
+  }
+
+  return CRC32->INIRES32_LO | ((uint32_t)CRC32->INIRES32_HI << 16);
+}
+#else
+/***********************************************************
+ Slicing-by-8 Tables (HOST)
+***********************************************************/
+typedef uint32_t __attribute__((__may_alias__)) crc32_word_t;
+typedef uint32_t __attribute__((__may_alias__, __aligned__(1))) crc32_uword_t;
+
+/* crc32_table[k][n] is the CRC of byte n followed by k zero bytes */
+static uint32_t crc32_table[8][256];
+
+__attribute__((__constructor__))
+static void crc32_table_init(void)
+{
+  uint32_t c;
+  uint32_t n, k;
+
+  for(n = 0; n < 256; n++)
+  {
+    c = n;
+    for(k = 0; k < 8; k++)
+    {
+      c = (c >> 1) ^ (CRC32_POLY & (0u - (c & 1)));
+    }
+    crc32_table[0][n] = c;
+  }
+
+  for(n = 0; n < 256; n++)
+  {
+    for(k = 1; k < 8; k++)
+    {
+      c = crc32_table[k - 1][n];
+      crc32_table[k][n] = (c >> 8) ^ crc32_table[0][c & 0xFF];
+    }
+  }
+}
+
+/*
+ * Bytes until src is 8-byte aligned, then eight bytes per step: the
+ * state is folded into the first word (little-endian host) and each
+ * byte looked up in the table for its distance from the end. With
+ * dst set the loaded words are also stored there.
+ */
+static uint32_t crc32_run(uint32_t state, uint8_t * dst, const uint8_t * src,
+                          size_t length)
+{
+  uint32_t lo, hi;
+
+  for(; length && ((uintptr_t)src & 7); length--)
+  {
+    if(dst)
+    {
+      *dst++ = *src;
+    }
+    state = (state >> 8) ^ crc32_table[0][(state ^ *src++) & 0xFF];
+  }
+
+  for(; length >= 8; length -= 8)
+  {
+    lo = *(const crc32_word_t *)src;
+    hi = *(const crc32_word_t *)(src + 4);
+    if(dst)
+    {
+      *(crc32_uword_t *)dst = lo;
+      *(crc32_uword_t *)(dst + 4) = hi;
+      dst += 8;
+    }
+    lo ^= state;
+    state = crc32_table[7][lo & 0xFF] ^
+            crc32_table[6][(lo >> 8) & 0xFF] ^
+            crc32_table[5][(lo >> 16) & 0xFF] ^
+            crc32_table[4][lo >> 24] ^
+            crc32_table[3][hi & 0xFF] ^
+            crc32_table[2][(hi >> 8) & 0xFF] ^
+            crc32_table[1][(hi >> 16) & 0xFF] ^
+            crc32_table[0][hi >> 24];
+    src += 8;
+  }
+
+  for(; length; length--)
+  {
+    if(dst)
+    {
+      *dst++ = *src;
+    }
+    state = (state >> 8) ^ crc32_table[0][(state ^ *src++) & 0xFF];
+  }
+
+  return state;
+}
+
+#if defined(CRC32_X86)
+/***********************************************************
+ Carry-less Multiply Folding (x86 HOST)
+***********************************************************/
+#define CRC32_FOLD_MIN  (64)
+
+/*
+ * Four 128-bit lanes are folded forward 512 bits at a time by carry-
+ * less multiplication, merged into one lane, reduced to 64 bits and
+ * then Barrett-reduced to the 32-bit state. The constants are the
+ * bit-reflected x^n mod P values of Intel's "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ" paper. length must be at least
+ * CRC32_FOLD_MIN and a multiple of 16. With dst set every vector is
+ * stored there as soon as it is loaded.
+ */
+__attribute__((__target__("pclmul,sse4.1")))
+static uint32_t crc32_fold(uint32_t state, uint8_t * dst, const uint8_t * src,
+                           size_t length)
+{
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596ll, 0x0154442bd4ll);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009ell, 0x01751997d0ll);
+  const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124ll);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641ll, 0x01db710641ll);
+  const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+  __m128i x1, x2, x3, x4, t1, t2, t3, t4, y1, y2, y3, y4;
+
+  x1 = _mm_loadu_si128((const __m128i *)(src));
+  x2 = _mm_loadu_si128((const __m128i *)(src + 16));
+  x3 = _mm_loadu_si128((const __m128i *)(src + 32));
+  x4 = _mm_loadu_si128((const __m128i *)(src + 48));
+  if(dst)
+  {
+    _mm_storeu_si128((__m128i *)(dst), x1);
+    _mm_storeu_si128((__m128i *)(dst + 16), x2);
+    _mm_storeu_si128((__m128i *)(dst + 32), x3);
+    _mm_storeu_si128((__m128i *)(dst + 48), x4);
+    dst += 64;
+  }
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)state));
+  src += 64;
+  length -= 64;
+
+  for(; length >= 64; length -= 64)
+  {
+    y1 = _mm_loadu_si128((const __m128i *)(src));
+    y2 = _mm_loadu_si128((const __m128i *)(src + 16));
+    y3 = _mm_loadu_si128((const __m128i *)(src + 32));
+    y4 = _mm_loadu_si128((const __m128i *)(src + 48));
+    if(dst)
+    {
+      _mm_storeu_si128((__m128i *)(dst), y1);
+      _mm_storeu_si128((__m128i *)(dst + 16), y2);
+      _mm_storeu_si128((__m128i *)(dst + 32), y3);
+      _mm_storeu_si128((__m128i *)(dst + 48), y4);
+      dst += 64;
+    }
+    t1 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    t2 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    t3 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    t4 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, t1), y1);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, t2), y2);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, t3), y3);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, t4), y4);
+    src += 64;
+  }
+
+  /* Four lanes into one, then the remaining 16-byte blocks */
+  t1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), t1);
+  t1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), t1);
+  t1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), t1);
+
+  for(; length >= 16; length -= 16)
+  {
+    y1 = _mm_loadu_si128((const __m128i *)src);
+    if(dst)
+    {
+      _mm_storeu_si128((__m128i *)dst, y1);
+      dst += 16;
+    }
+    t1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, y1), t1);
+    src += 16;
+  }
+
+  /* 128 bits to 64 */
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  /* Barrett reduction to 32 bits */
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), poly, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, low32), poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+static uint8_t crc32_has_clmul;
+static uint8_t adler32_has_ssse3;
+
+__attribute__((__constructor__))
+static void crc32_dispatch_init(void)
+{
+  __builtin_cpu_init();
+  crc32_has_clmul = (__builtin_cpu_supports("pclmul") != 0) &&
+                    (__builtin_cpu_supports("sse4.1") != 0);
+  adler32_has_ssse3 = __builtin_cpu_supports("ssse3") != 0;
+}
+#endif
+#endif
+
+/***********************************************************
+ Adler-32 Engines
+***********************************************************/
+/* Largest prime below 2^16 */
+#define ADLER32_BASE  (65521u)
+
+/* Most bytes summed before b can overflow 32 bits */
+#define ADLER32_NMAX  (5552u)
+
+typedef uint32_t __attribute__((__may_alias__, __aligned__(1))) adler32_uword_t;
+
+/*
+ * Word at a time (little-endian), reducing modulo ADLER32_BASE once
+ * every ADLER32_NMAX bytes. With dst set each word is stored there
+ * from the register it is summed from.
+ */
+static uint32_t adler32_run(uint32_t adler, uint8_t * dst, const uint8_t * src,
+                            size_t length)
+{
+  uint32_t a = adler & 0xFFFF;
+  uint32_t b = adler >> 16;
+  uint32_t word;
+  size_t n;
+
+  while(length)
+  {
+    n = (length < ADLER32_NMAX) ? length : ADLER32_NMAX;
+    length -= n;
+
+    for(; n >= 4; n -= 4)
+    {
+      word = *(const adler32_uword_t *)src;
+      if(dst)
+      {
+        *(adler32_uword_t *)dst = word;
+        dst += 4;
+      }
+      a += word & 0xFF;
+      b += a;
+      a += (word >> 8) & 0xFF;
+      b += a;
+      a += (word >> 16) & 0xFF;
+      b += a;
+      a += word >> 24;
+      b += a;
+      src += 4;
+    }
+
+    for(; n; n--)
+    {
+      if(dst)
+      {
+        *dst++ = *src;
+      }
+      a += *src++;
+      b += a;
+    }
+
+    a %= ADLER32_BASE;
+    b %= ADLER32_BASE;
+  }
+
+  return (b << 16) | a;
+}
+
+#if defined(CRC32_X86)
+#define ADLER32_BLOCK (32)
+
+/*
+ * 32-byte blocks: PSADBW sums the bytes into a, PMADDUBSW weighs them
+ * by their distance from the end of the block into b, and every block
+ * also adds 32 times the a it started with to b (kept in ps, scaled at
+ * the end). Runs of at most ADLER32_NMAX bytes keep the lanes from
+ * overflowing. length must be a multiple of ADLER32_BLOCK.
+ */
+__attribute__((__target__("ssse3")))
+static uint32_t adler32_simd(uint32_t adler, uint8_t * dst, const uint8_t * src,
+                             size_t length)
+{
+  const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                     24, 23, 22, 21, 20, 19, 18, 17);
+  const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                     8, 7, 6, 5, 4, 3, 2, 1);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  uint32_t a = adler & 0xFFFF;
+  uint32_t b = adler >> 16;
+  __m128i v_a, v_b, v_ps, x1, x2;
+  size_t blocks;
+
+  while(length)
+  {
+    blocks = length / ADLER32_BLOCK;
+    if(blocks > ADLER32_NMAX / ADLER32_BLOCK)
+    {
+      blocks = ADLER32_NMAX / ADLER32_BLOCK;
+    }
+    length -= blocks * ADLER32_BLOCK;
+
+    v_ps = _mm_cvtsi32_si128((int)(a * blocks));
+    v_b = _mm_cvtsi32_si128((int)b);
+    v_a = zero;
+    while(blocks--)
+    {
+      x1 = _mm_loadu_si128((const __m128i *)(src));
+      x2 = _mm_loadu_si128((const __m128i *)(src + 16));
+      if(dst)
+      {
+        _mm_storeu_si128((__m128i *)(dst), x1);
+        _mm_storeu_si128((__m128i *)(dst + 16), x2);
+        dst += ADLER32_BLOCK;
+      }
+      v_ps = _mm_add_epi32(v_ps, v_a);
+      v_a = _mm_add_epi32(v_a, _mm_sad_epu8(x1, zero));
+      v_a = _mm_add_epi32(v_a, _mm_sad_epu8(x2, zero));
+      v_b = _mm_add_epi32(v_b, _mm_madd_epi16(_mm_maddubs_epi16(x1, tap1),
+                                              ones));
+      v_b = _mm_add_epi32(v_b, _mm_madd_epi16(_mm_maddubs_epi16(x2, tap2),
+                                              ones));
+      src += ADLER32_BLOCK;
+    }
+    v_b = _mm_add_epi32(v_b, _mm_slli_epi32(v_ps, 5));
+
+    /* Horizontal sums of the four lanes */
+    v_a = _mm_add_epi32(v_a, _mm_shuffle_epi32(v_a, _MM_SHUFFLE(1, 0, 3, 2)));
+    v_a = _mm_add_epi32(v_a, _mm_shuffle_epi32(v_a, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_b = _mm_add_epi32(v_b, _mm_shuffle_epi32(v_b, _MM_SHUFFLE(1, 0, 3, 2)));
+    v_b = _mm_add_epi32(v_b, _mm_shuffle_epi32(v_b, _MM_SHUFFLE(2, 3, 0, 1)));
+    a = (a + (uint32_t)_mm_cvtsi128_si32(v_a)) % ADLER32_BASE;
+    b = (uint32_t)_mm_cvtsi128_si32(v_b) % ADLER32_BASE;
+  }
+
+  return (b << 16) | a;
+}
+#endif
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void crc32_init(crc32_t * crc)
+{
+  crc->state = 0xFFFFFFFFu;
+}
+
+void crc32_update(crc32_t * crc, const uint8_t * src, size_t length)
+{
+  crc32_update_copy(crc, (uint8_t *)0, src, length);
+}
+
+void crc32_update_copy(crc32_t * crc, uint8_t * dst, const uint8_t * src,
+                       size_t length)
+{
+#if defined(CRC32_X86)
+  if(crc32_has_clmul && (length >= CRC32_FOLD_MIN))
+  {
+    crc->state = crc32_fold(crc->state, dst, src, length & ~(size_t)15);
+    src += length & ~(size_t)15;
+    if(dst)
+    {
+      dst += length & ~(size_t)15;
+    }
+    length &= 15;
+  }
+#endif
+
+  if(length)
+  {
+    crc->state = crc32_run(crc->state, dst, src, length);
+  }
+}
+
+uint32_t crc32_final(crc32_t * crc)
+{
+  return ~crc->state;
+}
+
+uint32_t crc32(const uint8_t * src, size_t length)
+{
+  crc32_t crc;
+
+  crc32_init(&crc);
+  crc32_update(&crc, src, length);
+
+  return crc32_final(&crc);
+}
+
+void adler32_init(adler32_t * adler)
+{
+  adler->state = 1;
+}
+
+void adler32_update(adler32_t * adler, const uint8_t * src, size_t length)
+{
+  adler32_update_copy(adler, (uint8_t *)0, src, length);
+}
+
+void adler32_update_copy(adler32_t * adler, uint8_t * dst, const uint8_t * src,
+                         size_t length)
+{
+#if defined(CRC32_X86)
+  size_t body = length - length % ADLER32_BLOCK;
+
+  if(adler32_has_ssse3 && body)
+  {
+    adler->state = adler32_simd(adler->state, dst, src, body);
+    src += body;
+    if(dst)
+    {
+      dst += body;
+    }
+    length -= body;
+  }
+#endif
+
+  if(length)
+  {
+    adler->state = adler32_run(adler->state, dst, src, length);
+  }
+}
+
+uint32_t adler32_final(adler32_t * adler)
+{
+  return adler->state;
+}
+
+uint32_t adler32(const uint8_t * src, size_t length)
+{
+  adler32_t adler;
+
+  adler32_init(&adler);
+  adler32_update(&adler, src, length);
+
+  return adler32_final(&adler);
+}
@@ -0,0 +1,469 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file dma.c
+ * @brief Asynchronous copy engine with a submit/poll/wait interface
+ *
+ * Submitted chains sit in a small ring indexed by their handle, a
+ * sequence number. Chains are run one after another, so a handle is
+ * done once the completed counter has reached it.
+ *
+ * On the MSP432 each chain is cut into uDMA tasks of at most 1024
+ * transfers (words when both ends are aligned, bytes otherwise). The
+ * tasks go through memory scatter-gather mode, DMA_MAX_TASKS at a
+ * time, and the DMA_INT0 interrupt moves on to the next batch or
+ * chain. On the HOST a worker thread plays the controller.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 18 2020
+ *
+ */
+#if defined(HOST)
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#endif
+
+#include "dma.h"
+#include "memory.h"
+#include "platform.h"
+
+static dma_desc_t * dma_queue[DMA_MAX_INFLIGHT];
+static volatile dma_handle_t dma_submitted;  /* Last handle handed out */
+static volatile dma_handle_t dma_completed;  /* Last handle completed */
+
+/*
+ * Chains submitted and completed so far. Handles skip
+ * DMA_INVALID_HANDLE when they wrap, these never do, so they alone
+ * pick the queue slot and count the chains in flight.
+ */
+static volatile uint32_t dma_queued;
+static volatile uint32_t dma_retired;
+
+/* Handle following another one, DMA_INVALID_HANDLE is skipped */
+static dma_handle_t dma_next(dma_handle_t handle)
+{
+  handle++;
+
+  return (handle == DMA_INVALID_HANDLE) ? handle + 1 : handle;
+}
+
+#if defined(MSP432)
+/***********************************************************
+ uDMA Controller (MSP432)
+***********************************************************/
+/* Channel control structure, as laid out by the controller */
+typedef struct
+{
+  const volatile void * src_end;  /* Address of the last source item */
+  volatile void * dst_end;        /* Address of the last dest item */
+  uint32_t control;
+  uint32_t spare;
+} dma_ctl_t;
+
+/* Channel control word fields */
+#define DMA_CTL_DST_INC_OFS   (30)
+#define DMA_CTL_DST_SIZE_OFS  (28)
+#define DMA_CTL_SRC_INC_OFS   (26)
+#define DMA_CTL_SRC_SIZE_OFS  (24)
+#define DMA_CTL_R_POWER_OFS   (14)
+#define DMA_CTL_N_MINUS_1_OFS (4)
+#define DMA_CTL_BYTE          (0)
+#define DMA_CTL_WORD          (2)
+#define DMA_CTL_AUTO          (2)
+#define DMA_CTL_SG_MEM_PRI    (4)
+#define DMA_CTL_SG_MEM_ALT    (5)
+
+/* Transfers a single control structure can describe */
+#define DMA_MAX_ITEMS (1024)
+
+/* Tasks loaded per scatter-gather run */
+#ifndef DMA_MAX_TASKS
+#define DMA_MAX_TASKS (16)
+#endif
+
+/* Channels of the MSP432P401R uDMA (DMA_DEVICE_CFG), a power of two */
+#define DMA_CHANNELS (8)
+
+#if DMA_COPY_CHANNEL >= DMA_CHANNELS
+#error "DMA_COPY_CHANNEL must be one of the DMA_CHANNELS channels"
+#endif
+
+#define DMA_CH_BIT (1u << DMA_COPY_CHANNEL)
+
+/*
+ * Primary structures of all channels followed by the alternate ones.
+ * The controller finds the alternate half by setting the bit above the
+ * primary half in CTLBASE, so the table is aligned to its own size.
+ */
+#define DMA_TABLE_SIZE (2 * DMA_CHANNELS)
+#define DMA_CTL_BYTES  (16) /* One dma_ctl_t on the 32-bit target */
+static dma_ctl_t dma_table[DMA_TABLE_SIZE]
+    __attribute__((__aligned__(DMA_TABLE_SIZE * DMA_CTL_BYTES)));
+static dma_ctl_t dma_tasks[DMA_MAX_TASKS] __attribute__((__aligned__(16)));
+
+static dma_handle_t dma_running;   /* Chain on the controller, 0 if idle */
+static dma_desc_t * dma_cursor;    /* Next descriptor to load */
+static size_t dma_offset;          /* Bytes of it already loaded */
+
+static uint32_t dma_control(uint32_t size, uint32_t items, uint32_t r_power,
+                            uint32_t cycle)
+{
+  return (size << DMA_CTL_DST_INC_OFS) | (size << DMA_CTL_DST_SIZE_OFS) |
+         (size << DMA_CTL_SRC_INC_OFS) | (size << DMA_CTL_SRC_SIZE_OFS) |
+         (r_power << DMA_CTL_R_POWER_OFS) |
+         ((items - 1) << DMA_CTL_N_MINUS_1_OFS) | cycle;
+}
+
+/* Loads the next tasks of the running chain, returns their count */
+static uint32_t dma_load_tasks(void)
+{
+  uint32_t count = 0, width, size, items;
+  const uint8_t * src;
+  uint8_t * dst;
+  size_t left;
+
+  while(dma_cursor && (count < DMA_MAX_TASKS))
+  {
+    left = dma_cursor->length - dma_offset;
+    if(left == 0)
+    {
+      dma_cursor = dma_cursor->next;
+      dma_offset = 0;
+      continue;
+    }
+
+    src = dma_cursor->src + dma_offset;
+    dst = dma_cursor->dst + dma_offset;
+    if((((uintptr_t)src | (uintptr_t)dst) & 3) == 0 && (left >= 4))
+    {
+      width = 4;
+      size = DMA_CTL_WORD;
+    }
+    else
+    {
+      width = 1;
+      size = DMA_CTL_BYTE;
+    }
+    items = (left / width > DMA_MAX_ITEMS) ? DMA_MAX_ITEMS : left / width;
+
+    dma_tasks[count].src_end = src + (items - 1) * width;
+    dma_tasks[count].dst_end = dst + (items - 1) * width;
+    dma_tasks[count].control = dma_control(size, items, 4,
+                                           DMA_CTL_SG_MEM_ALT);
+    dma_offset += items * width;
+    count++;
+  }
+
+  if(count)
+  {
+    /* The last task runs in plain auto mode and ends the cycle */
+    dma_tasks[count - 1].control &= ~7u;
+    dma_tasks[count - 1].control |= DMA_CTL_AUTO;
+  }
+
+  return count;
+}
+
+/* Points the primary structure at the task list and starts it */
+static void dma_kick(uint32_t count)
+{
+  dma_ctl_t * alt = (dma_ctl_t *)DMA_Control->ATLBASE + DMA_COPY_CHANNEL;
+  dma_ctl_t * pri = &dma_table[DMA_COPY_CHANNEL];
+
+  pri->src_end = &dma_tasks[count - 1].spare;
+  pri->dst_end = &alt->spare;
+  /* Four words per arbitration: one task copied into alt at a time */
+  pri->control = dma_control(DMA_CTL_WORD, 4 * count, 2, DMA_CTL_SG_MEM_PRI);
+
+  __DMB();
+  DMA_Control->ALTCLR = DMA_CH_BIT;
+  DMA_Control->ENASET = DMA_CH_BIT;
+  DMA_Control->SWREQ = DMA_CH_BIT;
+}
+
+/*
+ * Moves the engine forward: finishes the running batch or chain when
+ * the controller has disabled the channel, then starts the next one.
+ * Runs with interrupts masked.
+ */
+static void dma_service(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t count;
+
+  __disable_irq();
+  for(;;)
+  {
+    if(dma_running)
+    {
+      if(DMA_Control->ENASET & DMA_CH_BIT)
+      {
+        break;
+      }
+      count = dma_load_tasks();
+      if(count)
+      {
+        dma_kick(count);
+        break;
+      }
+      dma_completed = dma_running;
+      dma_retired++;
+      dma_running = 0;
+    }
+
+    if(dma_retired == dma_queued)
+    {
+      break;
+    }
+    dma_running = dma_next(dma_completed);
+    dma_cursor = dma_queue[dma_retired % DMA_MAX_INFLIGHT];
+    dma_offset = 0;
+  }
+  __set_PRIMASK(primask);
+}
+
+void DMA_INT0_IRQHandler(void)
+{
+  DMA_Channel->INT0_CLRFLG = DMA_CH_BIT;
+  dma_service();
+}
+
+uint8_t dma_init(void)
+{
+  static uint8_t started;
+
+  if(!started)
+  {
+    DMA_Control->CFG = DMA_CFG_MASTEN;
+    DMA_Control->CTLBASE = (uint32_t)dma_table;
+    DMA_Control->REQMASKSET = DMA_CH_BIT;
+    DMA_Control->USEBURSTCLR = DMA_CH_BIT;
+    DMA_Control->PRIOCLR = DMA_CH_BIT;
+    NVIC_EnableIRQ(DMA_INT0_IRQn);
+    started = 1;
+  }
+
+  return 1;
+}
+
+void dma_shutdown(void)
+{
+  dma_copy_wait(dma_submitted);
+  NVIC_DisableIRQ(DMA_INT0_IRQn);
+}
+
+dma_handle_t dma_copy_submit(dma_desc_t * desc)
+{
+  uint32_t primask = __get_PRIMASK();
+  dma_handle_t handle = DMA_INVALID_HANDLE;
+
+  dma_init();
+
+  __disable_irq();
+  if(dma_queued - dma_retired < DMA_MAX_INFLIGHT)
+  {
+    handle = dma_next(dma_submitted);
+    dma_queue[dma_queued % DMA_MAX_INFLIGHT] = desc;
+    dma_submitted = handle;
+    dma_queued++;
+  }
+  __set_PRIMASK(primask);
+
+  dma_service();
+
+  return handle;
+}
+
+#else
+/***********************************************************
+ Worker Thread (HOST)
+***********************************************************/
+static pthread_mutex_t dma_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dma_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t dma_done = PTHREAD_COND_INITIALIZER;
+static pthread_t dma_thread;
+static uint8_t dma_started;
+static uint8_t dma_stop;
+
+static void * dma_worker(void * arg)
+{
+  dma_handle_t handle;
+  dma_desc_t * desc;
+
+  (void)arg;
+  pthread_mutex_lock(&dma_lock);
+  for(;;)
+  {
+    while(!dma_stop && (dma_retired == dma_queued))
+    {
+      pthread_cond_wait(&dma_work, &dma_lock);
+    }
+    if(dma_retired == dma_queued)
+    {
+      break;
+    }
+
+    handle = dma_next(dma_completed);
+    desc = dma_queue[dma_retired % DMA_MAX_INFLIGHT];
+    pthread_mutex_unlock(&dma_lock);
+
+    for(; desc; desc = desc->next)
+    {
+      my_memcopy((uint8_t *)desc->src, desc->dst, desc->length);
+    }
+
+    pthread_mutex_lock(&dma_lock);
+    dma_completed = handle;
+    dma_retired++;
+    pthread_cond_broadcast(&dma_done);
+  }
+  pthread_mutex_unlock(&dma_lock);
+
+  return NULL;
+}
+
+uint8_t dma_init(void)
+{
+  uint8_t ret = 1;
+
+  pthread_mutex_lock(&dma_lock);
+  if(!dma_started)
+  {
+    dma_stop = 0;
+    ret = (pthread_create(&dma_thread, NULL, dma_worker, NULL) == 0);
+    dma_started = ret;
+  }
+  pthread_mutex_unlock(&dma_lock);
+
+  return ret;
+}
+
+void dma_shutdown(void)
+{
+  pthread_mutex_lock(&dma_lock);
+  if(!dma_started)
+  {
+    pthread_mutex_unlock(&dma_lock);
+    return;
+  }
+  dma_stop = 1;
+  pthread_cond_signal(&dma_work);
+  pthread_mutex_unlock(&dma_lock);
+
+  pthread_join(dma_thread, NULL);
+  dma_started = 0;
+}
+
+dma_handle_t dma_copy_submit(dma_desc_t * desc)
+{
+  dma_handle_t handle = DMA_INVALID_HANDLE;
+
+  if(!dma_init())
+  {
+    return DMA_INVALID_HANDLE;
+  }
+
+  pthread_mutex_lock(&dma_lock);
+  if(dma_queued - dma_retired < DMA_MAX_INFLIGHT)
+  {
+    handle = dma_next(dma_submitted);
+    dma_queue[dma_queued % DMA_MAX_INFLIGHT] = desc;
+    dma_submitted = handle;
+    dma_queued++;
+    pthread_cond_signal(&dma_work);
+  }
+  pthread_mutex_unlock(&dma_lock);
+
+  return handle;
+}
+#endif
+
+/***********************************************************
+ Rectangle Copies
+***********************************************************/
+dma_handle_t dma_copy2d_submit(dma_desc_t * desc, const uint8_t * src,
+                               size_t src_pitch, uint8_t * dst,
+                               size_t dst_pitch, size_t width,
+                               size_t height)
+{
+  size_t row;
+
+  if(!height)
+  {
+    return dma_copy_submit((dma_desc_t *)0);
+  }
+
+  if((src_pitch == width) && (dst_pitch == width))
+  {
+    width *= height;
+    height = 1;
+  }
+  for(row = 0; row < height; row++)
+  {
+    desc[row].src = src + row * src_pitch;
+    desc[row].dst = dst + row * dst_pitch;
+    desc[row].length = width;
+    desc[row].next = (row + 1 < height) ? &desc[row + 1] : (dma_desc_t *)0;
+  }
+
+  return dma_copy_submit(desc);
+}
+
+/***********************************************************
+ Completion
+***********************************************************/
+/* Checks a handle against the counters, caller holds the lock/IRQs */
+static dma_status_t dma_status(dma_handle_t handle)
+{
+  if((handle == DMA_INVALID_HANDLE) ||
+     ((int32_t)(handle - dma_submitted) > 0))
+  {
+    return DMA_COPY_INVALID;
+  }
+
+  return ((int32_t)(dma_completed - handle) >= 0) ? DMA_COPY_DONE
+                                                  : DMA_COPY_PENDING;
+}
+
+dma_status_t dma_copy_poll(dma_handle_t handle)
+{
+  dma_status_t status;
+
+#if defined(MSP432)
+  dma_service();
+  status = dma_status(handle);
+#else
+  pthread_mutex_lock(&dma_lock);
+  status = dma_status(handle);
+  pthread_mutex_unlock(&dma_lock);
+#endif
+
+  return status;
+}
+
+dma_status_t dma_copy_wait(dma_handle_t handle)
+{
+  dma_status_t status;
+
+#if defined(MSP432)
+  while((status = dma_copy_poll(handle)) == DMA_COPY_PENDING)
+  {
+  }
+#else
+  pthread_mutex_lock(&dma_lock);
+  while((status = dma_status(handle)) == DMA_COPY_PENDING)
+  {
+    pthread_cond_wait(&dma_done, &dma_lock);
+  }
+  pthread_mutex_unlock(&dma_lock);
+#endif
+
+  return status;
+}
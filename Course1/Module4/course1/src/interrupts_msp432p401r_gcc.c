@@ -42,6 +42,9 @@ extern int main(void);
 /* External declaration for system initialization function                  */
 extern void SystemInit(void);
 
+/* External declaration for the stack painting function, see stack.h        */
+extern void stack_paint(void);
+
 /* Forward declaration of the default fault handlers. */
 /* This is the code that gets called when the processor first starts execution */
 /* following a reset event.  Only the absolutely necessary set is performed,   */
@@ -90,6 +93,9 @@ void Reset_Handler(void)
 	    /* Call system initialization routine */
 		SystemInit();
 
+	    /* Paint the free stack for stack_high_water */
+	    stack_paint();
+
 	    /* Call the application's entry point. */
 	    main();
 }
@@ -20,111 +20,2072 @@
  * @date April 1 2017
  *
  */
+#if defined(HOST)
+#define _DEFAULT_SOURCE
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #include "memory.h"
+#include "memory_kernels.h"
+#include "pool.h"
+#include "platform.h"
 #include <stdlib.h>
+#include <string.h>
 
 /***********************************************************
- Function Definitions
+ Copy Engine Configuration
 ***********************************************************/
-void set_value(char * ptr, unsigned int index, char value){
-  ptr[index] = value;
+/* Longest part of a rotation moved through a stack buffer */
+#define MEM_ROTATE_SMALL  (32)
+
+/* Cache line size assumed by the my_memcopy2d prefetches */
+#define MEM_CACHE_LINE    (64)
+
+/* Fills of at least this many bytes use non-temporal stores */
+static size_t memset_nt_threshold = MEMSET_NT_THRESHOLD_DEFAULT;
+static size_t memzero_remap_threshold = MEMZERO_REMAP_THRESHOLD_DEFAULT;
+
+#if defined(HOST)
+static uint8_t memzero_remap(uint8_t * src, size_t length);
+#endif
+
+/*
+ * Stored just below every reserve_aligned buffer that does not come
+ * from the pool, so free_aligned knows how to give it back.
+ */
+typedef struct
+{
+  void * base;    /* Start of the underlying allocation */
+  size_t length;  /* Length of the mapping, 0 for the heap */
+} mem_aligned_hdr_t;
+
+/* Names accepted by the MEMORY_VARIANT environment variable */
+static const char * const mem_variant_names[MEM_VARIANT_COUNT] =
+{
+  "auto", "word", "sse2", "avx2", "avx512"
+};
+
+/***********************************************************
+ Word Kernels (32-byte blocks)
+***********************************************************/
+static void word_copy_fwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    uint64_t a = *(const mem_uword64_t *)(src);
+    uint64_t b = *(const mem_uword64_t *)(src + 8);
+    uint64_t c = *(const mem_uword64_t *)(src + 16);
+    uint64_t d = *(const mem_uword64_t *)(src + 24);
+    *(mem_word64_t *)(dst) = a;
+    *(mem_word64_t *)(dst + 8) = b;
+    *(mem_word64_t *)(dst + 16) = c;
+    *(mem_word64_t *)(dst + 24) = d;
+    src += 32;
+    dst += 32;
+  }
 }
 
-void clear_value(char * ptr, unsigned int index){
-  set_value(ptr, index, 0);
+static void word_copy_bwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    src -= 32;
+    dst -= 32;
+    uint64_t a = *(const mem_uword64_t *)(src + 24);
+    uint64_t b = *(const mem_uword64_t *)(src + 16);
+    uint64_t c = *(const mem_uword64_t *)(src + 8);
+    uint64_t d = *(const mem_uword64_t *)(src);
+    *(mem_word64_t *)(dst + 24) = a;
+    *(mem_word64_t *)(dst + 16) = b;
+    *(mem_word64_t *)(dst + 8) = c;
+    *(mem_word64_t *)(dst) = d;
+  }
 }
 
-char get_value(char * ptr, unsigned int index){
-  return ptr[index];
+/* 17 to 32 bytes as the first and last 16, in pairs of 64-bit words */
+static void word_copy_short(uint8_t * dst, const uint8_t * src,
+                            size_t length)
+{
+  if(length > 16)
+  {
+    uint64_t a = *(const mem_uword64_t *)(src);
+    uint64_t b = *(const mem_uword64_t *)(src + 8);
+    uint64_t c = *(const mem_uword64_t *)(src + length - 16);
+    uint64_t d = *(const mem_uword64_t *)(src + length - 8);
+    *(mem_uword64_t *)(dst) = a;
+    *(mem_uword64_t *)(dst + 8) = b;
+    *(mem_uword64_t *)(dst + length - 16) = c;
+    *(mem_uword64_t *)(dst + length - 8) = d;
+  }
+  else
+  {
+    mem_copy_upto16(dst, src, length);
+  }
 }
 
-void set_all(char * ptr, char value, unsigned int size){
-  unsigned int i;
-  for(i = 0; i < size; i++) {
-    set_value(ptr, i, value);
+static void word_fill_short(uint8_t * dst, uint8_t value, size_t length)
+{
+  uint64_t v = (uint64_t)value * 0x0101010101010101ull;
+
+  if(length > 16)
+  {
+    *(mem_uword64_t *)(dst) = v;
+    *(mem_uword64_t *)(dst + 8) = v;
+    *(mem_uword64_t *)(dst + length - 16) = v;
+    *(mem_uword64_t *)(dst + length - 8) = v;
+  }
+  else
+  {
+    mem_fill_upto16(dst, value, length);
   }
 }
 
-void clear_all(char * ptr, unsigned int size){
-  set_all(ptr, 0, size);
+/* The M4 has no streaming stores, stream is ignored */
+static void word_fill(uint8_t * dst, uint8_t value, size_t blocks, int stream)
+{
+  uint64_t v = (uint64_t)value * 0x0101010101010101ull;
+
+  (void)stream;
+  while(blocks--)
+  {
+    *(mem_word64_t *)(dst) = v;
+    *(mem_word64_t *)(dst + 8) = v;
+    *(mem_word64_t *)(dst + 16) = v;
+    *(mem_word64_t *)(dst + 24) = v;
+    dst += 32;
+  }
 }
 
-uint8_t * my_memmove(uint8_t * src, uint8_t * dst, size_t length)
+/* REV on 32-bit words on the M4, bswap on 64-bit words elsewhere */
+static void word_reverse(uint8_t * left, uint8_t * right, size_t blocks)
 {
-  unsigned int i;
-  if(src > dst)
+  while(blocks--)
+  {
+#if defined(MSP432)
+    right -= sizeof(uint32_t);
+    uint32_t a = *(const mem_uword32_t *)left;
+    uint32_t b = *(const mem_uword32_t *)right;
+    *(mem_uword32_t *)left = __REV(b);
+    *(mem_uword32_t *)right = __REV(a);
+    left += sizeof(uint32_t);
+#else
+    right -= sizeof(uint64_t);
+    uint64_t a = *(const mem_uword64_t *)left;
+    uint64_t b = *(const mem_uword64_t *)right;
+    *(mem_uword64_t *)left = __builtin_bswap64(b);
+    *(mem_uword64_t *)right = __builtin_bswap64(a);
+    left += sizeof(uint64_t);
+#endif
+  }
+}
+
+/*
+ * REV16/REV on 32-bit words on the M4, shifts and bswap on 64-bit
+ * words elsewhere. Each word is loaded before it is stored, so dst
+ * may equal src.
+ */
+static void word_swap(uint8_t * dst, const uint8_t * src, size_t blocks,
+                      size_t width)
+{
+  size_t i;
+
+  while(blocks--)
   {
-    for(i = 0; i < length; i++)
+#if defined(MSP432)
+    for(i = 0; i < 32; i += 8)
+    {
+      uint32_t a = *(const mem_uword32_t *)(src + i);
+      uint32_t b = *(const mem_uword32_t *)(src + i + 4);
+      if(width == 8)
+      {
+        *(mem_uword32_t *)(dst + i) = __REV(b);
+        *(mem_uword32_t *)(dst + i + 4) = __REV(a);
+      }
+      else if(width == 4)
+      {
+        *(mem_uword32_t *)(dst + i) = __REV(a);
+        *(mem_uword32_t *)(dst + i + 4) = __REV(b);
+      }
+      else
+      {
+        *(mem_uword32_t *)(dst + i) = __REV16(a);
+        *(mem_uword32_t *)(dst + i + 4) = __REV16(b);
+      }
+    }
+#else
+    for(i = 0; i < 32; i += 8)
     {
-      *(dst + i) = *(src + i);
+      uint64_t v = *(const mem_uword64_t *)(src + i);
+      if(width == 2)
+      {
+        v = ((v & 0x00FF00FF00FF00FFull) << 8) |
+            ((v >> 8) & 0x00FF00FF00FF00FFull);
+      }
+      else
+      {
+        v = __builtin_bswap64(v);
+        if(width == 4)
+        {
+          v = (v << 32) | (v >> 32);
+        }
+      }
+      *(mem_uword64_t *)(dst + i) = v;
     }
+#endif
+    src += 32;
+    dst += 32;
   }
-  else // (src < dst)
+}
+
+/*
+ * Sample by sample (de)interleave of frames [first, last). Always
+ * inlined, so constant channels and width give one loop per layout;
+ * also used for the tails and for layouts without a kernel.
+ */
+static inline __attribute__((__always_inline__))
+void split_frames(uint8_t * const * dst, const uint8_t * src, size_t first,
+                  size_t last, size_t channels, size_t width)
+{
+  size_t f, c, b;
+
+  src += first * channels * width;
+  for(f = first; f < last; f++)
   {
-    for(i = length - 1; i > 0; i--)
+    for(c = 0; c < channels; c++)
     {
-      *(dst + i) = *(src + i);
+      uint8_t * out = dst[c] + f * width;
+      if(width == 1)
+      {
+        *out = *src;
+      }
+      else if(width == 2)
+      {
+        *(mem_uword16_t *)out = *(const mem_uword16_t *)src;
+      }
+      else if(width == 4)
+      {
+        *(mem_uword32_t *)out = *(const mem_uword32_t *)src;
+      }
+      else
+      {
+        for(b = 0; b < width; b++)
+        {
+          out[b] = src[b];
+        }
+      }
+      src += width;
     }
-    *dst = *src;
   }
+}
 
-  return dst;
+static inline __attribute__((__always_inline__))
+void merge_frames(uint8_t * dst, const uint8_t * const * src, size_t first,
+                  size_t last, size_t channels, size_t width)
+{
+  size_t f, c, b;
+
+  dst += first * channels * width;
+  for(f = first; f < last; f++)
+  {
+    for(c = 0; c < channels; c++)
+    {
+      const uint8_t * in = src[c] + f * width;
+      if(width == 1)
+      {
+        *dst = *in;
+      }
+      else if(width == 2)
+      {
+        *(mem_uword16_t *)dst = *(const mem_uword16_t *)in;
+      }
+      else if(width == 4)
+      {
+        *(mem_uword32_t *)dst = *(const mem_uword32_t *)in;
+      }
+      else
+      {
+        for(b = 0; b < width; b++)
+        {
+          dst[b] = in[b];
+        }
+      }
+      dst += width;
+    }
+  }
 }
 
-uint8_t * my_memcopy(uint8_t * src, uint8_t * dst, size_t length)
+/* Constant widths for the sample types, any other width as it comes */
+static inline __attribute__((__always_inline__))
+void split_layout(uint8_t * const * dst, const uint8_t * src, size_t first,
+                  size_t last, size_t channels, size_t width)
 {
-  unsigned int i;
-  for(i = 0; i < length; i++)
+  switch(width)
   {
-    *(dst + i) = *(src + i);
+    case 1:
+      split_frames(dst, src, first, last, channels, 1);
+      break;
+    case 2:
+      split_frames(dst, src, first, last, channels, 2);
+      break;
+    case 4:
+      split_frames(dst, src, first, last, channels, 4);
+      break;
+    default:
+      split_frames(dst, src, first, last, channels, width);
+      break;
   }
+}
 
-  return dst;
+static inline __attribute__((__always_inline__))
+void merge_layout(uint8_t * dst, const uint8_t * const * src, size_t first,
+                  size_t last, size_t channels, size_t width)
+{
+  switch(width)
+  {
+    case 1:
+      merge_frames(dst, src, first, last, channels, 1);
+      break;
+    case 2:
+      merge_frames(dst, src, first, last, channels, 2);
+      break;
+    case 4:
+      merge_frames(dst, src, first, last, channels, 4);
+      break;
+    default:
+      merge_frames(dst, src, first, last, channels, width);
+      break;
+  }
 }
 
-uint8_t * my_memset(uint8_t * src, size_t length, uint8_t value)
+/*
+ * Word blocks hold 4 bytes of every channel. Stereo 16-bit samples on
+ * the M4 take two frames per pair of words, split and joined again
+ * with PKHBT/PKHTB.
+ */
+static void word_deinterleave(uint8_t * const * dst, const uint8_t * src,
+                              size_t blocks, size_t channels, size_t width)
 {
-  unsigned int i;
-  for(i = 0; i < length; i++)
+  size_t frames = blocks * sizeof(uint32_t) / width;
+
+#if defined(MSP432)
+  size_t i;
+
+  if((channels == 2) && (width == 2))
   {
-    *(src + i) = value;
+    for(i = 0; i < blocks * sizeof(uint32_t); i += sizeof(uint32_t))
+    {
+      uint32_t a = *(const mem_uword32_t *)(src);
+      uint32_t b = *(const mem_uword32_t *)(src + 4);
+      *(mem_uword32_t *)(dst[0] + i) = __PKHBT(a, b, 16);
+      *(mem_uword32_t *)(dst[1] + i) = __PKHTB(b, a, 16);
+      src += 8;
+    }
+    return;
   }
+#endif
 
-  return src;
+  if(channels == 2)
+  {
+    split_layout(dst, src, 0, frames, 2, width);
+  }
+  else if(channels == 3)
+  {
+    split_layout(dst, src, 0, frames, 3, width);
+  }
+  else
+  {
+    split_layout(dst, src, 0, frames, 4, width);
+  }
 }
 
-uint8_t * my_memzero(uint8_t * src, size_t length)
+static void word_interleave(uint8_t * dst, const uint8_t * const * src,
+                            size_t blocks, size_t channels, size_t width)
 {
-  unsigned int i;
-  for(i = 0; i < length; i++)
+  size_t frames = blocks * sizeof(uint32_t) / width;
+
+#if defined(MSP432)
+  size_t i;
+
+  if((channels == 2) && (width == 2))
+  {
+    for(i = 0; i < blocks * sizeof(uint32_t); i += sizeof(uint32_t))
+    {
+      uint32_t l = *(const mem_uword32_t *)(src[0] + i);
+      uint32_t r = *(const mem_uword32_t *)(src[1] + i);
+      *(mem_uword32_t *)(dst) = __PKHBT(l, r, 16);
+      *(mem_uword32_t *)(dst + 4) = __PKHTB(r, l, 16);
+      dst += 8;
+    }
+    return;
+  }
+#endif
+
+  if(channels == 2)
+  {
+    merge_layout(dst, src, 0, frames, 2, width);
+  }
+  else if(channels == 3)
+  {
+    merge_layout(dst, src, 0, frames, 3, width);
+  }
+  else
   {
-    *(src + i) = 0;
+    merge_layout(dst, src, 0, frames, 4, width);
   }
+}
 
-  return src;
+/*
+ * SWAR scan kernels on native words: 32-bit on the M4, 64-bit on the
+ * host. Both are little-endian, so the lowest marked byte of a word is
+ * the first one in memory.
+ */
+typedef uintptr_t __attribute__((__may_alias__, __aligned__(1))) mem_uscan_t;
+
+#define SCAN_ONES         ((uintptr_t)0x0101010101010101ull)
+#define SCAN_LOW7         ((uintptr_t)0x7F7F7F7F7F7F7F7Full)
+
+/*
+ * Marks the zero bytes of a word with 0x80. Unlike the shorter
+ * (x - 0x01..) & ~x form no borrow crosses bytes, so the highest mark
+ * is exact as well and find_last can use it.
+ */
+static inline uintptr_t scan_zero_bytes(uintptr_t x)
+{
+  return ~(((x & SCAN_LOW7) + SCAN_LOW7) | x | SCAN_LOW7);
 }
 
-uint8_t * my_reverse(uint8_t * src, size_t length)
+static size_t word_mismatch(const uint8_t * a, const uint8_t * b,
+                            size_t blocks)
 {
-  unsigned int left, right, temp;
-  for(left = 0, right = length - 1; left < right; left++, right--)
+  size_t offset;
+  uintptr_t diff;
+
+  for(offset = 0; blocks--; offset += sizeof(uintptr_t))
   {
-    temp = *(src + left);
-    *(src + left) = *(src + right);
-    *(src + right) = temp; 
+    diff = *(const mem_uscan_t *)(a + offset) ^
+           *(const mem_uscan_t *)(b + offset);
+    if(diff)
+    {
+      return offset + __builtin_ctzl(diff) / 8;
+    }
   }
 
-  return src;
+  return MEM_NOT_FOUND;
 }
 
-int32_t * reserve_words(size_t length)
+static size_t word_find(const uint8_t * src, uint8_t value, size_t blocks)
 {
-  int32_t *ptr = malloc(sizeof(int32_t) * length);
+  uintptr_t pattern = value * SCAN_ONES;
+  size_t offset;
+  uintptr_t hits;
 
-  return ptr;
+  for(offset = 0; blocks--; offset += sizeof(uintptr_t))
+  {
+    hits = scan_zero_bytes(*(const mem_uscan_t *)(src + offset) ^ pattern);
+    if(hits)
+    {
+      return offset + __builtin_ctzl(hits) / 8;
+    }
+  }
+
+  return MEM_NOT_FOUND;
 }
 
-void free_words(int32_t * src)
+static size_t word_find_last(const uint8_t * src, uint8_t value,
+                             size_t blocks)
+{
+  uintptr_t pattern = value * SCAN_ONES;
+  size_t offset = blocks * sizeof(uintptr_t);
+  uintptr_t hits;
+
+  while(blocks--)
+  {
+    offset -= sizeof(uintptr_t);
+    hits = scan_zero_bytes(*(const mem_uscan_t *)(src + offset) ^ pattern);
+    if(hits)
+    {
+      return offset + sizeof(uintptr_t) - 1 - __builtin_clzl(hits) / 8;
+    }
+  }
+
+  return MEM_NOT_FOUND;
+}
+
+const mem_kernels_t mem_kernels_word =
+{
+#if defined(MSP432)
+  8, 32, 32, sizeof(uint32_t), sizeof(uintptr_t), sizeof(uint32_t),
+#else
+  8, 32, 32, sizeof(uint64_t), sizeof(uintptr_t), sizeof(uint32_t),
+#endif
+  word_copy_fwd, word_copy_bwd, word_copy_short, word_fill, word_fill_short,
+  word_reverse, word_swap,
+  word_deinterleave, word_interleave,
+  word_mismatch, word_find, word_find_last
+};
+
+/***********************************************************
+ Kernel Dispatch
+***********************************************************/
+#if defined(MEM_KERNELS_X86)
+static const mem_kernels_t * const mem_variant_kernels[MEM_VARIANT_COUNT] =
+{
+  &mem_kernels_word, &mem_kernels_word, &mem_kernels_sse2,
+  &mem_kernels_avx2, &mem_kernels_avx512
+};
+
+static const mem_kernels_t * mem_kernels = &mem_kernels_sse2;
+static mem_variant_t mem_variant = MEM_VARIANT_SSE2;
+
+/*
+ * Picks the best kernels for the CPU before main() runs, unless the
+ * MEMORY_VARIANT environment variable names a supported variant.
+ */
+__attribute__((__constructor__))
+static void memory_dispatch_init(void)
+{
+  const char * name = getenv("MEMORY_VARIANT");
+  mem_variant_t variant;
+
+  for(variant = MEM_VARIANT_WORD; name && (variant < MEM_VARIANT_COUNT);
+      variant++)
+  {
+    if(strcmp(name, mem_variant_names[variant]) == 0)
+    {
+      break;
+    }
+  }
+
+  if(!name || (variant == MEM_VARIANT_COUNT) ||
+     !memory_select_variant(variant))
+  {
+    memory_select_variant(MEM_VARIANT_AUTO);
+  }
+}
+#else
+/* A single kernel table, kept constant so calls can be resolved early */
+#define mem_kernels (&mem_kernels_word)
+static const mem_variant_t mem_variant = MEM_VARIANT_WORD;
+#endif
+
+/***********************************************************
+ Copy Engines
+***********************************************************/
+/*
+ * Forward copy engine for more than short_max bytes: copy_short up to
+ * the kernel alignment of dst, whole blocks, then copy_short for the
+ * rest. The three parts run in address order and each loads all it
+ * needs before storing, so this is safe for overlap with dst below src.
+ */
+static void copy_fwd_split(uint8_t * dst, const uint8_t * src,
+                           size_t length)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t head, blocks, body;
+
+  head = (0 - (uintptr_t)dst) & (k->align - 1);
+  if(head)
+  {
+    k->copy_short(dst, src, head);
+    dst += head;
+    src += head;
+    length -= head;
+  }
+
+  /* block is a power of two, a divide would cost more than short copies */
+  body = length & (0 - k->block);
+  blocks = body >> __builtin_ctz((unsigned)k->block);
+  k->copy_fwd(dst, src, blocks);
+  k->copy_short(dst + body, src + body, length - body);
+}
+
+/*
+ * Backward copy engine, the mirror of copy_fwd_split: the end of dst
+ * is aligned first and the parts run downwards, so it is safe for
+ * overlapping buffers with dst above src.
+ */
+static void copy_bwd_split(uint8_t * dst, const uint8_t * src,
+                           size_t length)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t tail, blocks, body;
+
+  dst += length;
+  src += length;
+  tail = (uintptr_t)dst & (k->align - 1);
+  if(tail)
+  {
+    dst -= tail;
+    src -= tail;
+    length -= tail;
+    k->copy_short(dst, src, tail);
+  }
+
+  body = length & (0 - k->block);
+  blocks = body >> __builtin_ctz((unsigned)k->block);
+  k->copy_bwd(dst, src, blocks);
+  k->copy_short(dst - length, src - length, length - body);
+}
+
+/* Fill engine for more than short_max bytes, split as copy_fwd_split */
+static void fill_split(uint8_t * dst, uint8_t value, size_t length,
+                       int stream)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t head, blocks, body;
+
+  head = (0 - (uintptr_t)dst) & (k->align - 1);
+  if(head)
+  {
+    k->fill_short(dst, value, head);
+    dst += head;
+    length -= head;
+  }
+
+  body = length & (0 - k->block);
+  blocks = body >> __builtin_ctz((unsigned)k->block);
+  k->fill(dst, value, blocks, stream);
+  k->fill_short(dst + body, value, length - body);
+}
+
+/*
+ * Copies of up to short_max bytes are a single copy_short, whatever
+ * the alignment. Kept inline so that is one indirect call from the
+ * public functions.
+ */
+static inline void copy_fwd(uint8_t * dst, const uint8_t * src,
+                            size_t length)
+{
+  if(length <= mem_kernels->short_max)
+  {
+    mem_kernels->copy_short(dst, src, length);
+  }
+  else
+  {
+    copy_fwd_split(dst, src, length);
+  }
+}
+
+static inline void copy_bwd(uint8_t * dst, const uint8_t * src,
+                            size_t length)
+{
+  if(length <= mem_kernels->short_max)
+  {
+    mem_kernels->copy_short(dst, src, length);
+  }
+  else
+  {
+    copy_bwd_split(dst, src, length);
+  }
+}
+
+/* The body uses streaming stores when stream is set */
+void mem_fill(uint8_t * dst, uint8_t value, size_t length, int stream)
+{
+  if(length <= mem_kernels->short_max)
+  {
+    mem_kernels->fill_short(dst, value, length);
+  }
+  else
+  {
+    fill_split(dst, value, length, stream);
+  }
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void set_value(char * ptr, unsigned int index, char value){
+  ptr[index] = value;
+}
+
+void clear_value(char * ptr, unsigned int index){
+  set_value(ptr, index, 0);
+}
+
+char get_value(char * ptr, unsigned int index){
+  return ptr[index];
+}
+
+void set_all(char * ptr, char value, unsigned int size){
+  unsigned int i;
+  for(i = 0; i < size; i++) {
+    set_value(ptr, i, value);
+  }
+}
+
+void clear_all(char * ptr, unsigned int size){
+  set_all(ptr, 0, size);
+}
+
+uint8_t * my_memmove(uint8_t * src, uint8_t * dst, size_t length)
+{
+  /*
+   * Both engines load a whole block (or short copy) before storing any
+   * of it and walk in the direction that keeps the stores behind the
+   * loads, so overlap by less than a vector width needs no byte
+   * fallback: a store can only land on source bytes already loaded.
+   */
+  if((dst == src) || (length == 0))
+  {
+    return dst;
+  }
+
+  if((dst < src) || (dst >= src + length))
+  {
+    copy_fwd(dst, src, length);
+  }
+  else
+  {
+    copy_bwd(dst, src, length);
+  }
+
+  return dst;
+}
+
+uint8_t * my_memcopy(uint8_t * src, uint8_t * dst, size_t length)
+{
+  copy_fwd(dst, src, length);
+
+  return dst;
+}
+
+uint8_t * my_memcopy_crc32(uint8_t * src, uint8_t * dst, size_t length,
+                           crc32_t * crc)
+{
+  crc32_update_copy(crc, dst, src, length);
+
+  return dst;
+}
+
+uint8_t * my_memcopy_adler32(uint8_t * src, uint8_t * dst, size_t length,
+                             adler32_t * adler)
 {
-  free(src);
+  adler32_update_copy(adler, dst, src, length);
+
+  return dst;
+}
+
+/*
+ * Row loop of my_memcopy2d, inlined once per element width. On the
+ * host the cache lines of the row MEM_COPY2D_AHEAD ahead are requested
+ * before each row is copied: the hardware prefetchers follow the row
+ * being read but do not cross pitches of a page or more. Rows packed
+ * closer than a cache line are one stream and are left to them.
+ */
+static inline __attribute__((__always_inline__))
+void copy_rows(uint8_t * dst, const uint8_t * src, size_t dst_pitch,
+               size_t src_pitch, size_t width, size_t height)
+{
+  size_t row;
+#if defined(HOST)
+  size_t last = (src_pitch > MEM_CACHE_LINE) ? height : 0;
+#endif
+
+  for(row = 0; row < height; row++)
+  {
+#if defined(HOST)
+    if(row + MEM_COPY2D_AHEAD < last)
+    {
+      const uint8_t * ahead = src + MEM_COPY2D_AHEAD * src_pitch;
+      uintptr_t line = (uintptr_t)ahead & ~(uintptr_t)(MEM_CACHE_LINE - 1);
+
+      for(; line < (uintptr_t)ahead + width; line += MEM_CACHE_LINE)
+      {
+        __builtin_prefetch((const void *)line, 0, 3);
+      }
+    }
+#endif
+    if(width == 1)
+    {
+      *dst = *src;
+    }
+    else if(width == 2)
+    {
+      *(mem_uword16_t *)dst = *(const mem_uword16_t *)src;
+    }
+    else if(width == 4)
+    {
+      *(mem_uword32_t *)dst = *(const mem_uword32_t *)src;
+    }
+    else if(width == 8)
+    {
+      *(mem_uword64_t *)dst = *(const mem_uword64_t *)src;
+    }
+    else
+    {
+      copy_fwd(dst, src, width);
+    }
+    src += src_pitch;
+    dst += dst_pitch;
+  }
+}
+
+uint8_t * my_memcopy2d(uint8_t * src, size_t src_pitch, uint8_t * dst,
+                       size_t dst_pitch, size_t width, size_t height)
+{
+  if((src_pitch == width) && (dst_pitch == width))
+  {
+    copy_fwd(dst, src, width * height);
+    return dst;
+  }
+
+  switch(width)
+  {
+    case 1:
+      copy_rows(dst, src, dst_pitch, src_pitch, 1, height);
+      break;
+    case 2:
+      copy_rows(dst, src, dst_pitch, src_pitch, 2, height);
+      break;
+    case 4:
+      copy_rows(dst, src, dst_pitch, src_pitch, 4, height);
+      break;
+    case 8:
+      copy_rows(dst, src, dst_pitch, src_pitch, 8, height);
+      break;
+    default:
+      copy_rows(dst, src, dst_pitch, src_pitch, width, height);
+      break;
+  }
+
+  return dst;
+}
+
+uint8_t * my_gather_strided(uint8_t * src, size_t stride, uint8_t * dst,
+                            size_t size, size_t count)
+{
+  return my_memcopy2d(src, stride, dst, size, size, count);
+}
+
+uint8_t * my_scatter_strided(uint8_t * src, uint8_t * dst, size_t stride,
+                             size_t size, size_t count)
+{
+  return my_memcopy2d(src, size, dst, stride, size, count);
+}
+
+size_t my_gather(const mem_seg_t * segs, size_t count, uint8_t * dst)
+{
+  size_t total = 0;
+
+  for(; count--; segs++)
+  {
+    copy_fwd(dst + total, segs->ptr, segs->length);
+    total += segs->length;
+  }
+
+  return total;
+}
+
+size_t my_scatter(uint8_t * src, const mem_seg_t * segs, size_t count)
+{
+  size_t total = 0;
+
+  for(; count--; segs++)
+  {
+    copy_fwd(segs->ptr, src + total, segs->length);
+    total += segs->length;
+  }
+
+  return total;
+}
+
+size_t my_memcopy_v(const mem_seg_t * src, size_t src_count,
+                    const mem_seg_t * dst, size_t dst_count)
+{
+  size_t src_off = 0, dst_off = 0, total = 0, length;
+
+  /* Copy the overlap of the current pair, then step whichever ended */
+  while(src_count && dst_count)
+  {
+    length = src->length - src_off;
+    if(length > dst->length - dst_off)
+    {
+      length = dst->length - dst_off;
+    }
+    copy_fwd(dst->ptr + dst_off, src->ptr + src_off, length);
+    total += length;
+    src_off += length;
+    dst_off += length;
+
+    if(src_off == src->length)
+    {
+      src++;
+      src_count--;
+      src_off = 0;
+    }
+    if(dst_off == dst->length)
+    {
+      dst++;
+      dst_count--;
+      dst_off = 0;
+    }
+  }
+
+  return total;
+}
+
+size_t mem_seg_total(const mem_seg_t * segs, size_t count)
+{
+  size_t total = 0;
+
+  while(count--)
+  {
+    total += segs++->length;
+  }
+
+  return total;
+}
+
+/* Moves a cursor off the end of its segment and past empty ones */
+static void cursor_settle(mem_cursor_t * cursor)
+{
+  while((cursor->index < cursor->count) &&
+        (cursor->offset == cursor->segs[cursor->index].length))
+  {
+    cursor->index++;
+    cursor->offset = 0;
+  }
+}
+
+void mem_cursor_init(mem_cursor_t * cursor, const mem_seg_t * segs,
+                     size_t count)
+{
+  cursor->segs = segs;
+  cursor->count = count;
+  cursor->index = 0;
+  cursor->offset = 0;
+  cursor_settle(cursor);
+}
+
+uint8_t * mem_cursor_peek(mem_cursor_t * cursor, size_t length)
+{
+  const mem_seg_t * seg = cursor->segs + cursor->index;
+
+  if((cursor->index == cursor->count) ||
+     (length > seg->length - cursor->offset))
+  {
+    return (uint8_t *)0;
+  }
+
+  return seg->ptr + cursor->offset;
+}
+
+uint8_t * mem_cursor_next(mem_cursor_t * cursor, size_t max, size_t * length)
+{
+  const mem_seg_t * seg = cursor->segs + cursor->index;
+  uint8_t * span;
+
+  if(cursor->index == cursor->count)
+  {
+    *length = 0;
+    return (uint8_t *)0;
+  }
+
+  span = seg->ptr + cursor->offset;
+  *length = seg->length - cursor->offset;
+  if(*length > max)
+  {
+    *length = max;
+  }
+  cursor->offset += *length;
+  cursor_settle(cursor);
+
+  return span;
+}
+
+size_t mem_cursor_read(mem_cursor_t * cursor, uint8_t * dst, size_t length)
+{
+  size_t total = 0, span;
+  uint8_t * src;
+
+  while((total < length) &&
+        (src = mem_cursor_next(cursor, length - total, &span)))
+  {
+    if(dst)
+    {
+      copy_fwd(dst + total, src, span);
+    }
+    total += span;
+  }
+
+  return total;
+}
+
+uint8_t * my_memset(uint8_t * src, size_t length, uint8_t value)
+{
+  mem_fill(src, value, length, length >= memset_nt_threshold);
+
+  return src;
+}
+
+uint8_t * my_memzero(uint8_t * src, size_t length)
+{
+#if defined(HOST)
+  if((length >= memzero_remap_threshold) && memzero_remap(src, length))
+  {
+    return src;
+  }
+#endif
+  mem_fill(src, 0, length, length >= memset_nt_threshold);
+
+  return src;
+}
+
+void my_memset_set_nt_threshold(size_t threshold)
+{
+  memset_nt_threshold = threshold;
+}
+
+size_t my_memset_get_nt_threshold(void)
+{
+  return memset_nt_threshold;
+}
+
+void my_memzero_set_remap_threshold(size_t threshold)
+{
+  memzero_remap_threshold = threshold;
+}
+
+size_t my_memzero_get_remap_threshold(void)
+{
+  return memzero_remap_threshold;
+}
+
+uint8_t * my_reverse(uint8_t * src, size_t length)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t blocks = length / (2 * k->rev_block);
+  uint8_t * left = src;
+  uint8_t * right = src + length;
+  uint8_t temp;
+
+  /* Whole blocks from both ends, until they would meet in the middle */
+  k->reverse(left, right, blocks);
+  left += blocks * k->rev_block;
+  right -= blocks * k->rev_block;
+
+  while(right - left > 1)
+  {
+    right--;
+    temp = *left;
+    *left = *right;
+    *right = temp;
+    left++;
+  }
+
+  return src;
+}
+
+uint8_t * my_rotate(uint8_t * src, size_t length, size_t shift)
+{
+  uint8_t temp[MEM_ROTATE_SMALL];
+
+  if(length == 0)
+  {
+    return src;
+  }
+  shift %= length;
+  if(shift == 0)
+  {
+    return src;
+  }
+
+  /* A short part fits on the stack, and one move beats three passes */
+  if(shift <= MEM_ROTATE_SMALL)
+  {
+    my_memcopy(src, temp, shift);
+    my_memmove(src + shift, src, length - shift);
+    my_memcopy(temp, src + length - shift, shift);
+    return src;
+  }
+  if(length - shift <= MEM_ROTATE_SMALL)
+  {
+    my_memcopy(src + shift, temp, length - shift);
+    my_memmove(src, src + length - shift, shift);
+    my_memcopy(temp, src, length - shift);
+    return src;
+  }
+
+  my_reverse(src, shift);
+  my_reverse(src + shift, length - shift);
+  my_reverse(src, length);
+
+  return src;
+}
+
+/* Wide blocks, then word blocks, then the last few elements */
+static uint8_t * swap_array(uint8_t * src, uint8_t * dst, size_t count,
+                            size_t width)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t length = count * width;
+  size_t done, blocks;
+
+  blocks = length / k->block;
+  k->swap(dst, src, blocks, width);
+  done = blocks * k->block;
+
+  blocks = (length - done) / mem_kernels_word.block;
+  mem_kernels_word.swap(dst + done, src + done, blocks, width);
+  done += blocks * mem_kernels_word.block;
+
+  for(; done < length; done += width)
+  {
+    if(width == 2)
+    {
+      *(mem_uword16_t *)(dst + done) =
+          __builtin_bswap16(*(const mem_uword16_t *)(src + done));
+    }
+    else if(width == 4)
+    {
+      *(mem_uword32_t *)(dst + done) =
+          __builtin_bswap32(*(const mem_uword32_t *)(src + done));
+    }
+    else
+    {
+      *(mem_uword64_t *)(dst + done) =
+          __builtin_bswap64(*(const mem_uword64_t *)(src + done));
+    }
+  }
+
+  return dst;
+}
+
+uint8_t * swap16_array(uint8_t * src, uint8_t * dst, size_t count)
+{
+  return swap_array(src, dst, count, sizeof(uint16_t));
+}
+
+uint8_t * swap32_array(uint8_t * src, uint8_t * dst, size_t count)
+{
+  return swap_array(src, dst, count, sizeof(uint32_t));
+}
+
+uint8_t * swap64_array(uint8_t * src, uint8_t * dst, size_t count)
+{
+  return swap_array(src, dst, count, sizeof(uint64_t));
+}
+
+/* Layouts the (de)interleave kernels take */
+static uint8_t ilv_kernel_layout(size_t channels, size_t width)
+{
+  return (channels >= 2) && (channels <= 4) &&
+         ((width == 1) || (width == 2) || (width == 4));
+}
+
+void my_deinterleave(uint8_t * src, uint8_t * const * dst, size_t channels,
+                     size_t frames, size_t width)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t blocks, done = 0;
+
+  if(channels == 1)
+  {
+    my_memcopy(src, dst[0], frames * width);
+    return;
+  }
+
+  if(ilv_kernel_layout(channels, width))
+  {
+    blocks = frames * width / k->ilv_block;
+    k->deinterleave(dst, src, blocks, channels, width);
+    done = blocks * k->ilv_block / width;
+  }
+  split_layout(dst, src, done, frames, channels, width);
+}
+
+void my_interleave(uint8_t * const * src, uint8_t * dst, size_t channels,
+                   size_t frames, size_t width)
+{
+  const mem_kernels_t * k = mem_kernels;
+  const uint8_t * const * in = (const uint8_t * const *)src;
+  size_t blocks, done = 0;
+
+  if(channels == 1)
+  {
+    my_memcopy(src[0], dst, frames * width);
+    return;
+  }
+
+  if(ilv_kernel_layout(channels, width))
+  {
+    blocks = frames * width / k->ilv_block;
+    k->interleave(dst, in, blocks, channels, width);
+    done = blocks * k->ilv_block / width;
+  }
+  merge_layout(dst, in, done, frames, channels, width);
+}
+
+int32_t my_memcmp(uint8_t * src1, uint8_t * src2, size_t length)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t offset;
+  size_t done;
+
+  /* Wide blocks, then native words, then the last few bytes */
+  offset = k->mismatch(src1, src2, length / k->scan_block);
+  done = length - length % k->scan_block;
+  if(offset == MEM_NOT_FOUND)
+  {
+    offset = mem_kernels_word.mismatch(src1 + done, src2 + done,
+                                       (length - done) / sizeof(uintptr_t));
+    if(offset != MEM_NOT_FOUND)
+    {
+      offset += done;
+    }
+    else
+    {
+      for(offset = length - length % sizeof(uintptr_t);
+          (offset < length) && (src1[offset] == src2[offset]); offset++);
+    }
+  }
+
+  if(offset >= length)
+  {
+    return 0;
+  }
+
+  return (int32_t)src1[offset] - (int32_t)src2[offset];
+}
+
+uint8_t * my_memchr(uint8_t * src, size_t length, uint8_t value)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t offset;
+  size_t done;
+
+  offset = k->find(src, value, length / k->scan_block);
+  if(offset != MEM_NOT_FOUND)
+  {
+    return src + offset;
+  }
+
+  done = length - length % k->scan_block;
+  offset = mem_kernels_word.find(src + done, value,
+                                 (length - done) / sizeof(uintptr_t));
+  if(offset != MEM_NOT_FOUND)
+  {
+    return src + done + offset;
+  }
+
+  for(offset = length - length % sizeof(uintptr_t); offset < length;
+      offset++)
+  {
+    if(src[offset] == value)
+    {
+      return src + offset;
+    }
+  }
+
+  return (uint8_t *)0;
+}
+
+uint8_t * my_memrchr(uint8_t * src, size_t length, uint8_t value)
+{
+  const mem_kernels_t * k = mem_kernels;
+  size_t offset = length;
+  size_t words;
+  size_t hit;
+
+  /*
+   * The mirror of my_memchr: the bytes past the last whole word, the
+   * words past the last whole block, then the blocks downwards.
+   */
+  while(offset > length - length % sizeof(uintptr_t))
+  {
+    if(src[--offset] == value)
+    {
+      return src + offset;
+    }
+  }
+
+  words = (length % k->scan_block) / sizeof(uintptr_t);
+  offset -= words * sizeof(uintptr_t);
+  hit = mem_kernels_word.find_last(src + offset, value, words);
+  if(hit != MEM_NOT_FOUND)
+  {
+    return src + offset + hit;
+  }
+
+  offset = k->find_last(src, value, length / k->scan_block);
+  if(offset != MEM_NOT_FOUND)
+  {
+    return src + offset;
+  }
+
+  return (uint8_t *)0;
+}
+
+#if defined(HOST) || defined(MEMORY_STATS)
+/*
+ * Heap blocks from reserve_words carry a header: the bytes requested,
+ * for the statistics, and on the HOST the thread cache class the
+ * block belongs to. Two words keep malloc's alignment.
+ */
+typedef struct
+{
+  size_t bytes;
+  size_t cls;
+} mem_block_hdr_t;
+#endif
+
+/***********************************************************
+ Allocation Statistics (MEMORY_STATS only)
+***********************************************************/
+#if defined(MEMORY_STATS)
+static mem_stats_t mem_stats;
+
+static void stats_reserve(size_t held, size_t requested)
+{
+  size_t live, peak;
+  uint32_t b;
+
+  live = __atomic_add_fetch(&mem_stats.live_bytes, held, __ATOMIC_RELAXED);
+  peak = __atomic_load_n(&mem_stats.peak_bytes, __ATOMIC_RELAXED);
+  while((live > peak) &&
+        !__atomic_compare_exchange_n(&mem_stats.peak_bytes, &peak, live, 1,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+  {
+  }
+
+  for(b = 0; (b < MEM_STATS_BUCKETS - 1) && (requested >> (b + 1)); b++)
+  {
+  }
+  __atomic_add_fetch(&mem_stats.histogram[b], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&mem_stats.reserve_calls, 1, __ATOMIC_RELAXED);
+}
+
+static void stats_release(size_t held)
+{
+  __atomic_sub_fetch(&mem_stats.live_bytes, held, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&mem_stats.free_calls, 1, __ATOMIC_RELAXED);
+}
+
+static void stats_failed(void)
+{
+  __atomic_add_fetch(&mem_stats.failed_calls, 1, __ATOMIC_RELAXED);
+}
+
+void memory_stats_snapshot(mem_stats_t * stats)
+{
+  uint32_t b;
+
+  stats->live_bytes = __atomic_load_n(&mem_stats.live_bytes,
+                                      __ATOMIC_RELAXED);
+  stats->peak_bytes = __atomic_load_n(&mem_stats.peak_bytes,
+                                      __ATOMIC_RELAXED);
+  stats->reserve_calls = __atomic_load_n(&mem_stats.reserve_calls,
+                                         __ATOMIC_RELAXED);
+  stats->free_calls = __atomic_load_n(&mem_stats.free_calls,
+                                      __ATOMIC_RELAXED);
+  stats->failed_calls = __atomic_load_n(&mem_stats.failed_calls,
+                                        __ATOMIC_RELAXED);
+  for(b = 0; b < MEM_STATS_BUCKETS; b++)
+  {
+    stats->histogram[b] = __atomic_load_n(&mem_stats.histogram[b],
+                                          __ATOMIC_RELAXED);
+  }
+}
+
+void memory_stats_reset(void)
+{
+  uint32_t b;
+
+  __atomic_store_n(&mem_stats.peak_bytes,
+                   __atomic_load_n(&mem_stats.live_bytes, __ATOMIC_RELAXED),
+                   __ATOMIC_RELAXED);
+  __atomic_store_n(&mem_stats.reserve_calls, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&mem_stats.free_calls, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&mem_stats.failed_calls, 0, __ATOMIC_RELAXED);
+  for(b = 0; b < MEM_STATS_BUCKETS; b++)
+  {
+    __atomic_store_n(&mem_stats.histogram[b], 0, __ATOMIC_RELAXED);
+  }
+}
+#else
+#define stats_reserve(held, requested) ((void)0)
+#define stats_release(held)            ((void)0)
+#define stats_failed()                 ((void)0)
+#endif
+
+/***********************************************************
+ Thread Caches (HOST only)
+***********************************************************/
+#if defined(HOST)
+/* Pool blocks are recycled through the caches of the same size */
+#if MEM_TCACHE_MIN_W != POOL_MIN_BLOCK_W
+#error "MEM_TCACHE_MIN_W must match POOL_MIN_BLOCK_W"
+#endif
+
+/* Class of the blocks too large for any thread cache */
+#define TCACHE_NONE (MEM_TCACHE_CLASSES)
+
+/* Overlays the payload of a block while it is cached */
+typedef struct mem_free_block
+{
+  struct mem_free_block * next;   /* Next block of the cache or batch */
+  struct mem_free_block * batch;  /* Next batch, in the shared lists only */
+} mem_free_block_t;
+
+typedef struct
+{
+  mem_free_block_t * head[MEM_TCACHE_CLASSES];
+  uint32_t count[MEM_TCACHE_CLASSES];
+  uint8_t registered;   /* Flushed by tcache_exit once set */
+} mem_tcache_t;
+
+static __thread mem_tcache_t tcache;
+
+/*
+ * Batches of malloc backed blocks returned by threads whose cache
+ * overflowed or exited; pool blocks go back to the pool instead. The
+ * static pool is only touched under the same lock, as it is not
+ * thread-safe itself.
+ */
+static struct
+{
+  pthread_mutex_t lock;
+  pthread_once_t once;
+  pthread_key_t key;
+  mem_free_block_t * batches[MEM_TCACHE_CLASSES];
+} shared = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_ONCE_INIT };
+
+/* Smallest class whose blocks hold length words, TCACHE_NONE if none */
+static uint32_t tcache_class(size_t length)
+{
+  uint32_t c = 0;
+
+  if(length > MEM_TCACHE_MIN_W)
+  {
+    c = (uint32_t)(sizeof(unsigned long) * 8 -
+                   __builtin_clzl((unsigned long)((length - 1) /
+                                                  MEM_TCACHE_MIN_W)));
+  }
+
+  return (c < MEM_TCACHE_CLASSES) ? c : TCACHE_NONE;
+}
+
+/*
+ * Takes up to count blocks of a class out of the cache. Pool blocks
+ * are released to the pool, the rest go to the shared lists as one
+ * batch.
+ */
+static void tcache_flush(uint32_t c, uint32_t count)
+{
+  mem_free_block_t * block = tcache.head[c];
+  mem_free_block_t * next;
+  mem_free_block_t * batch = (mem_free_block_t *)0;
+  uint32_t moved = 0;
+
+  if(!block)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&shared.lock);
+  for(; block && (moved < count); block = next, moved++)
+  {
+    next = block->next;
+    if(pool_owns((int32_t *)block))
+    {
+      pool_release((int32_t *)block);
+    }
+    else
+    {
+      block->next = batch;
+      batch = block;
+    }
+  }
+  if(batch)
+  {
+    batch->batch = shared.batches[c];
+    shared.batches[c] = batch;
+  }
+  pthread_mutex_unlock(&shared.lock);
+
+  tcache.head[c] = block;
+  tcache.count[c] -= moved;
+}
+
+/* Thread exit: hands every cached block back to the shared lists */
+static void tcache_exit(void * arg)
+{
+  uint32_t c;
+
+  (void)arg;
+  for(c = 0; c < MEM_TCACHE_CLASSES; c++)
+  {
+    tcache_flush(c, (uint32_t)-1);
+  }
+}
+
+static void tcache_key_init(void)
+{
+  pthread_key_create(&shared.key, tcache_exit);
+}
+
+static void tcache_register(void)
+{
+  pthread_once(&shared.once, tcache_key_init);
+  pthread_setspecific(shared.key, &tcache);
+  tcache.registered = 1;
+}
+
+/* Takes a pool block, else a batch from the shared lists or malloc */
+static int32_t * tcache_refill(uint32_t c)
+{
+  size_t words = (size_t)MEM_TCACHE_MIN_W << c;
+  mem_free_block_t * batch, * block;
+  mem_block_hdr_t * hdr;
+  int32_t * ptr = (int32_t *)0;
+  uint32_t count = 0;
+
+  if(!tcache.registered)
+  {
+    tcache_register();
+  }
+
+  pthread_mutex_lock(&shared.lock);
+  ptr = pool_reserve(words);
+  batch = ptr ? (mem_free_block_t *)0 : shared.batches[c];
+  if(batch)
+  {
+    shared.batches[c] = batch->batch;
+  }
+  pthread_mutex_unlock(&shared.lock);
+
+  if(batch)
+  {
+    tcache.head[c] = batch->next;
+    for(block = batch->next; block; block = block->next)
+    {
+      count++;
+    }
+    tcache.count[c] = count;
+    return (int32_t *)batch;
+  }
+
+  if(!ptr)
+  {
+    hdr = malloc(sizeof(mem_block_hdr_t) + sizeof(int32_t) * words);
+    if(hdr)
+    {
+      hdr->cls = c;
+      ptr = (int32_t *)(hdr + 1);
+    }
+  }
+
+  return ptr;
+}
+
+static int32_t * tcache_pop(uint32_t c)
+{
+  mem_free_block_t * block = tcache.head[c];
+
+  if(!block)
+  {
+    return tcache_refill(c);
+  }
+  tcache.head[c] = block->next;
+  tcache.count[c]--;
+
+  return (int32_t *)block;
+}
+
+static void tcache_push(int32_t * src, uint32_t c)
+{
+  mem_free_block_t * block = (mem_free_block_t *)src;
+
+  if(!tcache.registered)
+  {
+    tcache_register();
+  }
+  if(tcache.count[c] >= MEM_TCACHE_DEPTH)
+  {
+    tcache_flush(c, MEM_TCACHE_BATCH);
+  }
+  block->next = tcache.head[c];
+  tcache.head[c] = block;
+  tcache.count[c]++;
+}
+
+int32_t * reserve_words(size_t length)
+{
+  uint32_t c = tcache_class(length);
+  size_t bytes = sizeof(int32_t) * length;
+  mem_block_hdr_t * hdr;
+  int32_t * ptr;
+
+  if(c != TCACHE_NONE)
+  {
+    ptr = tcache_pop(c);
+  }
+  else
+  {
+    hdr = malloc(sizeof(mem_block_hdr_t) + bytes);
+    ptr = hdr ? (int32_t *)(hdr + 1) : (int32_t *)0;
+    if(hdr)
+    {
+      hdr->cls = TCACHE_NONE;
+    }
+  }
+
+  if(!ptr)
+  {
+    stats_failed();
+    return ptr;
+  }
+  if(pool_owns(ptr))
+  {
+    stats_reserve(sizeof(int32_t) * pool_block_words(ptr), bytes);
+  }
+  else
+  {
+    hdr = (mem_block_hdr_t *)ptr - 1;
+    hdr->bytes = bytes;
+    stats_reserve(bytes, bytes);
+  }
+
+  return ptr;
+}
+
+void free_words(int32_t * src)
+{
+  mem_block_hdr_t * hdr;
+  size_t words;
+
+  if(!src)
+  {
+    return;
+  }
+
+  /* Pool blocks are cached too, and reach the pool when flushed */
+  if(pool_owns(src))
+  {
+    words = pool_block_words(src);
+    stats_release(sizeof(int32_t) * words);
+    tcache_push(src, tcache_class(words));
+    return;
+  }
+
+  hdr = (mem_block_hdr_t *)src - 1;
+  stats_release(hdr->bytes);
+  if(hdr->cls != TCACHE_NONE)
+  {
+    tcache_push(src, (uint32_t)hdr->cls);
+  }
+  else
+  {
+    free(hdr);
+  }
+}
+#elif defined(MEMORY_STATS)
+int32_t * reserve_words(size_t length)
+{
+  int32_t *ptr = pool_reserve(length);
+  size_t bytes = sizeof(int32_t) * length;
+  mem_block_hdr_t * hdr;
+
+  if(ptr)
+  {
+    stats_reserve(sizeof(int32_t) * pool_block_words(ptr), bytes);
+    return ptr;
+  }
+
+  hdr = malloc(sizeof(mem_block_hdr_t) + bytes);
+  if(!hdr)
+  {
+    stats_failed();
+    return (int32_t *)0;
+  }
+  hdr->bytes = bytes;
+  stats_reserve(bytes, bytes);
+
+  return (int32_t *)(hdr + 1);
+}
+
+void free_words(int32_t * src)
+{
+  mem_block_hdr_t * hdr;
+
+  if(!src)
+  {
+    return;
+  }
+
+  if(pool_owns(src))
+  {
+    stats_release(sizeof(int32_t) * pool_block_words(src));
+    pool_release(src);
+  }
+  else
+  {
+    hdr = (mem_block_hdr_t *)src - 1;
+    stats_release(hdr->bytes);
+    free(hdr);
+  }
+}
+#else
+int32_t * reserve_words(size_t length)
+{
+  int32_t *ptr = pool_reserve(length);
+
+  if(!ptr)
+  {
+    ptr = malloc(sizeof(int32_t) * length);
+  }
+
+  return ptr;
+}
+
+void free_words(int32_t * src)
+{
+  if(pool_owns(src))
+  {
+    pool_release(src);
+  }
+  else
+  {
+    free(src);
+  }
+}
+#endif
+
+#if defined(HOST)
+/* Mappings made by reserve_aligned, the only memory my_memzero remaps */
+#define MEM_MAP_SLOTS (64)
+
+static struct
+{
+  pthread_mutex_t lock;
+  struct
+  {
+    uint8_t * start;  /* Buffer handed out, null if the slot is free */
+    size_t length;    /* Size of the buffer */
+    size_t page;      /* Page size backing it */
+  } slot[MEM_MAP_SLOTS];
+} mem_maps = { PTHREAD_MUTEX_INITIALIZER };
+
+/* A full registry only means the buffer is zeroed with stores */
+static void map_register(uint8_t * start, size_t length, size_t page)
+{
+  size_t i;
+
+  pthread_mutex_lock(&mem_maps.lock);
+  for(i = 0; i < MEM_MAP_SLOTS; i++)
+  {
+    if(!mem_maps.slot[i].start)
+    {
+      mem_maps.slot[i].start = start;
+      mem_maps.slot[i].length = length;
+      mem_maps.slot[i].page = page;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mem_maps.lock);
+}
+
+static void map_unregister(uint8_t * start)
+{
+  size_t i;
+
+  pthread_mutex_lock(&mem_maps.lock);
+  for(i = 0; i < MEM_MAP_SLOTS; i++)
+  {
+    if(mem_maps.slot[i].start == start)
+    {
+      mem_maps.slot[i].start = (uint8_t *)0;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mem_maps.lock);
+}
+
+/* Page size of the registered mapping holding a range, 0 if none */
+static size_t map_page(const uint8_t * src, size_t length)
+{
+  size_t i, page = 0;
+
+  pthread_mutex_lock(&mem_maps.lock);
+  for(i = 0; i < MEM_MAP_SLOTS; i++)
+  {
+    if(mem_maps.slot[i].start && (src >= mem_maps.slot[i].start) &&
+       (length <= mem_maps.slot[i].length) &&
+       ((size_t)(src - mem_maps.slot[i].start) <=
+        mem_maps.slot[i].length - length))
+    {
+      page = mem_maps.slot[i].page;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mem_maps.lock);
+
+  return page;
+}
+
+/*
+ * Zeroes the whole pages of a registered mapping by dropping them, so
+ * the kernel maps in zero pages on the next touch, and stores zeros
+ * over the partial pages at both ends. Returns 0, having written
+ * nothing, if the range is not eligible or madvise fails.
+ */
+static uint8_t memzero_remap(uint8_t * src, size_t length)
+{
+  size_t page = map_page(src, length);
+  uintptr_t lo, hi;
+
+  if(!page)
+  {
+    return 0;
+  }
+  lo = ((uintptr_t)src + page - 1) & ~(uintptr_t)(page - 1);
+  hi = ((uintptr_t)src + length) & ~(uintptr_t)(page - 1);
+  if((hi <= lo) || madvise((void *)lo, hi - lo, MADV_DONTNEED))
+  {
+    return 0;
+  }
+
+  mem_fill(src, 0, lo - (uintptr_t)src, 0);
+  mem_fill((uint8_t *)hi, 0, (uintptr_t)src + length - hi, 0);
+
+  return 1;
+}
+
+/*
+ * Maps a buffer on its own pages. With a huge page flag that is
+ * MAP_HUGETLB if asked for and available, otherwise a normal
+ * anonymous mapping trimmed to a huge page boundary (and any larger
+ * alignment) and marked MADV_HUGEPAGE. The header and the alignment
+ * padding come before the buffer on the first page.
+ */
+static uint8_t * aligned_map(size_t size, size_t alignment, uint32_t flags)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t offset = (sizeof(mem_aligned_hdr_t) + alignment - 1) &
+                  ~(alignment - 1);
+  size_t boundary, length;
+  mem_aligned_hdr_t * hdr;
+  uint8_t * base = MAP_FAILED;
+  uint8_t * start = MAP_FAILED;
+
+  if(flags & (MEM_ALIGNED_THP | MEM_ALIGNED_HUGETLB))
+  {
+    page = MEM_HUGE_PAGE_SIZE;
+  }
+  boundary = (alignment > page) ? alignment : page;
+  length = (offset + size + page - 1) & ~(page - 1);
+
+#if defined(MAP_HUGETLB)
+  if((flags & MEM_ALIGNED_HUGETLB) && (alignment <= MEM_HUGE_PAGE_SIZE))
+  {
+    base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    start = base;
+  }
+#endif
+
+  if(base == MAP_FAILED)
+  {
+    length += boundary;
+    base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED)
+    {
+      return (uint8_t *)0;
+    }
+    start = (uint8_t *)(((uintptr_t)base + boundary - 1) & ~(boundary - 1));
+#if defined(MADV_HUGEPAGE)
+    /* Only a hint, the mapping works on small pages if it is refused */
+    if(page == MEM_HUGE_PAGE_SIZE)
+    {
+      madvise(start, length - (size_t)(start - base), MADV_HUGEPAGE);
+    }
+#endif
+    /* Transparent huge pages are split when partly dropped */
+    page = (size_t)sysconf(_SC_PAGESIZE);
+  }
+
+  hdr = (mem_aligned_hdr_t *)(start + offset) - 1;
+  hdr->base = base;
+  hdr->length = length;
+  map_register(start + offset, size, page);
+
+  return start + offset;
+}
+#endif
+
+uint8_t * reserve_aligned(size_t size, size_t alignment, uint32_t flags)
+{
+  mem_aligned_hdr_t * hdr;
+  uint8_t * base;
+  uint8_t * ptr;
+
+  if((alignment == 0) || (alignment & (alignment - 1)))
+  {
+    return (uint8_t *)0;
+  }
+
+#if defined(HOST)
+  if((flags & (MEM_ALIGNED_THP | MEM_ALIGNED_HUGETLB)) ||
+     (size >= MEM_ALIGNED_MAP_THRESHOLD))
+  {
+    return aligned_map(size, alignment, flags);
+  }
+#else
+  (void)flags;
+  ptr = (uint8_t *)pool_reserve_aligned(
+      (size + sizeof(int32_t) - 1) / sizeof(int32_t), alignment);
+  if(ptr)
+  {
+    return ptr;
+  }
+#endif
+
+  /* Heap: room for the header and for sliding up to the alignment */
+  if(size > (size_t)-1 - sizeof(mem_aligned_hdr_t) - alignment)
+  {
+    return (uint8_t *)0;
+  }
+  base = malloc(size + sizeof(mem_aligned_hdr_t) + alignment);
+  if(!base)
+  {
+    return (uint8_t *)0;
+  }
+  ptr = (uint8_t *)(((uintptr_t)base + sizeof(mem_aligned_hdr_t) +
+                     alignment - 1) & ~(uintptr_t)(alignment - 1));
+  hdr = (mem_aligned_hdr_t *)ptr - 1;
+  hdr->base = base;
+  hdr->length = 0;
+
+  return ptr;
+}
+
+void free_aligned(uint8_t * src)
+{
+  mem_aligned_hdr_t * hdr;
+
+  if(!src)
+  {
+    return;
+  }
+
+  if(pool_owns((int32_t *)src))
+  {
+    pool_release((int32_t *)src);
+    return;
+  }
+
+  hdr = (mem_aligned_hdr_t *)src - 1;
+#if defined(HOST)
+  if(hdr->length)
+  {
+    map_unregister(src);
+    munmap(hdr->base, hdr->length);
+    return;
+  }
+#endif
+  free(hdr->base);
+}
+
+void arena_create(mem_arena_t * arena, uint8_t * buffer, size_t size)
+{
+  arena->base = buffer;
+  arena->size = buffer ? size : 0;
+  arena->used = 0;
+}
+
+uint8_t * arena_alloc(mem_arena_t * arena, size_t length, size_t align)
+{
+  uintptr_t next;
+  size_t pad;
+
+  if(align == 0)
+  {
+    align = ARENA_DEFAULT_ALIGN;
+  }
+
+  if(align & (align - 1))
+  {
+    return (uint8_t *)0;
+  }
+
+  next = (uintptr_t)(arena->base + arena->used);
+  pad = (0 - next) & (align - 1);
+  if((pad > arena->size - arena->used) ||
+     (length > arena->size - arena->used - pad))
+  {
+    return (uint8_t *)0;
+  }
+
+  arena->used += pad + length;
+
+  return (uint8_t *)(next + pad);
+}
+
+mem_arena_mark_t arena_mark(const mem_arena_t * arena)
+{
+  return arena->used;
+}
+
+void arena_rewind(mem_arena_t * arena, mem_arena_mark_t mark)
+{
+  if(mark <= arena->used)
+  {
+    arena->used = mark;
+  }
+}
+
+void arena_reset(mem_arena_t * arena)
+{
+  arena->used = 0;
+}
+
+uint8_t memory_select_variant(mem_variant_t variant)
+{
+#if defined(MEM_KERNELS_X86)
+  const mem_kernels_t * kernels;
+
+  if(variant == MEM_VARIANT_AUTO)
+  {
+    variant = MEM_VARIANT_AVX512;
+    while(!mem_kernels_supported(mem_variant_kernels[variant]))
+    {
+      variant--;
+    }
+  }
+  if((variant <= MEM_VARIANT_AUTO) || (variant >= MEM_VARIANT_COUNT))
+  {
+    return 0;
+  }
+
+  kernels = mem_variant_kernels[variant];
+  if(!mem_kernels_supported(kernels))
+  {
+    return 0;
+  }
+  mem_kernels = kernels;
+  mem_variant = variant;
+
+  return 1;
+#else
+  return (variant == MEM_VARIANT_AUTO) || (variant == MEM_VARIANT_WORD);
+#endif
+}
+
+mem_variant_t memory_get_variant(void)
+{
+  return mem_variant;
+}
+
+const char * memory_variant_name(mem_variant_t variant)
+{
+  if((variant < MEM_VARIANT_AUTO) || (variant >= MEM_VARIANT_COUNT))
+  {
+    return "unknown";
+  }
+
+  return mem_variant_names[variant];
 }
@@ -0,0 +1,302 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file memory_parallel.c
+ * @brief Multi-threaded copy and fill for very large buffers (HOST only)
+ *
+ * Workers sleep on a condition variable until the caller publishes a
+ * job, then every thread (caller included) pulls chunk indexes from a
+ * shared atomic counter until the job runs out. The caller returns
+ * once all workers have reported back.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 16 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <unistd.h>
+#include "memory_parallel.h"
+#include "memory_kernels.h"
+#include "memory.h"
+
+typedef enum
+{
+  PAR_COPY,
+  PAR_FILL
+} par_op_t;
+
+typedef struct
+{
+  par_op_t op;
+  const uint8_t * src;
+  uint8_t * dst;
+  size_t length;
+  uint8_t value;
+  int stream;
+  uintptr_t base;   /* dst rounded down to a chunk boundary */
+  size_t chunk;     /* Chunk size, a multiple of MEMORY_PARALLEL_PAGE */
+  size_t chunks;    /* Number of chunks in the job */
+} par_job_t;
+
+static struct
+{
+  pthread_mutex_t call;   /* Serializes parallel operations */
+  pthread_mutex_t lock;   /* Protects everything below */
+  pthread_cond_t start;
+  pthread_cond_t done;
+  pthread_t workers[MEMORY_PARALLEL_MAX_THREADS - 1];
+  size_t count;           /* Worker threads, caller excluded */
+  size_t busy;            /* Workers still on the current job */
+  unsigned generation;    /* Bumped for every published job */
+  int stop;
+  par_job_t job;
+  size_t next;            /* Next chunk index, taken atomically */
+} par =
+{
+  PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+  PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER
+};
+
+static int par_started;
+static size_t par_cutoff = MEMORY_PARALLEL_CUTOFF_DEFAULT;
+
+/* Smallest chunk worth a trip through the counter */
+#define PAR_MIN_CHUNK ((size_t)256 * 1024)
+
+/* Chunks per thread, so faster threads can pick up slack */
+#define PAR_CHUNKS_PER_THREAD (4)
+
+/***********************************************************
+ Worker Side
+***********************************************************/
+static void par_run_chunks(const par_job_t * job)
+{
+  uintptr_t start, end, lo = (uintptr_t)job->dst;
+  uintptr_t hi = lo + job->length;
+  size_t i;
+
+  while((i = __atomic_fetch_add(&par.next, 1, __ATOMIC_RELAXED)) < job->chunks)
+  {
+    start = job->base + i * job->chunk;
+    end = start + job->chunk;
+    start = (start < lo) ? lo : start;
+    end = (end > hi) ? hi : end;
+
+    if(job->op == PAR_COPY)
+    {
+      my_memcopy((uint8_t *)job->src + (start - lo), (uint8_t *)start,
+                 end - start);
+    }
+    else
+    {
+      mem_fill((uint8_t *)start, job->value, end - start, job->stream);
+    }
+  }
+}
+
+/*
+ * arg carries the generation published when the worker was created, so
+ * it only joins jobs counted in par.busy after it was started.
+ */
+static void * par_worker(void * arg)
+{
+  unsigned seen = (unsigned)(uintptr_t)arg;
+  par_job_t job;
+
+  for(;;)
+  {
+    pthread_mutex_lock(&par.lock);
+    while(!par.stop && (par.generation == seen))
+    {
+      pthread_cond_wait(&par.start, &par.lock);
+    }
+    if(par.stop)
+    {
+      pthread_mutex_unlock(&par.lock);
+      return NULL;
+    }
+    seen = par.generation;
+    job = par.job;
+    pthread_mutex_unlock(&par.lock);
+
+    par_run_chunks(&job);
+
+    pthread_mutex_lock(&par.lock);
+    if(--par.busy == 0)
+    {
+      pthread_cond_signal(&par.done);
+    }
+    pthread_mutex_unlock(&par.lock);
+  }
+}
+
+/***********************************************************
+ Caller Side
+***********************************************************/
+static void par_stop_workers(void)
+{
+  size_t i;
+
+  pthread_mutex_lock(&par.lock);
+  par.stop = 1;
+  pthread_cond_broadcast(&par.start);
+  pthread_mutex_unlock(&par.lock);
+
+  for(i = 0; i < par.count; i++)
+  {
+    pthread_join(par.workers[i], NULL);
+  }
+  par.count = 0;
+  par.stop = 0;
+}
+
+static uint8_t par_start_workers(size_t threads)
+{
+  unsigned generation;
+  long cpus;
+
+  if(threads == 0)
+  {
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (cpus > 0) ? (size_t)cpus : 1;
+  }
+  if(threads > MEMORY_PARALLEL_MAX_THREADS)
+  {
+    threads = MEMORY_PARALLEL_MAX_THREADS;
+  }
+
+  pthread_mutex_lock(&par.lock);
+  generation = par.generation;
+  pthread_mutex_unlock(&par.lock);
+
+  par_started = 1;
+  while(par.count < threads - 1)
+  {
+    if(pthread_create(&par.workers[par.count], NULL, par_worker,
+                      (void *)(uintptr_t)generation))
+    {
+      break;
+    }
+    par.count++;
+  }
+
+  return (threads == 1) || (par.count > 0);
+}
+
+static void par_execute(par_job_t * job)
+{
+  size_t threads;
+
+  pthread_mutex_lock(&par.call);
+  if(!par_started)
+  {
+    par_start_workers(0);
+  }
+
+  threads = par.count + 1;
+  job->chunk = job->length / (threads * PAR_CHUNKS_PER_THREAD);
+  if(job->chunk < PAR_MIN_CHUNK)
+  {
+    job->chunk = PAR_MIN_CHUNK;
+  }
+  job->chunk = (job->chunk + MEMORY_PARALLEL_PAGE - 1) &
+               ~(size_t)(MEMORY_PARALLEL_PAGE - 1);
+  job->base = (uintptr_t)job->dst & ~(uintptr_t)(MEMORY_PARALLEL_PAGE - 1);
+  job->chunks = ((uintptr_t)job->dst + job->length - job->base +
+                 job->chunk - 1) / job->chunk;
+
+  pthread_mutex_lock(&par.lock);
+  par.job = *job;
+  par.next = 0;
+  par.busy = par.count;
+  par.generation++;
+  pthread_cond_broadcast(&par.start);
+  pthread_mutex_unlock(&par.lock);
+
+  par_run_chunks(job);
+
+  pthread_mutex_lock(&par.lock);
+  while(par.busy)
+  {
+    pthread_cond_wait(&par.done, &par.lock);
+  }
+  pthread_mutex_unlock(&par.lock);
+  pthread_mutex_unlock(&par.call);
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+uint8_t memory_parallel_init(size_t threads)
+{
+  uint8_t ret;
+
+  pthread_mutex_lock(&par.call);
+  par_stop_workers();
+  ret = par_start_workers(threads);
+  pthread_mutex_unlock(&par.call);
+
+  return ret;
+}
+
+void memory_parallel_shutdown(void)
+{
+  pthread_mutex_lock(&par.call);
+  par_stop_workers();
+  par_started = 0;
+  pthread_mutex_unlock(&par.call);
+}
+
+size_t memory_parallel_threads(void)
+{
+  return par.count + 1;
+}
+
+void memory_parallel_set_cutoff(size_t cutoff)
+{
+  par_cutoff = cutoff;
+}
+
+uint8_t * my_memcopy_parallel(uint8_t * src, uint8_t * dst, size_t length)
+{
+  par_job_t job = { PAR_COPY };
+
+  if(length < par_cutoff)
+  {
+    return my_memcopy(src, dst, length);
+  }
+
+  job.src = src;
+  job.dst = dst;
+  job.length = length;
+  par_execute(&job);
+
+  return dst;
+}
+
+uint8_t * my_memset_parallel(uint8_t * src, size_t length, uint8_t value)
+{
+  par_job_t job = { PAR_FILL };
+
+  if(length < par_cutoff)
+  {
+    return my_memset(src, length, value);
+  }
+
+  job.dst = src;
+  job.length = length;
+  job.value = value;
+  job.stream = (length >= my_memset_get_nt_threshold());
+  par_execute(&job);
+
+  return src;
+}
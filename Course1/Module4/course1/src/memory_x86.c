@@ -0,0 +1,1307 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file memory_x86.c
+ * @brief SSE2, AVX2 and AVX-512 kernels of the memory module
+ *
+ * Every kernel is compiled with a target attribute rather than global
+ * -m flags, so a single HOST binary carries all of them and memory.c
+ * picks one at startup from the CPUID bits (see memory_select_variant).
+ *
+ * @author Mahmoud Hamdy
+ * @date October 14 2020
+ *
+ */
+#include "memory_kernels.h"
+
+#if defined(MEM_KERNELS_X86)
+#include <immintrin.h>
+
+#define SSE2_TARGET   __attribute__((__target__("sse2")))
+#define AVX2_TARGET   __attribute__((__target__("avx2")))
+#define AVX512_TARGET __attribute__((__target__("avx512f,avx512bw")))
+
+/*
+ * Byte shuffles reversing every 2, 4 or 8 byte element of a 128-bit
+ * lane, indexed by width >> 2.
+ */
+static const uint8_t swap_masks[3][16] __attribute__((__aligned__(16))) =
+{
+  { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+  { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+  { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+};
+
+/*
+ * Byte shuffles for the AVX2 (de)interleave kernels, indexed by
+ * channels - 2 (two or three) and width >> 1. A group of 16 * channels
+ * interleaved bytes is held in channels vectors; for a split, output
+ * vector c is the OR of input vector k shuffled by
+ * split[c * channels + k], for a merge output vector k is the OR of
+ * channel c shuffled by merge[k * channels + c].
+ * Lanes that take nothing from a vector are 0x80, which pshufb zeroes.
+ */
+static uint8_t ilv_split_masks[2][3][9][16] __attribute__((__aligned__(16)));
+static uint8_t ilv_merge_masks[2][3][9][16] __attribute__((__aligned__(16)));
+
+__attribute__((__constructor__))
+static void ilv_masks_init(void)
+{
+  size_t channels, width, c, k, j, idx;
+
+  for(channels = 2; channels <= 3; channels++)
+  {
+    for(width = 1; width <= 4; width <<= 1)
+    {
+      uint8_t (*split)[16] = ilv_split_masks[channels - 2][width >> 1];
+      uint8_t (*merge)[16] = ilv_merge_masks[channels - 2][width >> 1];
+
+      for(c = 0; c < channels; c++)
+      {
+        for(k = 0; k < channels; k++)
+        {
+          for(j = 0; j < 16; j++)
+          {
+            /* Group byte that lands in byte j of channel c */
+            idx = ((j / width) * channels + c) * width + j % width;
+            split[c * channels + k][j] =
+                (idx / 16 == k) ? (uint8_t)(idx % 16) : 0x80;
+
+            /* Group byte j of vector k, if it belongs to channel c */
+            idx = k * 16 + j;
+            merge[k * channels + c][j] =
+                ((idx / width) % channels == c) ?
+                (uint8_t)(idx / (width * channels) * width + idx % width) :
+                0x80;
+          }
+        }
+      }
+    }
+  }
+}
+
+/***********************************************************
+ SSE2 Kernels (16-byte vectors, 64-byte blocks)
+***********************************************************/
+SSE2_TARGET
+static void sse2_copy_fwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+    __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+    _mm_store_si128((__m128i *)(dst), a);
+    _mm_store_si128((__m128i *)(dst + 16), b);
+    _mm_store_si128((__m128i *)(dst + 32), c);
+    _mm_store_si128((__m128i *)(dst + 48), d);
+    src += 64;
+    dst += 64;
+  }
+}
+
+SSE2_TARGET
+static void sse2_copy_bwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    src -= 64;
+    dst -= 64;
+    __m128i a = _mm_loadu_si128((const __m128i *)(src + 48));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + 32));
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + 16));
+    __m128i d = _mm_loadu_si128((const __m128i *)(src));
+    _mm_store_si128((__m128i *)(dst + 48), a);
+    _mm_store_si128((__m128i *)(dst + 32), b);
+    _mm_store_si128((__m128i *)(dst + 16), c);
+    _mm_store_si128((__m128i *)(dst), d);
+  }
+}
+
+SSE2_TARGET
+static void sse2_fill(uint8_t * dst, uint8_t value, size_t blocks, int stream)
+{
+  __m128i v = _mm_set1_epi8((char)value);
+
+  if(stream)
+  {
+    while(blocks--)
+    {
+      _mm_stream_si128((__m128i *)(dst), v);
+      _mm_stream_si128((__m128i *)(dst + 16), v);
+      _mm_stream_si128((__m128i *)(dst + 32), v);
+      _mm_stream_si128((__m128i *)(dst + 48), v);
+      dst += 64;
+    }
+    _mm_sfence();
+    return;
+  }
+
+  while(blocks--)
+  {
+    _mm_store_si128((__m128i *)(dst), v);
+    _mm_store_si128((__m128i *)(dst + 16), v);
+    _mm_store_si128((__m128i *)(dst + 32), v);
+    _mm_store_si128((__m128i *)(dst + 48), v);
+    dst += 64;
+  }
+}
+
+/* 17 to 32 bytes as two overlapping vectors, less through the words */
+static inline __attribute__((__always_inline__)) SSE2_TARGET
+void sse2_copy_upto32(uint8_t * dst, const uint8_t * src, size_t length)
+{
+  if(length > 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + length - 16));
+    _mm_storeu_si128((__m128i *)(dst), a);
+    _mm_storeu_si128((__m128i *)(dst + length - 16), b);
+  }
+  else
+  {
+    mem_copy_upto16(dst, src, length);
+  }
+}
+
+static inline __attribute__((__always_inline__)) SSE2_TARGET
+void sse2_fill_upto32(uint8_t * dst, uint8_t value, size_t length)
+{
+  if(length > 16)
+  {
+    __m128i v = _mm_set1_epi8((char)value);
+    _mm_storeu_si128((__m128i *)(dst), v);
+    _mm_storeu_si128((__m128i *)(dst + length - 16), v);
+  }
+  else
+  {
+    mem_fill_upto16(dst, value, length);
+  }
+}
+
+/* Up to 128 bytes, two blocks, as the first and last 64 */
+SSE2_TARGET
+static void sse2_copy_short(uint8_t * dst, const uint8_t * src,
+                            size_t length)
+{
+  if(length > 64)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+    __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+    __m128i e = _mm_loadu_si128((const __m128i *)(src + length - 64));
+    __m128i f = _mm_loadu_si128((const __m128i *)(src + length - 48));
+    __m128i g = _mm_loadu_si128((const __m128i *)(src + length - 32));
+    __m128i h = _mm_loadu_si128((const __m128i *)(src + length - 16));
+    _mm_storeu_si128((__m128i *)(dst), a);
+    _mm_storeu_si128((__m128i *)(dst + 16), b);
+    _mm_storeu_si128((__m128i *)(dst + 32), c);
+    _mm_storeu_si128((__m128i *)(dst + 48), d);
+    _mm_storeu_si128((__m128i *)(dst + length - 64), e);
+    _mm_storeu_si128((__m128i *)(dst + length - 48), f);
+    _mm_storeu_si128((__m128i *)(dst + length - 32), g);
+    _mm_storeu_si128((__m128i *)(dst + length - 16), h);
+  }
+  else if(length > 32)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + length - 32));
+    __m128i d = _mm_loadu_si128((const __m128i *)(src + length - 16));
+    _mm_storeu_si128((__m128i *)(dst), a);
+    _mm_storeu_si128((__m128i *)(dst + 16), b);
+    _mm_storeu_si128((__m128i *)(dst + length - 32), c);
+    _mm_storeu_si128((__m128i *)(dst + length - 16), d);
+  }
+  else
+  {
+    sse2_copy_upto32(dst, src, length);
+  }
+}
+
+SSE2_TARGET
+static void sse2_fill_short(uint8_t * dst, uint8_t value, size_t length)
+{
+  if(length > 32)
+  {
+    __m128i v = _mm_set1_epi8((char)value);
+    _mm_storeu_si128((__m128i *)(dst), v);
+    _mm_storeu_si128((__m128i *)(dst + 16), v);
+    _mm_storeu_si128((__m128i *)(dst + length - 32), v);
+    _mm_storeu_si128((__m128i *)(dst + length - 16), v);
+    if(length > 64)
+    {
+      _mm_storeu_si128((__m128i *)(dst + 32), v);
+      _mm_storeu_si128((__m128i *)(dst + 48), v);
+      _mm_storeu_si128((__m128i *)(dst + length - 64), v);
+      _mm_storeu_si128((__m128i *)(dst + length - 48), v);
+    }
+  }
+  else
+  {
+    sse2_fill_upto32(dst, value, length);
+  }
+}
+
+/*
+ * Reverses the 16 bytes of a vector with SSE2 only: dwords first, then
+ * the halfwords inside each dword, then the bytes inside each halfword.
+ */
+SSE2_TARGET
+static __m128i sse2_reverse_vec(__m128i v)
+{
+  v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+SSE2_TARGET
+static void sse2_reverse(uint8_t * left, uint8_t * right, size_t blocks)
+{
+  while(blocks--)
+  {
+    right -= 16;
+    __m128i a = _mm_loadu_si128((const __m128i *)left);
+    __m128i b = _mm_loadu_si128((const __m128i *)right);
+    _mm_storeu_si128((__m128i *)left, sse2_reverse_vec(b));
+    _mm_storeu_si128((__m128i *)right, sse2_reverse_vec(a));
+    left += 16;
+  }
+}
+
+/*
+ * Element byte swap with SSE2 only, the last steps of sse2_reverse_vec:
+ * dwords inside each qword, halfwords inside each dword, then bytes.
+ */
+SSE2_TARGET
+static __m128i sse2_swap_vec(__m128i v, size_t width)
+{
+  if(width == 8)
+  {
+    v = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+  }
+  if(width >= 4)
+  {
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  }
+
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+SSE2_TARGET
+static void sse2_swap(uint8_t * dst, const uint8_t * src, size_t blocks,
+                      size_t width)
+{
+  while(blocks--)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+    __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+    _mm_storeu_si128((__m128i *)(dst), sse2_swap_vec(a, width));
+    _mm_storeu_si128((__m128i *)(dst + 16), sse2_swap_vec(b, width));
+    _mm_storeu_si128((__m128i *)(dst + 32), sse2_swap_vec(c, width));
+    _mm_storeu_si128((__m128i *)(dst + 48), sse2_swap_vec(d, width));
+    src += 64;
+    dst += 64;
+  }
+}
+
+/* Even and odd width byte elements of a then b, in order */
+static inline __attribute__((__always_inline__)) SSE2_TARGET
+void sse2_unzip(__m128i a, __m128i b, size_t width, __m128i * even,
+                       __m128i * odd)
+{
+  if(width == 1)
+  {
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    *even = _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low));
+    *odd = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+  }
+  else if(width == 2)
+  {
+    /* Sign extended halves, which packs_epi32 passes through unclipped */
+    *even = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                            _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+    *odd = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+  }
+  else
+  {
+    *even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                            _mm_castsi128_ps(b),
+                                            _MM_SHUFFLE(2, 0, 2, 0)));
+    *odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                           _mm_castsi128_ps(b),
+                                           _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+}
+
+/* The reverse of sse2_unzip: elements of a and b taken in turn */
+static inline __attribute__((__always_inline__)) SSE2_TARGET
+void sse2_zip(__m128i a, __m128i b, size_t width, __m128i * lo,
+                     __m128i * hi)
+{
+  if(width == 1)
+  {
+    *lo = _mm_unpacklo_epi8(a, b);
+    *hi = _mm_unpackhi_epi8(a, b);
+  }
+  else if(width == 2)
+  {
+    *lo = _mm_unpacklo_epi16(a, b);
+    *hi = _mm_unpackhi_epi16(a, b);
+  }
+  else
+  {
+    *lo = _mm_unpacklo_epi32(a, b);
+    *hi = _mm_unpackhi_epi32(a, b);
+  }
+}
+
+/*
+ * Two channels are one unzip, four channels two rounds of them. Three
+ * channels have no cheap SSE2 form and go to the word kernel.
+ */
+SSE2_TARGET
+static void sse2_deinterleave(uint8_t * const * dst, const uint8_t * src,
+                              size_t blocks, size_t channels, size_t width)
+{
+  size_t offset = 0;
+
+  if(channels == 3)
+  {
+    mem_kernels_word.deinterleave(dst, src,
+                                  blocks * (16 / mem_kernels_word.ilv_block),
+                                  channels, width);
+    return;
+  }
+
+  while(blocks--)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+    __m128i e, o;
+    sse2_unzip(a, b, width, &e, &o);
+    if(channels == 2)
+    {
+      _mm_storeu_si128((__m128i *)(dst[0] + offset), e);
+      _mm_storeu_si128((__m128i *)(dst[1] + offset), o);
+      src += 32;
+    }
+    else
+    {
+      __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+      __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+      __m128i e2, o2;
+      sse2_unzip(c, d, width, &e2, &o2);
+      sse2_unzip(e, e2, width, &a, &c);
+      sse2_unzip(o, o2, width, &b, &d);
+      _mm_storeu_si128((__m128i *)(dst[0] + offset), a);
+      _mm_storeu_si128((__m128i *)(dst[1] + offset), b);
+      _mm_storeu_si128((__m128i *)(dst[2] + offset), c);
+      _mm_storeu_si128((__m128i *)(dst[3] + offset), d);
+      src += 64;
+    }
+    offset += 16;
+  }
+}
+
+SSE2_TARGET
+static void sse2_interleave(uint8_t * dst, const uint8_t * const * src,
+                            size_t blocks, size_t channels, size_t width)
+{
+  size_t offset = 0;
+
+  if(channels == 3)
+  {
+    mem_kernels_word.interleave(dst, src,
+                                blocks * (16 / mem_kernels_word.ilv_block),
+                                channels, width);
+    return;
+  }
+
+  while(blocks--)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src[0] + offset));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src[1] + offset));
+    __m128i lo, hi;
+    if(channels == 2)
+    {
+      sse2_zip(a, b, width, &lo, &hi);
+      _mm_storeu_si128((__m128i *)(dst), lo);
+      _mm_storeu_si128((__m128i *)(dst + 16), hi);
+      dst += 32;
+    }
+    else
+    {
+      __m128i c = _mm_loadu_si128((const __m128i *)(src[2] + offset));
+      __m128i d = _mm_loadu_si128((const __m128i *)(src[3] + offset));
+      __m128i lo2, hi2;
+      sse2_zip(a, c, width, &lo, &hi);
+      sse2_zip(b, d, width, &lo2, &hi2);
+      sse2_zip(lo, lo2, width, &a, &b);
+      sse2_zip(hi, hi2, width, &c, &d);
+      _mm_storeu_si128((__m128i *)(dst), a);
+      _mm_storeu_si128((__m128i *)(dst + 16), b);
+      _mm_storeu_si128((__m128i *)(dst + 32), c);
+      _mm_storeu_si128((__m128i *)(dst + 48), d);
+      dst += 64;
+    }
+    offset += 16;
+  }
+}
+
+/***********************************************************
+ AVX2 Kernels (32-byte vectors, 128-byte blocks)
+***********************************************************/
+AVX2_TARGET
+static void avx2_copy_fwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + 64));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(src + 96));
+    _mm256_store_si256((__m256i *)(dst), a);
+    _mm256_store_si256((__m256i *)(dst + 32), b);
+    _mm256_store_si256((__m256i *)(dst + 64), c);
+    _mm256_store_si256((__m256i *)(dst + 96), d);
+    src += 128;
+    dst += 128;
+  }
+  _mm256_zeroupper();
+}
+
+AVX2_TARGET
+static void avx2_copy_bwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    src -= 128;
+    dst -= 128;
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src + 96));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + 64));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + 32));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(src));
+    _mm256_store_si256((__m256i *)(dst + 96), a);
+    _mm256_store_si256((__m256i *)(dst + 64), b);
+    _mm256_store_si256((__m256i *)(dst + 32), c);
+    _mm256_store_si256((__m256i *)(dst), d);
+  }
+  _mm256_zeroupper();
+}
+
+AVX2_TARGET
+static void avx2_fill(uint8_t * dst, uint8_t value, size_t blocks, int stream)
+{
+  __m256i v = _mm256_set1_epi8((char)value);
+
+  if(stream)
+  {
+    while(blocks--)
+    {
+      _mm256_stream_si256((__m256i *)(dst), v);
+      _mm256_stream_si256((__m256i *)(dst + 32), v);
+      _mm256_stream_si256((__m256i *)(dst + 64), v);
+      _mm256_stream_si256((__m256i *)(dst + 96), v);
+      dst += 128;
+    }
+    _mm_sfence();
+  }
+  else
+  {
+    while(blocks--)
+    {
+      _mm256_store_si256((__m256i *)(dst), v);
+      _mm256_store_si256((__m256i *)(dst + 32), v);
+      _mm256_store_si256((__m256i *)(dst + 64), v);
+      _mm256_store_si256((__m256i *)(dst + 96), v);
+      dst += 128;
+    }
+  }
+  _mm256_zeroupper();
+}
+
+/* 33 to 64 bytes as two overlapping vectors, less through SSE2 */
+static inline __attribute__((__always_inline__)) AVX2_TARGET
+void avx2_copy_upto64(uint8_t * dst, const uint8_t * src, size_t length)
+{
+  if(length > 32)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + length - 32));
+    _mm256_storeu_si256((__m256i *)(dst), a);
+    _mm256_storeu_si256((__m256i *)(dst + length - 32), b);
+  }
+  else
+  {
+    sse2_copy_upto32(dst, src, length);
+  }
+}
+
+static inline __attribute__((__always_inline__)) AVX2_TARGET
+void avx2_fill_upto64(uint8_t * dst, uint8_t value, size_t length)
+{
+  if(length > 32)
+  {
+    __m256i v = _mm256_set1_epi8((char)value);
+    _mm256_storeu_si256((__m256i *)(dst), v);
+    _mm256_storeu_si256((__m256i *)(dst + length - 32), v);
+  }
+  else
+  {
+    sse2_fill_upto32(dst, value, length);
+  }
+}
+
+/* Up to 256 bytes, two blocks, as the first and last 128 */
+AVX2_TARGET
+static void avx2_copy_short(uint8_t * dst, const uint8_t * src,
+                            size_t length)
+{
+  if(length > 128)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + 64));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(src + 96));
+    __m256i e = _mm256_loadu_si256((const __m256i *)(src + length - 128));
+    __m256i f = _mm256_loadu_si256((const __m256i *)(src + length - 96));
+    __m256i g = _mm256_loadu_si256((const __m256i *)(src + length - 64));
+    __m256i h = _mm256_loadu_si256((const __m256i *)(src + length - 32));
+    _mm256_storeu_si256((__m256i *)(dst), a);
+    _mm256_storeu_si256((__m256i *)(dst + 32), b);
+    _mm256_storeu_si256((__m256i *)(dst + 64), c);
+    _mm256_storeu_si256((__m256i *)(dst + 96), d);
+    _mm256_storeu_si256((__m256i *)(dst + length - 128), e);
+    _mm256_storeu_si256((__m256i *)(dst + length - 96), f);
+    _mm256_storeu_si256((__m256i *)(dst + length - 64), g);
+    _mm256_storeu_si256((__m256i *)(dst + length - 32), h);
+  }
+  else if(length > 64)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + length - 64));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(src + length - 32));
+    _mm256_storeu_si256((__m256i *)(dst), a);
+    _mm256_storeu_si256((__m256i *)(dst + 32), b);
+    _mm256_storeu_si256((__m256i *)(dst + length - 64), c);
+    _mm256_storeu_si256((__m256i *)(dst + length - 32), d);
+  }
+  else
+  {
+    avx2_copy_upto64(dst, src, length);
+  }
+  _mm256_zeroupper();
+}
+
+AVX2_TARGET
+static void avx2_fill_short(uint8_t * dst, uint8_t value, size_t length)
+{
+  if(length > 64)
+  {
+    __m256i v = _mm256_set1_epi8((char)value);
+    _mm256_storeu_si256((__m256i *)(dst), v);
+    _mm256_storeu_si256((__m256i *)(dst + 32), v);
+    _mm256_storeu_si256((__m256i *)(dst + length - 64), v);
+    _mm256_storeu_si256((__m256i *)(dst + length - 32), v);
+    if(length > 128)
+    {
+      _mm256_storeu_si256((__m256i *)(dst + 64), v);
+      _mm256_storeu_si256((__m256i *)(dst + 96), v);
+      _mm256_storeu_si256((__m256i *)(dst + length - 128), v);
+      _mm256_storeu_si256((__m256i *)(dst + length - 96), v);
+    }
+  }
+  else
+  {
+    avx2_fill_upto64(dst, value, length);
+  }
+  _mm256_zeroupper();
+}
+
+/* Byte shuffle inside each 128-bit lane, then swap the two lanes */
+AVX2_TARGET
+static __m256i avx2_reverse_vec(__m256i v)
+{
+  const __m256i mask = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                        7, 6, 5, 4, 3, 2, 1, 0,
+                                        15, 14, 13, 12, 11, 10, 9, 8,
+                                        7, 6, 5, 4, 3, 2, 1, 0);
+
+  return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, mask),
+                                  _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+AVX2_TARGET
+static void avx2_reverse(uint8_t * left, uint8_t * right, size_t blocks)
+{
+  while(blocks--)
+  {
+    right -= 32;
+    __m256i a = _mm256_loadu_si256((const __m256i *)left);
+    __m256i b = _mm256_loadu_si256((const __m256i *)right);
+    _mm256_storeu_si256((__m256i *)left, avx2_reverse_vec(b));
+    _mm256_storeu_si256((__m256i *)right, avx2_reverse_vec(a));
+    left += 32;
+  }
+  _mm256_zeroupper();
+}
+
+AVX2_TARGET
+static void avx2_swap(uint8_t * dst, const uint8_t * src, size_t blocks,
+                      size_t width)
+{
+  const __m256i mask = _mm256_broadcastsi128_si256(
+      _mm_load_si128((const __m128i *)swap_masks[width >> 2]));
+
+  while(blocks--)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + 64));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(src + 96));
+    _mm256_storeu_si256((__m256i *)(dst), _mm256_shuffle_epi8(a, mask));
+    _mm256_storeu_si256((__m256i *)(dst + 32), _mm256_shuffle_epi8(b, mask));
+    _mm256_storeu_si256((__m256i *)(dst + 64), _mm256_shuffle_epi8(c, mask));
+    _mm256_storeu_si256((__m256i *)(dst + 96), _mm256_shuffle_epi8(d, mask));
+    src += 128;
+    dst += 128;
+  }
+  _mm256_zeroupper();
+}
+
+/*
+ * pshufb only moves bytes inside a 128-bit lane, so each block is two
+ * groups of 16 * channels bytes side by side, one per lane, and every
+ * output vector is the OR of one shuffle per input vector (see
+ * ilv_split_masks). Inlined per channel count so the loops unroll.
+ */
+static inline __attribute__((__always_inline__)) AVX2_TARGET
+void avx2_split(uint8_t * const * dst, const uint8_t * src, size_t blocks,
+                size_t channels, const uint8_t (*masks)[16])
+{
+  __m256i in[3], out;
+  size_t offset = 0, c, k;
+
+  while(blocks--)
+  {
+    for(k = 0; k < channels; k++)
+    {
+      in[k] = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+              _mm_loadu_si128((const __m128i *)(src + 16 * k))),
+          _mm_loadu_si128((const __m128i *)(src + 16 * (channels + k))), 1);
+    }
+    for(c = 0; c < channels; c++)
+    {
+      out = _mm256_setzero_si256();
+      for(k = 0; k < channels; k++)
+      {
+        out = _mm256_or_si256(out, _mm256_shuffle_epi8(in[k],
+                  _mm256_broadcastsi128_si256(_mm_load_si128(
+                      (const __m128i *)masks[c * channels + k]))));
+      }
+      _mm256_storeu_si256((__m256i *)(dst[c] + offset), out);
+    }
+    src += 32 * channels;
+    offset += 32;
+  }
+}
+
+static inline __attribute__((__always_inline__)) AVX2_TARGET
+void avx2_merge(uint8_t * dst, const uint8_t * const * src, size_t blocks,
+                size_t channels, const uint8_t (*masks)[16])
+{
+  __m256i in[3], out;
+  size_t offset = 0, c, k;
+
+  while(blocks--)
+  {
+    for(c = 0; c < channels; c++)
+    {
+      in[c] = _mm256_loadu_si256((const __m256i *)(src[c] + offset));
+    }
+    for(k = 0; k < channels; k++)
+    {
+      out = _mm256_setzero_si256();
+      for(c = 0; c < channels; c++)
+      {
+        out = _mm256_or_si256(out, _mm256_shuffle_epi8(in[c],
+                  _mm256_broadcastsi128_si256(_mm_load_si128(
+                      (const __m128i *)masks[k * channels + c]))));
+      }
+      _mm_storeu_si128((__m128i *)(dst + 16 * k),
+                       _mm256_castsi256_si128(out));
+      _mm_storeu_si128((__m128i *)(dst + 16 * (channels + k)),
+                       _mm256_extracti128_si256(out, 1));
+    }
+    dst += 32 * channels;
+    offset += 32;
+  }
+}
+
+/*
+ * Four channels take 16 shuffles per block this way, more than the two
+ * rounds of unpacks of the SSE2 kernels, so they are left to those.
+ */
+AVX2_TARGET
+static void avx2_deinterleave(uint8_t * const * dst, const uint8_t * src,
+                              size_t blocks, size_t channels, size_t width)
+{
+  if(channels == 2)
+  {
+    avx2_split(dst, src, blocks, 2, ilv_split_masks[0][width >> 1]);
+  }
+  else if(channels == 3)
+  {
+    avx2_split(dst, src, blocks, 3, ilv_split_masks[1][width >> 1]);
+  }
+  else
+  {
+    sse2_deinterleave(dst, src, blocks * 2, channels, width);
+  }
+  _mm256_zeroupper();
+}
+
+AVX2_TARGET
+static void avx2_interleave(uint8_t * dst, const uint8_t * const * src,
+                            size_t blocks, size_t channels, size_t width)
+{
+  if(channels == 2)
+  {
+    avx2_merge(dst, src, blocks, 2, ilv_merge_masks[0][width >> 1]);
+  }
+  else if(channels == 3)
+  {
+    avx2_merge(dst, src, blocks, 3, ilv_merge_masks[1][width >> 1]);
+  }
+  else
+  {
+    sse2_interleave(dst, src, blocks * 2, channels, width);
+  }
+  _mm256_zeroupper();
+}
+
+/***********************************************************
+ AVX-512 Kernels (64-byte vectors, 256-byte blocks)
+***********************************************************/
+AVX512_TARGET
+static void avx512_copy_fwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    __m512i a = _mm512_loadu_si512((const void *)(src));
+    __m512i b = _mm512_loadu_si512((const void *)(src + 64));
+    __m512i c = _mm512_loadu_si512((const void *)(src + 128));
+    __m512i d = _mm512_loadu_si512((const void *)(src + 192));
+    _mm512_store_si512((void *)(dst), a);
+    _mm512_store_si512((void *)(dst + 64), b);
+    _mm512_store_si512((void *)(dst + 128), c);
+    _mm512_store_si512((void *)(dst + 192), d);
+    src += 256;
+    dst += 256;
+  }
+  _mm256_zeroupper();
+}
+
+AVX512_TARGET
+static void avx512_copy_bwd(uint8_t * dst, const uint8_t * src, size_t blocks)
+{
+  while(blocks--)
+  {
+    src -= 256;
+    dst -= 256;
+    __m512i a = _mm512_loadu_si512((const void *)(src + 192));
+    __m512i b = _mm512_loadu_si512((const void *)(src + 128));
+    __m512i c = _mm512_loadu_si512((const void *)(src + 64));
+    __m512i d = _mm512_loadu_si512((const void *)(src));
+    _mm512_store_si512((void *)(dst + 192), a);
+    _mm512_store_si512((void *)(dst + 128), b);
+    _mm512_store_si512((void *)(dst + 64), c);
+    _mm512_store_si512((void *)(dst), d);
+  }
+  _mm256_zeroupper();
+}
+
+AVX512_TARGET
+static void avx512_fill(uint8_t * dst, uint8_t value, size_t blocks,
+                        int stream)
+{
+  __m512i v = _mm512_set1_epi8((char)value);
+
+  if(stream)
+  {
+    while(blocks--)
+    {
+      _mm512_stream_si512((void *)(dst), v);
+      _mm512_stream_si512((void *)(dst + 64), v);
+      _mm512_stream_si512((void *)(dst + 128), v);
+      _mm512_stream_si512((void *)(dst + 192), v);
+      dst += 256;
+    }
+    _mm_sfence();
+  }
+  else
+  {
+    while(blocks--)
+    {
+      _mm512_store_si512((void *)(dst), v);
+      _mm512_store_si512((void *)(dst + 64), v);
+      _mm512_store_si512((void *)(dst + 128), v);
+      _mm512_store_si512((void *)(dst + 192), v);
+      dst += 256;
+    }
+  }
+  _mm256_zeroupper();
+}
+
+/* Up to 512 bytes, two blocks, as the first and last 256 */
+AVX512_TARGET
+static void avx512_copy_short(uint8_t * dst, const uint8_t * src,
+                              size_t length)
+{
+  if(length > 256)
+  {
+    __m512i a = _mm512_loadu_si512((const void *)(src));
+    __m512i b = _mm512_loadu_si512((const void *)(src + 64));
+    __m512i c = _mm512_loadu_si512((const void *)(src + 128));
+    __m512i d = _mm512_loadu_si512((const void *)(src + 192));
+    __m512i e = _mm512_loadu_si512((const void *)(src + length - 256));
+    __m512i f = _mm512_loadu_si512((const void *)(src + length - 192));
+    __m512i g = _mm512_loadu_si512((const void *)(src + length - 128));
+    __m512i h = _mm512_loadu_si512((const void *)(src + length - 64));
+    _mm512_storeu_si512((void *)(dst), a);
+    _mm512_storeu_si512((void *)(dst + 64), b);
+    _mm512_storeu_si512((void *)(dst + 128), c);
+    _mm512_storeu_si512((void *)(dst + 192), d);
+    _mm512_storeu_si512((void *)(dst + length - 256), e);
+    _mm512_storeu_si512((void *)(dst + length - 192), f);
+    _mm512_storeu_si512((void *)(dst + length - 128), g);
+    _mm512_storeu_si512((void *)(dst + length - 64), h);
+  }
+  else if(length > 128)
+  {
+    __m512i a = _mm512_loadu_si512((const void *)(src));
+    __m512i b = _mm512_loadu_si512((const void *)(src + 64));
+    __m512i c = _mm512_loadu_si512((const void *)(src + length - 128));
+    __m512i d = _mm512_loadu_si512((const void *)(src + length - 64));
+    _mm512_storeu_si512((void *)(dst), a);
+    _mm512_storeu_si512((void *)(dst + 64), b);
+    _mm512_storeu_si512((void *)(dst + length - 128), c);
+    _mm512_storeu_si512((void *)(dst + length - 64), d);
+  }
+  else if(length > 64)
+  {
+    __m512i a = _mm512_loadu_si512((const void *)(src));
+    __m512i b = _mm512_loadu_si512((const void *)(src + length - 64));
+    _mm512_storeu_si512((void *)(dst), a);
+    _mm512_storeu_si512((void *)(dst + length - 64), b);
+  }
+  else
+  {
+    avx2_copy_upto64(dst, src, length);
+  }
+  _mm256_zeroupper();
+}
+
+AVX512_TARGET
+static void avx512_fill_short(uint8_t * dst, uint8_t value, size_t length)
+{
+  if(length > 64)
+  {
+    __m512i v = _mm512_set1_epi8((char)value);
+    _mm512_storeu_si512((void *)(dst), v);
+    _mm512_storeu_si512((void *)(dst + length - 64), v);
+    if(length > 128)
+    {
+      _mm512_storeu_si512((void *)(dst + 64), v);
+      _mm512_storeu_si512((void *)(dst + length - 128), v);
+    }
+    if(length > 256)
+    {
+      _mm512_storeu_si512((void *)(dst + 128), v);
+      _mm512_storeu_si512((void *)(dst + 192), v);
+      _mm512_storeu_si512((void *)(dst + length - 256), v);
+      _mm512_storeu_si512((void *)(dst + length - 192), v);
+    }
+  }
+  else
+  {
+    avx2_fill_upto64(dst, value, length);
+  }
+  _mm256_zeroupper();
+}
+
+/* Byte shuffle inside each 128-bit lane, then reverse the four lanes */
+AVX512_TARGET
+static __m512i avx512_reverse_vec(__m512i v)
+{
+  const __m512i mask = _mm512_broadcast_i32x4(
+      _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+
+  v = _mm512_shuffle_epi8(v, mask);
+
+  return _mm512_shuffle_i64x2(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+AVX512_TARGET
+static void avx512_reverse(uint8_t * left, uint8_t * right, size_t blocks)
+{
+  while(blocks--)
+  {
+    right -= 64;
+    __m512i a = _mm512_loadu_si512((const void *)left);
+    __m512i b = _mm512_loadu_si512((const void *)right);
+    _mm512_storeu_si512((void *)left, avx512_reverse_vec(b));
+    _mm512_storeu_si512((void *)right, avx512_reverse_vec(a));
+    left += 64;
+  }
+  _mm256_zeroupper();
+}
+
+AVX512_TARGET
+static void avx512_swap(uint8_t * dst, const uint8_t * src, size_t blocks,
+                        size_t width)
+{
+  const __m512i mask = _mm512_broadcast_i32x4(
+      _mm_load_si128((const __m128i *)swap_masks[width >> 2]));
+
+  while(blocks--)
+  {
+    __m512i a = _mm512_loadu_si512((const void *)(src));
+    __m512i b = _mm512_loadu_si512((const void *)(src + 64));
+    __m512i c = _mm512_loadu_si512((const void *)(src + 128));
+    __m512i d = _mm512_loadu_si512((const void *)(src + 192));
+    _mm512_storeu_si512((void *)(dst), _mm512_shuffle_epi8(a, mask));
+    _mm512_storeu_si512((void *)(dst + 64), _mm512_shuffle_epi8(b, mask));
+    _mm512_storeu_si512((void *)(dst + 128), _mm512_shuffle_epi8(c, mask));
+    _mm512_storeu_si512((void *)(dst + 192), _mm512_shuffle_epi8(d, mask));
+    src += 256;
+    dst += 256;
+  }
+  _mm256_zeroupper();
+}
+
+/***********************************************************
+ Scan Kernels (64-byte blocks)
+***********************************************************/
+/*
+ * Each block is reduced to a 64-bit mask with one bit per byte, so the
+ * hit offset is a single bit scan. The masks are only built once the
+ * combined compare says the block holds a hit.
+ */
+SSE2_TARGET
+static uint64_t sse2_eq_mask(const uint8_t * a, const uint8_t * b)
+{
+  uint64_t m0 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(a)),
+      _mm_loadu_si128((const __m128i *)(b))));
+  uint64_t m1 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(a + 16)),
+      _mm_loadu_si128((const __m128i *)(b + 16))));
+  uint64_t m2 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(a + 32)),
+      _mm_loadu_si128((const __m128i *)(b + 32))));
+  uint64_t m3 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(a + 48)),
+      _mm_loadu_si128((const __m128i *)(b + 48))));
+
+  return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+SSE2_TARGET
+static uint64_t sse2_value_mask(const uint8_t * src, __m128i v)
+{
+  uint64_t m0 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(src)), v));
+  uint64_t m1 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(src + 16)), v));
+  uint64_t m2 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(src + 32)), v));
+  uint64_t m3 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_loadu_si128((const __m128i *)(src + 48)), v));
+
+  return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+SSE2_TARGET
+static size_t sse2_mismatch(const uint8_t * a, const uint8_t * b,
+                            size_t blocks)
+{
+  uint64_t diff;
+  size_t offset;
+
+  for(offset = 0; blocks--; offset += 64)
+  {
+    diff = ~sse2_eq_mask(a + offset, b + offset);
+    if(diff)
+    {
+      return offset + __builtin_ctzll(diff);
+    }
+  }
+
+  return MEM_NOT_FOUND;
+}
+
+SSE2_TARGET
+static size_t sse2_find(const uint8_t * src, uint8_t value, size_t blocks)
+{
+  const __m128i v = _mm_set1_epi8((char)value);
+  uint64_t hits;
+  size_t offset;
+
+  for(offset = 0; blocks--; offset += 64)
+  {
+    hits = sse2_value_mask(src + offset, v);
+    if(hits)
+    {
+      return offset + __builtin_ctzll(hits);
+    }
+  }
+
+  return MEM_NOT_FOUND;
+}
+
+SSE2_TARGET
+static size_t sse2_find_last(const uint8_t * src, uint8_t value,
+                             size_t blocks)
+{
+  const __m128i v = _mm_set1_epi8((char)value);
+  size_t offset = blocks * 64;
+  uint64_t hits;
+
+  while(blocks--)
+  {
+    offset -= 64;
+    hits = sse2_value_mask(src + offset, v);
+    if(hits)
+    {
+      return offset + 63 - __builtin_clzll(hits);
+    }
+  }
+
+  return MEM_NOT_FOUND;
+}
+
+AVX2_TARGET
+static size_t avx2_mismatch(const uint8_t * a, const uint8_t * b,
+                            size_t blocks)
+{
+  uint64_t diff;
+  size_t offset;
+
+  for(offset = 0; blocks--; offset += 64)
+  {
+    __m256i e0 = _mm256_cmpeq_epi8(
+        _mm256_loadu_si256((const __m256i *)(a + offset)),
+        _mm256_loadu_si256((const __m256i *)(b + offset)));
+    __m256i e1 = _mm256_cmpeq_epi8(
+        _mm256_loadu_si256((const __m256i *)(a + offset + 32)),
+        _mm256_loadu_si256((const __m256i *)(b + offset + 32)));
+    if((uint32_t)_mm256_movemask_epi8(_mm256_and_si256(e0, e1)) !=
+       0xFFFFFFFFu)
+    {
+      diff = ~((uint64_t)(uint32_t)_mm256_movemask_epi8(e0) |
+               ((uint64_t)(uint32_t)_mm256_movemask_epi8(e1) << 32));
+      _mm256_zeroupper();
+      return offset + __builtin_ctzll(diff);
+    }
+  }
+  _mm256_zeroupper();
+
+  return MEM_NOT_FOUND;
+}
+
+AVX2_TARGET
+static uint64_t avx2_value_mask(const uint8_t * src, __m256i v)
+{
+  uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+      _mm256_loadu_si256((const __m256i *)(src)), v));
+  uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+      _mm256_loadu_si256((const __m256i *)(src + 32)), v));
+
+  return m0 | (m1 << 32);
+}
+
+AVX2_TARGET
+static size_t avx2_find(const uint8_t * src, uint8_t value, size_t blocks)
+{
+  const __m256i v = _mm256_set1_epi8((char)value);
+  uint64_t hits;
+  size_t offset;
+
+  for(offset = 0; blocks--; offset += 64)
+  {
+    hits = avx2_value_mask(src + offset, v);
+    if(hits)
+    {
+      _mm256_zeroupper();
+      return offset + __builtin_ctzll(hits);
+    }
+  }
+  _mm256_zeroupper();
+
+  return MEM_NOT_FOUND;
+}
+
+AVX2_TARGET
+static size_t avx2_find_last(const uint8_t * src, uint8_t value,
+                             size_t blocks)
+{
+  const __m256i v = _mm256_set1_epi8((char)value);
+  size_t offset = blocks * 64;
+  uint64_t hits;
+
+  while(blocks--)
+  {
+    offset -= 64;
+    hits = avx2_value_mask(src + offset, v);
+    if(hits)
+    {
+      _mm256_zeroupper();
+      return offset + 63 - __builtin_clzll(hits);
+    }
+  }
+  _mm256_zeroupper();
+
+  return MEM_NOT_FOUND;
+}
+
+/* AVX-512BW compares straight into a 64-bit mask register */
+AVX512_TARGET
+static size_t avx512_mismatch(const uint8_t * a, const uint8_t * b,
+                              size_t blocks)
+{
+  uint64_t diff;
+  size_t offset;
+
+  for(offset = 0; blocks--; offset += 64)
+  {
+    diff = _mm512_cmpneq_epi8_mask(
+        _mm512_loadu_si512((const void *)(a + offset)),
+        _mm512_loadu_si512((const void *)(b + offset)));
+    if(diff)
+    {
+      _mm256_zeroupper();
+      return offset + __builtin_ctzll(diff);
+    }
+  }
+  _mm256_zeroupper();
+
+  return MEM_NOT_FOUND;
+}
+
+AVX512_TARGET
+static size_t avx512_find(const uint8_t * src, uint8_t value, size_t blocks)
+{
+  const __m512i v = _mm512_set1_epi8((char)value);
+  uint64_t hits;
+  size_t offset;
+
+  for(offset = 0; blocks--; offset += 64)
+  {
+    hits = _mm512_cmpeq_epi8_mask(
+        _mm512_loadu_si512((const void *)(src + offset)), v);
+    if(hits)
+    {
+      _mm256_zeroupper();
+      return offset + __builtin_ctzll(hits);
+    }
+  }
+  _mm256_zeroupper();
+
+  return MEM_NOT_FOUND;
+}
+
+AVX512_TARGET
+static size_t avx512_find_last(const uint8_t * src, uint8_t value,
+                               size_t blocks)
+{
+  const __m512i v = _mm512_set1_epi8((char)value);
+  size_t offset = blocks * 64;
+  uint64_t hits;
+
+  while(blocks--)
+  {
+    offset -= 64;
+    hits = _mm512_cmpeq_epi8_mask(
+        _mm512_loadu_si512((const void *)(src + offset)), v);
+    if(hits)
+    {
+      _mm256_zeroupper();
+      return offset + 63 - __builtin_clzll(hits);
+    }
+  }
+  _mm256_zeroupper();
+
+  return MEM_NOT_FOUND;
+}
+
+/***********************************************************
+ Kernel Tables
+***********************************************************/
+const mem_kernels_t mem_kernels_sse2 =
+{
+  16, 64, 128, 16, 64, 16,
+  sse2_copy_fwd, sse2_copy_bwd, sse2_copy_short, sse2_fill, sse2_fill_short,
+  sse2_reverse, sse2_swap,
+  sse2_deinterleave, sse2_interleave,
+  sse2_mismatch, sse2_find, sse2_find_last
+};
+
+const mem_kernels_t mem_kernels_avx2 =
+{
+  32, 128, 256, 32, 64, 32,
+  avx2_copy_fwd, avx2_copy_bwd, avx2_copy_short, avx2_fill, avx2_fill_short,
+  avx2_reverse, avx2_swap,
+  avx2_deinterleave, avx2_interleave,
+  avx2_mismatch, avx2_find, avx2_find_last
+};
+
+/* The (de)interleave shuffles are lane bound, AVX2 ones serve here */
+const mem_kernels_t mem_kernels_avx512 =
+{
+  64, 256, 512, 64, 64, 32,
+  avx512_copy_fwd, avx512_copy_bwd, avx512_copy_short,
+  avx512_fill, avx512_fill_short, avx512_reverse, avx512_swap,
+  avx2_deinterleave, avx2_interleave,
+  avx512_mismatch, avx512_find, avx512_find_last
+};
+
+uint8_t mem_kernels_supported(const mem_kernels_t * kernels)
+{
+  __builtin_cpu_init();
+
+  if(kernels == &mem_kernels_avx512)
+  {
+    return (__builtin_cpu_supports("avx512f") != 0) &&
+           (__builtin_cpu_supports("avx512bw") != 0);
+  }
+  if(kernels == &mem_kernels_avx2)
+  {
+    return __builtin_cpu_supports("avx2") != 0;
+  }
+  if(kernels == &mem_kernels_sse2)
+  {
+    return __builtin_cpu_supports("sse2") != 0;
+  }
+
+  return 1;
+}
+
+#endif /* MEM_KERNELS_X86 */
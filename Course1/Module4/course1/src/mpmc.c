@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file mpmc.c
+ * @brief Bounded multi-producer/multi-consumer queue (HOST only)
+ *
+ * Cell i starts with sequence number i. A producer at position pos
+ * may fill the cell when its sequence equals pos: it claims pos with
+ * a CAS on enqueue_pos, copies the slot in and publishes pos + 1. A
+ * consumer at pos may empty the cell when the sequence equals
+ * pos + 1: it claims pos on dequeue_pos, copies the slot out and
+ * publishes pos + capacity, handing the cell to the producer of the
+ * next lap. A sequence behind the position means the queue is full
+ * (producer) or empty (consumer).
+ *
+ * @author Mahmoud Hamdy
+ * @date October 22 2020
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include "mpmc.h"
+#include "memory.h"
+
+#define MPMC_SEQ(q, pos) ((size_t *)((q)->cells + ((pos) & (q)->mask) * \
+                                     (q)->stride))
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+uint8_t mpmc_init(mpmc_queue_t * q, size_t capacity, size_t slot_size)
+{
+  void * cells;
+  size_t i;
+
+  if((capacity < 2) || (capacity > MPMC_MAX_CAPACITY) ||
+     (capacity & (capacity - 1)) ||
+     (slot_size > (size_t)-1 - sizeof(size_t) - MPMC_LINE))
+  {
+    return 0;
+  }
+
+  /* Cells take whole lines, so neighbouring cells never share one */
+  q->stride = (sizeof(size_t) + slot_size + MPMC_LINE - 1) &
+              ~(size_t)(MPMC_LINE - 1);
+  if((capacity > (size_t)-1 / q->stride) ||
+     (posix_memalign(&cells, MPMC_LINE, capacity * q->stride) != 0))
+  {
+    return 0;
+  }
+
+  q->cells = cells;
+  q->slot_size = slot_size;
+  q->mask = capacity - 1;
+  for(i = 0; i < capacity; i++)
+  {
+    *MPMC_SEQ(q, i) = i;
+  }
+  q->enqueue_pos = 0;
+  q->dequeue_pos = 0;
+
+  return 1;
+}
+
+void mpmc_destroy(mpmc_queue_t * q)
+{
+  free(q->cells);
+  q->cells = (uint8_t *)0;
+}
+
+uint8_t mpmc_push(mpmc_queue_t * q, uint8_t * src)
+{
+  size_t pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+  size_t * seq;
+  intptr_t dif;
+
+  for(;;)
+  {
+    seq = MPMC_SEQ(q, pos);
+    dif = (intptr_t)__atomic_load_n(seq, __ATOMIC_ACQUIRE) - (intptr_t)pos;
+    if(dif == 0)
+    {
+      if(__atomic_compare_exchange_n(&q->enqueue_pos, &pos, pos + 1, 1,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else if(dif < 0)
+    {
+      return 0;
+    }
+    else
+    {
+      pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  my_memcopy(src, (uint8_t *)(seq + 1), q->slot_size);
+  __atomic_store_n(seq, pos + 1, __ATOMIC_RELEASE);
+
+  return 1;
+}
+
+uint8_t mpmc_pop(mpmc_queue_t * q, uint8_t * dst)
+{
+  size_t pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+  size_t * seq;
+  intptr_t dif;
+
+  for(;;)
+  {
+    seq = MPMC_SEQ(q, pos);
+    dif = (intptr_t)__atomic_load_n(seq, __ATOMIC_ACQUIRE) -
+          (intptr_t)(pos + 1);
+    if(dif == 0)
+    {
+      if(__atomic_compare_exchange_n(&q->dequeue_pos, &pos, pos + 1, 1,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else if(dif < 0)
+    {
+      return 0;
+    }
+    else
+    {
+      pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  my_memcopy((uint8_t *)(seq + 1), dst, q->slot_size);
+  __atomic_store_n(seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+
+  return 1;
+}
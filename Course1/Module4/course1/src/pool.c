@@ -0,0 +1,128 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file pool.c
+ * @brief Fixed-block pool allocator used behind reserve_words
+ *
+ * The static region is split into POOL_CLASS_COUNT consecutive areas,
+ * class c holding POOL_BLOCKS_PER_CLASS blocks of POOL_MIN_BLOCK_W << c
+ * words. Blocks are handed out from a free list first, then from the
+ * part of the area that was never used, so no setup pass is needed.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 12 2020
+ *
+ */
+#include "pool.h"
+
+/* Words taken by all blocks of the smallest class */
+#define POOL_UNIT_W   (POOL_BLOCKS_PER_CLASS * POOL_MIN_BLOCK_W)
+
+/* Class c starts at POOL_UNIT_W * (2^c - 1) words into the region */
+#define POOL_REGION_W (POOL_UNIT_W * ((1u << POOL_CLASS_COUNT) - 1))
+
+typedef struct pool_block
+{
+  struct pool_block * next;
+} pool_block_t;
+
+typedef struct
+{
+  pool_block_t * free_list;
+  uint32_t untouched;
+} pool_class_t;
+
+/*
+ * Class c starts at a multiple of its block size as long as every
+ * class but the last holds a multiple of 2^(POOL_CLASS_COUNT - 1)
+ * blocks, so with the region aligned to the largest block every block
+ * is aligned to its own size.
+ */
+#if (POOL_BLOCKS_PER_CLASS % (1u << (POOL_CLASS_COUNT - 1))) != 0
+#error "POOL_BLOCKS_PER_CLASS must be a multiple of 2^(POOL_CLASS_COUNT-1)"
+#endif
+
+static int32_t pool_region[POOL_REGION_W]
+  __attribute__((__aligned__(POOL_MAX_BLOCK_W * sizeof(int32_t))));
+static pool_class_t pool_classes[POOL_CLASS_COUNT];
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int32_t * pool_reserve(size_t length)
+{
+  pool_class_t * cls;
+  pool_block_t * block;
+  uint32_t c;
+
+  if((length == 0) || (length > POOL_MAX_BLOCK_W))
+  {
+    return (int32_t *)0;
+  }
+
+  /* Smallest c with length <= POOL_MIN_BLOCK_W << c */
+  c = (length <= POOL_MIN_BLOCK_W) ? 0 :
+      32 - __builtin_clz((uint32_t)((length - 1) / POOL_MIN_BLOCK_W));
+  cls = &pool_classes[c];
+
+  block = cls->free_list;
+  if(block)
+  {
+    cls->free_list = block->next;
+    return (int32_t *)block;
+  }
+
+  if(cls->untouched < POOL_BLOCKS_PER_CLASS)
+  {
+    return &pool_region[POOL_UNIT_W * ((1u << c) - 1) +
+                        cls->untouched++ * (POOL_MIN_BLOCK_W << c)];
+  }
+
+  return (int32_t *)0;
+}
+
+int32_t * pool_reserve_aligned(size_t length, size_t align)
+{
+  size_t align_w = align / sizeof(int32_t);
+
+  if(align & (align - 1))
+  {
+    return (int32_t *)0;
+  }
+
+  return pool_reserve((length > align_w) ? length : align_w);
+}
+
+/* Size class of a block, from its offset into the region */
+static uint32_t pool_class_of(const int32_t * src)
+{
+  size_t offset = (size_t)(src - pool_region);
+
+  return 31 - __builtin_clz((uint32_t)(offset / POOL_UNIT_W + 1));
+}
+
+void pool_release(int32_t * src)
+{
+  uint32_t c = pool_class_of(src);
+  pool_block_t * block = (pool_block_t *)src;
+
+  block->next = pool_classes[c].free_list;
+  pool_classes[c].free_list = block;
+}
+
+uint8_t pool_owns(const int32_t * src)
+{
+  return (src >= pool_region) && (src < pool_region + POOL_REGION_W);
+}
+
+size_t pool_block_words(const int32_t * src)
+{
+  return (size_t)POOL_MIN_BLOCK_W << pool_class_of(src);
+}
@@ -0,0 +1,156 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file ringbuf.c
+ * @brief Lock-free single-producer/single-consumer byte ring buffer
+ *
+ * Each side keeps a copy of the other side's index and only reloads
+ * it (with acquire) when the copy says the ring is full or empty, so
+ * the shared cache line is touched once per batch rather than once
+ * per byte.
+ *
+ * The GCC __atomic builtins give the ordering on both platforms: on
+ * the M4 they become plain LDR/STR with a DMB on the acquire/release
+ * side. No LDREX/STREX is needed because no index has two writers.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 21 2020
+ *
+ */
+#include "ringbuf.h"
+#include "memory.h"
+
+#define RINGBUF_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RINGBUF_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+uint8_t ringbuf_init(ringbuf_t * rb, uint8_t * buffer, size_t size)
+{
+  if(!buffer || (size == 0) || (size & (size - 1)))
+  {
+    return 0;
+  }
+
+  rb->buffer = buffer;
+  rb->mask = size - 1;
+  rb->tail = rb->head_cache = 0;
+  rb->head = rb->tail_cache = 0;
+
+  return 1;
+}
+
+uint8_t ringbuf_push(ringbuf_t * rb, uint8_t value)
+{
+  size_t head = rb->head;
+
+  if(head - rb->tail_cache > rb->mask)
+  {
+    rb->tail_cache = RINGBUF_LOAD(&rb->tail);
+    if(head - rb->tail_cache > rb->mask)
+    {
+      return 0;
+    }
+  }
+
+  rb->buffer[head & rb->mask] = value;
+  RINGBUF_STORE(&rb->head, head + 1);
+
+  return 1;
+}
+
+uint8_t ringbuf_pop(ringbuf_t * rb, uint8_t * value)
+{
+  size_t tail = rb->tail;
+
+  if(tail == rb->head_cache)
+  {
+    rb->head_cache = RINGBUF_LOAD(&rb->head);
+    if(tail == rb->head_cache)
+    {
+      return 0;
+    }
+  }
+
+  *value = rb->buffer[tail & rb->mask];
+  RINGBUF_STORE(&rb->tail, tail + 1);
+
+  return 1;
+}
+
+size_t ringbuf_write(ringbuf_t * rb, uint8_t * src, size_t length)
+{
+  size_t head = rb->head;
+  size_t offset = head & rb->mask;
+  size_t space = rb->mask + 1 - (head - rb->tail_cache);
+  size_t first;
+
+  if(space < length)
+  {
+    rb->tail_cache = RINGBUF_LOAD(&rb->tail);
+    space = rb->mask + 1 - (head - rb->tail_cache);
+    if(space < length)
+    {
+      length = space;
+    }
+  }
+
+  /* Up to the end of the buffer, then the rest from its start */
+  first = rb->mask + 1 - offset;
+  if(first > length)
+  {
+    first = length;
+  }
+  my_memcopy(src, rb->buffer + offset, first);
+  my_memcopy(src + first, rb->buffer, length - first);
+  RINGBUF_STORE(&rb->head, head + length);
+
+  return length;
+}
+
+size_t ringbuf_read(ringbuf_t * rb, uint8_t * dst, size_t length)
+{
+  size_t tail = rb->tail;
+  size_t offset = tail & rb->mask;
+  size_t count = rb->head_cache - tail;
+  size_t first;
+
+  if(count < length)
+  {
+    rb->head_cache = RINGBUF_LOAD(&rb->head);
+    count = rb->head_cache - tail;
+    if(count < length)
+    {
+      length = count;
+    }
+  }
+
+  first = rb->mask + 1 - offset;
+  if(first > length)
+  {
+    first = length;
+  }
+  my_memcopy(rb->buffer + offset, dst, first);
+  my_memcopy(rb->buffer, dst + first, length - first);
+  RINGBUF_STORE(&rb->tail, tail + length);
+
+  return length;
+}
+
+size_t ringbuf_count(ringbuf_t * rb)
+{
+  return RINGBUF_LOAD(&rb->head) - RINGBUF_LOAD(&rb->tail);
+}
+
+size_t ringbuf_space(ringbuf_t * rb)
+{
+  return rb->mask + 1 - ringbuf_count(rb);
+}
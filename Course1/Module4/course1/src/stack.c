@@ -0,0 +1,200 @@
+/******************************************************************************
+ * Copyright (C) 2020 by Mahmoud Hamdy
+ * 
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are 
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Mahmoud Hamdy is not liable for any misuse of this material.
+ * 
+ *****************************************************************************/
+/**
+ * @file stack.c
+ * @brief Stack high-water mark measurement by painting
+ *
+ * Painting goes through my_memset, so it runs at the speed of the
+ * fastest fill kernel. The scan reads whole words from the bottom, as
+ * the pattern survives longest at the far end of the stack.
+ *
+ * @author Mahmoud Hamdy
+ * @date October 26 2020
+ *
+ */
+#if defined(HOST)
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <limits.h>
+#endif
+
+#include "stack.h"
+#include "memory.h"
+
+/* STACK_PAINT_BYTE in every byte of a word */
+#define STACK_PAINT_WORD ((uintptr_t)-1 / 0xFF * STACK_PAINT_BYTE)
+
+#if defined(MSP432)
+/* Start of the .stack section, see msp432p401r.lds */
+extern uint32_t __stack;
+
+/* Entry 0 holds the initial stack pointer, see startup_msp432p401r_gcc.c */
+extern void (* const interruptVectors[])(void);
+
+/* Heap break of nosys.specs; the .heap section is empty, malloc grows up */
+extern void * _sbrk(ptrdiff_t incr);
+
+/* From the current heap break, or .stack if above it, to the initial sp */
+static void stack_main_region(stack_region_t * region)
+{
+  uintptr_t bottom = (uintptr_t)&__stack;
+  uintptr_t brk = (uintptr_t)_sbrk(0);
+
+  if(brk > bottom)
+  {
+    bottom = brk;
+  }
+  bottom = (bottom + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+
+  region->bottom = (uint8_t *)bottom;
+  region->top = (uint8_t *)(uintptr_t)interruptVectors[0];
+}
+#endif
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void stack_region_paint(const stack_region_t * region, const uint8_t * sp)
+{
+  uintptr_t end = (uintptr_t)sp;
+
+  if(end > (uintptr_t)region->top)
+  {
+    end = (uintptr_t)region->top;
+  }
+  if(end != (uintptr_t)region->top)
+  {
+    end -= STACK_PAINT_GUARD;
+  }
+
+  if(end > (uintptr_t)region->bottom)
+  {
+    my_memset(region->bottom, end - (uintptr_t)region->bottom,
+              STACK_PAINT_BYTE);
+  }
+}
+
+size_t stack_region_used(const stack_region_t * region)
+{
+  const uintptr_t * word;
+  const uint8_t * byte = region->bottom;
+
+  if(byte >= region->top)
+  {
+    return 0;
+  }
+
+  /* Bytes up to the first word boundary, then whole words */
+  while(((uintptr_t)byte & (sizeof(uintptr_t) - 1)) &&
+        (byte < region->top) && (*byte == STACK_PAINT_BYTE))
+  {
+    byte++;
+  }
+  if(!((uintptr_t)byte & (sizeof(uintptr_t) - 1)))
+  {
+    word = (const uintptr_t *)byte;
+    while(((const uint8_t *)(word + 1) <= region->top) &&
+          (*word == STACK_PAINT_WORD))
+    {
+      word++;
+    }
+    byte = (const uint8_t *)word;
+  }
+  while((byte < region->top) && (*byte == STACK_PAINT_BYTE))
+  {
+    byte++;
+  }
+
+  return (size_t)(region->top - byte);
+}
+
+#if defined(MSP432)
+void stack_paint(void)
+{
+  stack_region_t region;
+
+  stack_main_region(&region);
+  stack_region_paint(&region, __builtin_frame_address(0));
+}
+
+size_t stack_high_water(void)
+{
+  stack_region_t region;
+
+  stack_main_region(&region);
+  return stack_region_used(&region);
+}
+
+size_t stack_size(void)
+{
+  stack_region_t region;
+
+  stack_main_region(&region);
+  return (region.top > region.bottom) ?
+         (size_t)(region.top - region.bottom) : 0;
+}
+#endif
+
+#if defined(HOST)
+typedef struct
+{
+  void (*fn)(void *);
+  void * arg;
+  uint8_t * entry;  /* Frame address of the caller of fn */
+} stack_job_t;
+
+static void * stack_thread(void * arg)
+{
+  stack_job_t * job = arg;
+
+  job->entry = __builtin_frame_address(0);
+  job->fn(job->arg);
+
+  return NULL;
+}
+
+size_t stack_measure(void (*fn)(void *), void * arg, size_t size)
+{
+  stack_job_t job = { fn, arg, (uint8_t *)0 };
+  stack_region_t region;
+  pthread_attr_t attr;
+  pthread_t thread;
+  size_t used = 0;
+  uint8_t * stack;
+
+  if(size < PTHREAD_STACK_MIN)
+  {
+    size = PTHREAD_STACK_MIN;
+  }
+  stack = reserve_aligned(size, 4096, MEM_ALIGNED_DEFAULT);
+  if(!stack)
+  {
+    return 0;
+  }
+  region.bottom = stack;
+  region.top = stack + size;
+  stack_region_paint(&region, region.top);
+
+  if(!pthread_attr_init(&attr))
+  {
+    if(!pthread_attr_setstack(&attr, stack, size) &&
+       !pthread_create(&thread, &attr, stack_thread, &job))
+    {
+      pthread_join(thread, NULL);
+      region.top = job.entry;
+      used = stack_region_used(&region);
+    }
+    pthread_attr_destroy(&attr);
+  }
+  free_aligned(stack);
+
+  return used;
+}
+#endif